@@ -21,6 +21,18 @@
 #include <tigcclib.h>
 #include "header.h"
 
+// Where each character's frames start in its tl_charx file's sprites (8 characters per file). Written into
+// each file's FOFS chunk, so the game no longer needs its own copy of this table.
+static const unsigned short frameOffsets[3][CHARS_PER_FILE] = {
+	{ 0, 1794, 3588, 5796, 7728, 9660, 11799, 13524 },
+	{ 0, 2208, 4416, 5934, 7383, 9039, 10419, 12213 },
+	{ 0, 1242, 2760, 4554, 6141, 7659, 9384, 10902 }
+};
+
+static unsigned short packChecksum(const unsigned char* data, unsigned short length);
+static BOOL repackFile(const char* name, unsigned long id, const unsigned short* offsets);
+static BOOL checkEpisodes(const EPISODE* episodes);
+
 void _main() {
 	const EXTRA_EXTERNAL extext = { // must be const or will have memory errors
 		{
@@ -743,55 +755,17 @@ void _main() {
 		#endif
 		},
 		
-		{ // Tournament mode bracket
-		{25,27,27,27,25,25,25,25,25,25,25,25,25},
-		{25,26,26,28,27,27,27,25,25,25,25,25,25}, // this is the default, not filled with any characters
-		{25,27,27,29,26,26,28,25,25,25,25,25,25},
-		{25,26,26,26,25,25,30,27,27,27,25,25,25},
-		{25,27,27,27,25,25,30,26,26,28,25,25,25},
-		{25,26,26,28,27,27,29,25,25,30,25,25,25},
-		{25,27,27,29,26,26,26,25,25,30,25,25,25},
-		{25,26,26,26,25,25,25,25,25,30,27,27,27},
-		{25,27,27,27,25,25,25,25,25,30,26,26,28},
-		{25,26,26,28,27,27,27,25,25,30,25,25,30},
-		{25,27,27,29,26,26,28,25,25,30,25,25,30},
-		{25,26,26,26,25,25,30,27,27,29,25,25,30},
-		{25,27,27,27,25,25,30,26,26,26,25,25,30},
-		{25,26,26,28,27,27,29,25,25,25,25,25,30},
-		{25,27,27,29,26,26,26,25,25,25,25,25,30},
-		{25,26,26,26,25,25,25,25,25,25,25,25,30},
-		{25,27,27,27,25,25,25,25,25,25,25,25,30},
-		{25,26,26,28,27,27,27,25,25,25,25,25,30},
-		{25,27,27,29,26,26,28,25,25,25,25,25,30},
-		{25,26,26,26,25,25,30,27,27,27,25,25,30},
-		{25,27,27,27,25,25,30,26,26,28,25,25,30},
-		{25,26,26,28,27,27,29,25,25,30,25,25,30},
-		{25,27,27,29,26,26,26,25,25,30,25,25,30},
-		{25,26,26,26,25,25,25,25,25,30,27,27,29},
-		{25,27,27,27,25,25,25,25,25,30,26,26,26},
-		{25,26,26,28,27,27,27,25,25,30,25,25,25},
-		{25,27,27,29,26,26,28,25,25,30,25,25,25},
-		{25,26,26,26,25,25,30,27,27,29,25,25,25},
-		{25,27,27,27,25,25,30,26,26,26,25,25,25},
-		{25,26,26,28,27,27,29,25,25,25,25,25,25},
-		{25,27,27,29,26,26,26,25,25,25,25,25,25},
-		{25,26,26,26,25,25,25,25,25,25,25,25,25},
-		{25,25,25,25,25,25,25,25,25,25,25,25,25},
-		{25,25,25,25,25,25,25,25,25,25,25,25,25},
-		{25,25,25,25,25,25,25,25,25,25,25,25,25},
-		},
-		
 		// Episodes data
 		{
 		{ 2,2,0,0,2,MARIO,BOWSER,0,0,BATTLEFIELD,CLASSIC+4 }, //0*
 		{ 3,3,3,3,4,C_FALCON,ZELDA,SAMUS,PEACH,BIG_BLUE,CLASSIC+4 }, //1*
 		{ 3,3,3,0,3,SONIC,MARIO,LUIGI,0,REATEN_BASE,CLASSIC+4 }, //2*
 		{ 2,2,2,2,4,SAMUS,SAMUS,SAMUS,SAMUS,BRINSTAR,CLASSIC+4 }, //3*
-		{ 2,1,1,1,4,FOX,WARIO,YOSHI,SONIC,CORNERIA,CLASSIC }, //4*
+		{ 2,1,1,1,4,FOX,WARIO,YOSHI,SONIC,CORNERIA,CLASSIC, {{RULE_TICKS_PAST,DO_END_EPISODE,0,1000}}, COUNTER_TICKS }, //4*
 		{ 3,3,3,0,3,LINK,ZELDA,GANONDORF,0,HYRULE,CLASSIC }, //5*
 		{ 1,1,1,1,4,PEACH,LINK,BOWSER,GANONDORF,ANTAIRA_VILLAGE,CLASSIC }, //6*
 		{ 2,2,2,2,4,WARIO,DR_MARIO,MARIO,LUIGI,GLASS_SUBMARINE,CLASSIC }, //7*
-		{ 4,1,1,1,4,SELECT,MARIO,MARIO,MARIO,BATTLEFIELD,CLASSIC*20 }, //8* // maybe change to <<4 - try that  ///
+		{ 4,1,1,1,4,SELECT,MARIO,MARIO,MARIO,BATTLEFIELD,CLASSIC*20, {{RULE_OPPONENT_DOWN,DO_RESPAWN,MARIO,0},{RULE_DEFEATED_PAST,DO_WIN_EPISODE,0,127}}, COUNTER_ENEMIES_LEFT }, //8* // maybe change to <<4 - try that  ///
 		{ 1,1,1,0,3,SELECT,BOWSER,BOWSER,0,CORE_MONUMENT,ADMIRAL }, //9*
 		{ 5,5,5,0,3,MARIO,YOSHI,LUIGI,0,YOSHIS_ISLAND,ADMIRAL }, //10*
 		{ 5,4,3,3,4,LINK,GANONDORF,BOWSER,WARIO,GREAT_BAY,ADMIRAL }, //11*
@@ -799,21 +773,22 @@ void _main() {
 		{ 2,2,2,0,3,LUIGI,DR_MARIO,PEACH,0,ERA_TOWER,ADMIRAL }, //13*
 		{ 4,4,4,4,4,ROY,METAKNIGHT,LINK,MARTH,SOUL_TOWER,ADMIRAL }, //14*
 		{ 3,3,3,3,4,PEACH,MARIO,LUIGI,WARIO,CAIDRUS_CATHEDRAL,ADMIRAL }, //15*
-		{ 1,1,0,0,2,SELECT,SAMUS,0,0,FOURSIDE,ADMIRAL }, //16*
+		{ 1,1,0,0,2,SELECT,SAMUS,0,0,FOURSIDE,ADMIRAL, {{RULE_OPPONENT_DOWN,DO_RESPAWN,SAME_CHARACTER,0},{RULE_DEFEATED_PAST,DO_WIN_EPISODE,0,4},
+			{RULE_DEFEATED,DO_SWAP_OPPONENT,KIRBY,1},{RULE_DEFEATED,DO_SWAP_OPPONENT,FOX,2},{RULE_DEFEATED,DO_SWAP_OPPONENT,C_FALCON,3},{RULE_DEFEATED,DO_SWAP_OPPONENT,FALCO,4}} }, //16*
 		{ 3,4,0,0,2,SELECT,SONIC,0,0,INFINITE_GLACIER,PREMIERE }, //17*
 		{ 3,3,3,0,3,LUIGI,KING_BOO,KING_BOO,0,BATTLEFIELD,PREMIERE }, //18*
 		{ 5,5,0,0,2,MARTH,ROY,0,0,FINAL_DESTINATION,PREMIERE }, //19*
 		{ 3,2,3,2,4,KIRBY,METAKNIGHT,KING_BOO,BOWSER,DREAMLAND,PREMIERE }, //20*
 		{ 3,2,3,3,4,MR_GAMENWATCH,MARIO,LINK,KIRBY,FLATZONE,PREMIERE }, //21*
 		{ 5,5,5,5,4,SELECT,SAMUS,AXION,LINK,REATEN_BASE,PREMIERE }, //22*
-		{ 1,1,1,0,3,FALCO,FOX,C_FALCON,0,BIG_BLUE,PREMIERE }, //23*
+		{ 1,1,1,0,3,FALCO,FOX,C_FALCON,0,BIG_BLUE,PREMIERE, {{RULE_TICKS_PAST,DO_END_EPISODE,0,400}}, COUNTER_TICKS }, //23*
 		{ 3,3,3,3,4,YOSHI,DON_DORADO,MR_GAMENWATCH,KIRBY,ANTAIRA_VILLAGE,PREMIERE }, //24*
 		{ 3,2,2,2,4,MARIO,WARIO,BOWSER,KING_BOO,RED_SKY_BAY,ELITE+1 }, //25*
 		{ 2,2,2,2,4,SELECT,SAMUS,AXION,LINK,FINAL_DESTINATION,ELITE }, //26*
 		{ 3,3,3,3,4,AZZURRO,ROY,MARTH,METAKNIGHT,MARKED_MOSQUE,ELITE }, //27*
 		{ 5,5,5,0,3,SONIC,MR_GAMENWATCH,BOWSER,0,CRASPHONE_CITY,ELITE }, //28*
 		{ 1,0,0,0,1,SELECT,0,0,0,FINAL_DESTINATION,ELITE }, //29* - note: need to change description to only two hands now
-		{ 3,3,3,3,4,MARIO,DON_DORADO,KING_BOO,KING_BOO,ANTAIRA_VILLAGE,ELITE }, //30* - used to be 5 lives for Don Dorado
+		{ 3,3,3,3,4,MARIO,DON_DORADO,KING_BOO,KING_BOO,ANTAIRA_VILLAGE,ELITE, {{RULE_EVERY_TICKS,DO_TOGGLE_CLOAK,0,255}} }, //30* - used to be 5 lives for Don Dorado
 		},
 		
 		// Invitationals data
@@ -867,7 +842,17 @@ void _main() {
 		},
 	};	
 	
+	if (!checkEpisodes(extext.episodes)) {
+		ST_helpMsg("Episode counter has no RULE_DEFEATED_PAST");
+		return;
+	}
+	
+	PACK_HEADER pack = { PACK_MAGIC, PACK_VERSION, 1 };
+	PACK_CHUNK chunk = { CHUNK_EXTRA, sizeof(PACK_HEADER) + sizeof(PACK_CHUNK), sizeof(EXTRA_EXTERNAL), packChecksum((const unsigned char*)&extext, sizeof(EXTRA_EXTERNAL)) };
+	
 	FILE* out = fopen("tl_extra","wb"); // create new null-terminated file from instantiated data above
+	fwrite(&pack, sizeof(PACK_HEADER), 1, out); // a pack with the one EXTR chunk
+	fwrite(&chunk, sizeof(PACK_CHUNK), 1, out);
 	fwrite(&extext, sizeof(EXTRA_EXTERNAL), 1, out);	
 	fputc(0,out);
 	fputs("data",out);
@@ -875,7 +860,113 @@ void _main() {
 	fputc(OTH_TAG,out); // special tag needed for writing beyond 64K limit
 	fclose(out);
 	
+	// the sprite and stage files are not built here, but older copies of them are wrapped into packs as well
+	if (!repackFile("tl_stage", CHUNK_STAGES, NULL) || !repackFile("tl_char1", CHUNK_SPRITES, frameOffsets[0]) || !repackFile("tl_char2", CHUNK_SPRITES, frameOffsets[1]) || !repackFile("tl_char3", CHUNK_SPRITES, frameOffsets[2])) {
+		ST_helpMsg("tl_extra written; tl_stage/tl_charx not packed");
+		return;
+	}
+	
 	ST_helpMsg("Write successful"); // output to TI console about success of the write
 }
 
+// Fletcher-style sum of a chunk (must match the game's)
+static unsigned short packChecksum(const unsigned char* data, unsigned short length) {
+	unsigned char a = 0, b = 0;
+	
+	while (length--) {
+		a += *data++;
+		b += a;
+	}
+	return ((unsigned short)b << 8) | a;
+}
+
+// Every episode that counts enemies down needs a RULE_DEFEATED_PAST rule to count down to (the game looks for it)
+static BOOL checkEpisodes(const EPISODE* episodes) {
+	unsigned short i, r;
+	
+	for (i = 0; i < NUM_EPISODES; i++) {
+		if (episodes[i].counter == COUNTER_ENEMIES_LEFT) {
+			for (r = 0; r < MAX_EPISODE_RULES && episodes[i].rules[r].trigger != RULE_END && episodes[i].rules[r].trigger != RULE_DEFEATED_PAST; r++);
+			if (r == MAX_EPISODE_RULES || episodes[i].rules[r].trigger != RULE_DEFEATED_PAST) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+// Wraps a data file of the old raw layout into a pack in place: header and table of contents first, then the frame
+// offsets (tl_charx files only), then the original data as chunk id. Packs from an older version only get their
+// version brought up to date, as long as none of their chunks is one that has changed since (only EXTR has, and
+// tl_extra is written fresh above); a pack that holds one is refused, to be replaced rather than read wrongly.
+static BOOL repackFile(const char* name, unsigned long id, const unsigned short* offsets) {
+	SYM_ENTRY* sym = SymFindPtr(SYMSTR(name), 0);
+	unsigned char *base, *tail;
+	unsigned short size, dataLength, headerLength, numChunks = (offsets != NULL) ? 2 : 1, i;
+	PACK_HEADER* pack;
+	PACK_CHUNK* chunk;
+	
+	if (sym == NULL) {
+		return FALSE;
+	}
+	if (sym->flags.bits.archived) {
+		EM_moveSymFromExtMem(SYMSTR(name), HS_NULL);
+		sym = SymFindPtr(SYMSTR(name), 0);
+	}
+	
+	base = HeapDeref(sym->handle);
+	size = *(unsigned short*)base;
+	pack = (PACK_HEADER*)(base + 2);
+	if (size >= sizeof(PACK_HEADER) && pack->magic == PACK_MAGIC) { // already a pack
+		if (sizeof(PACK_HEADER) + (unsigned long)pack->numChunks * sizeof(PACK_CHUNK) > size) {
+			return FALSE; // damaged
+		}
+		if (pack->version != PACK_VERSION) {
+			for (i = 0; i < pack->numChunks; i++) {
+				if (pack->toc[i].id == CHUNK_EXTRA) {
+					return FALSE; // an EXTRA_EXTERNAL of an older layout
+				}
+			}
+			pack->version = PACK_VERSION;
+		}
+		return TRUE;
+	}
+	
+	tail = base + 2 + size - 3; // the file ends with 0, the custom extension, 0 and OTH_TAG
+	while (*tail) {
+		tail--;
+	}
+	dataLength = tail - (base + 2);
+	
+	headerLength = sizeof(PACK_HEADER) + numChunks * sizeof(PACK_CHUNK) + ((offsets != NULL) ? sizeof(frameOffsets[0]) : 0);
+	if ((unsigned long)size + headerLength > 65518 || HeapRealloc(sym->handle, size + headerLength + 2) == H_NULL) {
+		return FALSE; // no room to grow it
+	}
+	
+	base = HeapDeref(sym->handle); // may have moved
+	memmove(base + 2 + headerLength, base + 2, size);
+	*(unsigned short*)base = size + headerLength;
+	
+	pack = (PACK_HEADER*)(base + 2);
+	pack->magic = PACK_MAGIC;
+	pack->version = PACK_VERSION;
+	pack->numChunks = numChunks;
+	chunk = pack->toc;
+	
+	if (offsets != NULL) {
+		chunk->id = CHUNK_FRAME_OFFSETS;
+		chunk->offset = sizeof(PACK_HEADER) + numChunks * sizeof(PACK_CHUNK);
+		chunk->length = sizeof(frameOffsets[0]);
+		memcpy((unsigned char*)pack + chunk->offset, offsets, chunk->length);
+		chunk->checksum = packChecksum((unsigned char*)pack + chunk->offset, chunk->length);
+		chunk++;
+	}
+	
+	chunk->id = id;
+	chunk->offset = headerLength;
+	chunk->length = dataLength;
+	chunk->checksum = packChecksum((unsigned char*)pack + headerLength, dataLength);
+	return TRUE;
+}
+
 // End of Source File
\ No newline at end of file
@@ -275,6 +275,36 @@ typedef enum {
 
 // Game Data Structures
 
+// Episode rules: checked in order every tick of the episode, each one runs its action when its trigger holds.
+// A RULE_END trigger ends the list.
+#define MAX_EPISODE_RULES   6
+
+#define RULE_END            0
+#define RULE_TICKS_PAST     1 // ticks > value
+#define RULE_EVERY_TICKS    2 // (ticks & value) == 0
+#define RULE_OPPONENT_DOWN  3 // runs the action on every opponent that is out
+#define RULE_DEFEATED       4 // enemies defeated == value
+#define RULE_DEFEATED_PAST  5 // enemies defeated > value
+
+#define DO_END_EPISODE      0
+#define DO_WIN_EPISODE      1
+#define DO_TOGGLE_CLOAK     2
+#define DO_RESPAWN          3 // bring the opponent back (as character arg) and count it defeated
+#define DO_SWAP_OPPONENT    4 // p2 becomes character arg
+
+#define SAME_CHARACTER      0xFF
+
+#define COUNTER_NONE        0 // episode counter shown in the corner
+#define COUNTER_TICKS       1
+#define COUNTER_ENEMIES_LEFT 2 // counts down to the RULE_DEFEATED_PAST rule
+
+typedef struct episoderule {
+	unsigned char trigger;
+	unsigned char action;
+	unsigned char arg; // character for DO_RESPAWN and DO_SWAP_OPPONENT
+	unsigned short value; // depends on the trigger
+} EPISODE_RULE;
+
 typedef struct episode {
 	unsigned int p1numLives;
 	unsigned int p2numLives;
@@ -288,6 +318,9 @@ typedef struct episode {
 	unsigned int p4Index;	
 	unsigned int levelIndex;
 	int difficultyLevel;
+	
+	EPISODE_RULE rules[MAX_EPISODE_RULES]; // objectives beyond winning the fight
+	unsigned int counter;
 } EPISODE; // for "Episode Mode": each episode has a custom definition/objective
 
 typedef struct invitational {
@@ -301,6 +334,36 @@ typedef struct stageString {
 	unsigned char string[19];
 } STAGE_STRING;
 
+// Every data file is an asset pack: a header, then a table of contents, then the chunks it lists. Chunks are found
+// by ID, never by position, and each one carries a checksum, so a file left over from another version of the game
+// is refused at startup instead of being read as the wrong structure. Offsets are from the start of the header.
+
+#define PACK_MAGIC    0x544C504BUL // "TLPK"
+#define PACK_VERSION  3 // bump whenever a chunk's structure changes (2: no bracket layout in EXTRA_EXTERNAL, 3: episodes
+                        // hold their EPISODE_RULE tables)
+
+#define CHUNK_ID(__a,__b,__c,__d) (((unsigned long)(__a) << 24) | ((unsigned long)(__b) << 16) | ((__c) << 8) | (__d))
+#define CHUNK_STAGES         CHUNK_ID('S','T','G','E') // tl_stage: EXTERNAL
+#define CHUNK_SPRITES        CHUNK_ID('S','P','R','T') // tl_charx: character frame sprites
+#define CHUNK_FRAME_OFFSETS  CHUNK_ID('F','O','F','S') // tl_charx: where each character's frames start in SPRT
+#define CHUNK_EXTRA          CHUNK_ID('E','X','T','R') // tl_extra: EXTRA_EXTERNAL
+
+#define CHARS_PER_FILE  8 // characters stored in each tl_charx file
+
+typedef struct packchunk {
+	unsigned long id;
+	unsigned short offset;
+	unsigned short length;
+	unsigned short checksum;
+} PACK_CHUNK;
+
+typedef struct packheader {
+	unsigned long magic;
+	unsigned short version;
+	unsigned short numChunks;
+	PACK_CHUNK toc[];
+} PACK_HEADER;
+
 typedef struct ext {
 	unsigned char coatlightsplash[820];
 	unsigned char coatdarksplash[24]; // compressed - 844 bytes (21% of original); decompressed on launch
@@ -334,7 +397,6 @@ typedef struct ext {
 	unsigned short banner[96];
 	
 	short tournamentTiles[31][32];	
-	char bracketLayout[35][13];
 	
 	EPISODE episodes[31];
 	INVITATIONAL invitationalList[10];
@@ -0,0 +1,129 @@
+// Twilight Legion Extra Data Installer
+// C Source File - rleencode.c
+// Michael Hergenrader
+// Compiled with any ANSI C compiler on the PC (this one is not a calculator program)
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Encoder for the compressed splashscreens pasted into Main.c (coatlightsplash and the rest). It reads one raw
+// 160x100 plane (2000 bytes, 20 bytes per line) and prints the compressed bytes as C initializer lines.
+// The game's RLE_Decompress walks the screen a column at a time, so this encoder walks it the same way.
+// Every encoding is decoded again and compared before anything is printed, so a bad encoding never reaches
+// the data file.
+//
+// Usage: rleencode plane.bin [count]   (count = bytes to encode, 1999 for the splashscreens)
+// rletest.sh runs it over a set of sample planes that are hard to encode.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SENTINEL_VALUE   0x91 // must match the game's constructs.h
+#define SCREEN_BYTES     2001 // RLE_Decompress can reach one byte past the 2000 byte plane
+#define MIN_RUN          4    // a run costs 3 bytes, so shorter ones stay literal
+#define MAX_RUN          255
+
+// Next byte in the decoder's column order (the same stepping as RLE_Decompress)
+static unsigned int nextPos(unsigned int pos) {
+	pos += 20;
+	if (pos > 2000) {
+		pos -= 1999;
+	}
+	return pos;
+}
+
+// Compresses count bytes of screen into out, returning the compressed length
+static unsigned int RLE_Encode(const unsigned char* screen, unsigned int count, unsigned char* out) {
+	unsigned int pos = 0, done = 0, length = 0, run, scan;
+	unsigned char value;
+
+	while (done < count) {
+		value = screen[pos];
+		run = 1;
+		scan = nextPos(pos);
+		while (done + run < count && run < MAX_RUN && screen[scan] == value) {
+			run++;
+			scan = nextPos(scan);
+		}
+
+		if (run >= MIN_RUN || value == SENTINEL_VALUE) { // the marker itself can only be stored as a run
+			out[length++] = SENTINEL_VALUE;
+			out[length++] = value;
+			out[length++] = (unsigned char)run;
+		} else {
+			unsigned int i;
+			for (i = 0; i < run; i++) {
+				out[length++] = value;
+			}
+		}
+		done += run;
+		pos = scan;
+	}
+	return length;
+}
+
+// Same as the game's RLE_Decompress, for checking every encoding before it is printed
+static void RLE_Decode(const unsigned char* src, unsigned char* dest, int size) {
+	unsigned int pos = 0, count;
+	unsigned char value;
+
+	while (size > 0) {
+		if (*src == SENTINEL_VALUE) {
+			value = src[1];
+			count = src[2];
+			src += 3;
+		} else {
+			value = *src++;
+			count = 1;
+		}
+		size -= count;
+
+		while (count--) {
+			dest[pos] = value;
+			pos = nextPos(pos);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	static unsigned char screen[SCREEN_BYTES], check[SCREEN_BYTES], packed[SCREEN_BYTES * 3];
+	unsigned int count = 1999, length, pos, i;
+	FILE* in;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: %s plane.bin [count]\n", argv[0]);
+		return 1;
+	}
+	if (argc == 3) {
+		count = (unsigned int)atoi(argv[2]);
+		if (count == 0 || count > SCREEN_BYTES) {
+			fprintf(stderr, "count must be 1 to %d\n", SCREEN_BYTES);
+			return 1;
+		}
+	}
+	if ((in = fopen(argv[1], "rb")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	fread(screen, 1, SCREEN_BYTES, in); // shorter files are zero padded
+	fclose(in);
+
+	length = RLE_Encode(screen, count, packed);
+
+	RLE_Decode(packed, check, count);
+	for (i = 0, pos = 0; i < count; i++, pos = nextPos(pos)) {
+		if (check[pos] != screen[pos]) {
+			fprintf(stderr, "round trip failed at byte %u (screen offset %u)\n", i, pos);
+			return 2;
+		}
+	}
+
+	printf("// %u bytes (%u%% of %u)\n", length, length * 100 / count, count);
+	for (i = 0; i < length; i++) {
+		printf("0x%02X,%s", packed[i], ((i & 15) == 15 || i == length - 1) ? "\n" : "");
+	}
+	return 0;
+}
+
+// End of Source File
\ No newline at end of file
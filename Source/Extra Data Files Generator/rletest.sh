@@ -0,0 +1,38 @@
+#!/bin/sh
+# Twilight Legion Extra Data Installer
+# Shell Script - rletest.sh
+# Please see README for license/disclaimer information.
+#
+# Runs rleencode.c over sample planes that stress the encoding: all zero (runs far past 255), all SENTINEL_VALUE
+# (the marker can only be stored as runs), two long runs of different bytes, noise (mostly short runs either side
+# of MIN_RUN, and stray markers) and plain random bytes. The encoder decodes every encoding again and fails if it
+# does not come back the same, so this passes only if every plane round trips, for 1999 bytes (the splashscreens)
+# and for the whole 2000.
+#
+# Usage: sh rletest.sh   (needs a C compiler as cc, and awk)
+
+set -e
+cd "$(dirname "$0")"
+tmp="${TMPDIR:-/tmp}/rletest.$$"
+mkdir -p "$tmp"
+trap 'rm -rf "$tmp"' EXIT
+
+cc -O2 -o "$tmp/rleencode" rleencode.c
+
+plane() { # name, then an awk expression for byte i (seeded the same every time)
+	LC_ALL=C awk "BEGIN { srand(1); v = 0; for (i = 0; i < 2000; i++) printf \"%c\", $2 }" > "$tmp/$1.bin"
+}
+plane zero     0
+plane sentinel 145
+plane tworuns  "(i < 1000) ? 170 : 85"
+plane noise    "(v = (rand() < 0.3) ? ((rand() < 0.2) ? 145 : int(rand() * 4)) : v)"
+plane random   "int(rand() * 256)"
+
+for name in zero sentinel tworuns noise random; do
+	for count in 1999 2000; do
+		printf '%-9s %4s bytes: ' "$name" "$count"
+		"$tmp/rleencode" "$tmp/$name.bin" "$count" > "$tmp/out.c" # (stops the script if it does not round trip)
+		head -n 1 "$tmp/out.c"
+	done
+done
+echo "every plane round trips"
@@ -0,0 +1,190 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - Batch.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// AI-vs-AI balance sweep, only compiled when BATCH is defined. Every pair of characters fights headless one on one
+// on every stage, BATCH_RUNS times each (switching sides every run), for each difficulty and match type listed
+// below, and one line per matchup is written to the text variable tlbatch:
+//   char a,char b,difficulty,type,matches,a wins %,b wins %,draws,avg ticks,a KOs,b KOs
+// Every match is seeded from its own number in the sweep, so a sweep can be split across several calculators or
+// emulators by building with BATCH_SHARDS=n and BATCH_SHARD=0..n-1: each one plays every n-th matchup and the
+// CSVs can simply be put together afterwards. Any line played twice comes out the same.
+//
+// A calculator takes days over a sweep. host/batchrun plays the same matchups on a PC, across every core, through
+// batchMatchup, batchStages and batchLine below (it builds this file with BATCH and HOST_BUILD) - but only on the
+// one stage the PC has, as the real stages' layouts are in the data files: it samples the sweep, it does not
+// replace it.
+
+#include "platform.h"
+#include "headers.h"
+
+#ifdef BATCH
+
+#ifndef BATCH_SHARDS
+#define BATCH_SHARDS      1
+#endif
+#ifndef BATCH_SHARD
+#define BATCH_SHARD       0
+#endif
+#define BATCH_RUNS        2    // matches per stage for every matchup (an even count gives both sides equal turns)
+#define BATCH_MAX_TICKS   6000 // five minutes of play - a match still going by then is a draw
+#define BATCH_FILENAME    "tlbatch"
+
+// The sweep: every difficulty, stock matches only - one shard's output has to stay under 64KB (about 1500 lines),
+// so add TIMED with BATCH_SHARDS=2 or more. host/batchrun plays these same matchups.
+static const DIFFICULTY batchDifficulties[] = {CLASSIC, ADMIRAL, PREMIERE, ELITE};
+static const MATCHTYPE batchTypes[] = {STOCK};
+
+#define BATCH_PAIRS (NUM_CHARS * (NUM_CHARS - 1) / 2)
+#define BATCH_LINES (sizeof(batchDifficulties) / sizeof(DIFFICULTY) * sizeof(batchTypes) / sizeof(MATCHTYPE) * BATCH_PAIRS)
+
+// The settings every sweep match is played under: a headless two minute, three life Arena match between two CPUs
+void batchSetup(void) {
+	currentProfile.matchMinutes = 2;
+	currentProfile.crowdPressure = OFF;
+	currentProfile.matchLives = 3;
+	currentProfile.itemProb = 5;
+
+	mode = ARENA_MODE;
+	linked = FALSE;
+	headless = TRUE;
+	numPlayers = 2;
+	numHands = 0;
+	p1->team = WHITE_TEAM;
+	p2->team = LIGHTGRAY_TEAM;
+}
+
+// How many matchups (CSV lines) the sweep has
+unsigned long batchMatchups(void) {
+	return BATCH_LINES;
+}
+
+// Matchup number line of the sweep - difficulties outermost, then match types, then pairs of characters in order:
+// sets its difficulty and match type up and gives back its two characters
+void batchMatchup(unsigned long line, unsigned int* a, unsigned int* b) {
+	unsigned int pair = line % BATCH_PAIRS;
+
+	line /= BATCH_PAIRS;
+	currentProfile.matchType = batchTypes[line % (sizeof(batchTypes) / sizeof(MATCHTYPE))];
+	currentProfile.difficulty = batchDifficulties[line / (sizeof(batchTypes) / sizeof(MATCHTYPE))];
+	for (*a = 0; pair >= NUM_CHARS - 1 - *a; pair -= NUM_CHARS - 1 - *a, (*a)++);
+	*b = *a + 1 + pair;
+}
+
+#ifndef HOST_BUILD // (the calculator's own sweep, into a variable)
+
+static void batchSweep(FILE* out);
+
+// Plays the whole sweep (or this build's shard of it) and writes the results; called instead of the menus in batch builds
+void runBatch(void) {
+	FILE* out;
+
+	out = fopen(BATCH_FILENAME, "w");
+	if (out == NULL) {
+		return;
+	}
+	fprintf(out, "char a,char b,difficulty,type,matches,a wins %%,b wins %%,draws,avg ticks,a KOs,b KOs\n");
+
+	batchSetup();
+	batchSweep(out);
+
+	headless = FALSE;
+	fclose(out);
+}
+
+// Every matchup of the sweep that falls in this shard, on every stage, one line each
+static void batchSweep(FILE* out) {
+	BATCH_TALLY tally;
+	char text[64];
+	unsigned int a, b;
+	unsigned long line;
+
+	for (line = 0; line < BATCH_LINES; line++) {
+		if (line % BATCH_SHARDS != BATCH_SHARD) {
+			continue;
+		}
+		if (_keytest(RR_ESC)) { // stop early - everything finished so far is kept
+			return;
+		}
+
+		batchMatchup(line, &a, &b);
+		memset(&tally, 0, sizeof(BATCH_TALLY));
+		batchStages(&tally, a, b, 0, NUM_STAGES, BATCH_RUNS);
+		batchLine(text, a, b, &tally);
+		fputs(text, out);
+	}
+}
+
+#endif
+
+// Plays characters a and b runs times on each of stages stages from first, into the tally
+void batchStages(BATCH_TALLY* tally, unsigned int a, unsigned int b, unsigned int first, unsigned int stages, unsigned int runs) {
+	unsigned int s, r;
+
+	for (s = first; s < first + stages; s++) {
+		for (r = 0; r < runs; r++) {
+			batchMatch(tally, a, b, s, r);
+		}
+	}
+}
+
+// One match between characters a and b, added into the tally
+void batchMatch(BATCH_TALLY* tally, unsigned int a, unsigned int b, unsigned int stage, unsigned int run) {
+	GAME_STATE state;
+	INPUT_FRAME input;
+	PLAYER* sides[2];
+	unsigned int i, winner = 2;
+
+	memset(&input, 0, sizeof(INPUT_FRAME)); // nobody is pressing keys - both players are CPUs
+	input.beats = 1;
+
+	sides[run & 1] = p1; // a plays p1 on even runs and p2 on odd ones, so neither gets the p1 slot every time
+	sides[!(run & 1)] = p2;
+	sides[0]->characterIndex = a;
+	sides[1]->characterIndex = b;
+	stageIndex = stage;
+
+	seedMatch(((unsigned long)((a * NUM_CHARS + b) * NUM_STAGES + stage) << 8) + run);
+	freeItemList(&head);
+	setupMatch();
+	p1->type = CPU;
+	myPlayer = p1; // the camera still follows p1
+	fightMetal = FALSE;
+	fightCloaked = FALSE;
+	memset(&state, 0, sizeof(GAME_STATE));
+
+	for (i = 0; i < BATCH_MAX_TICKS; i++) {
+		sim_step(&state, &input);
+		if (state.result == SIM_TIME_UP || state.result == SIM_GAME_SET || state.result == SIM_SUDDEN_DEATH_SET) {
+			winner = (state.winner == sides[0]->team) ? 0 : 1;
+			break;
+		}
+	}
+
+	tally->matches++;
+	if (winner < 2) {
+		tally->wins[winner]++;
+	} else {
+		tally->draws++;
+	}
+	tally->ticks += i;
+	tally->kills[0] += sides[0]->numKills;
+	tally->kills[1] += sides[1]->numKills;
+
+	freeItemList(&head);
+}
+
+// A matchup's CSV line (newline included), from its tally, at the difficulty and match type batchMatchup set up
+void batchLine(char* line, unsigned int a, unsigned int b, const BATCH_TALLY* tally) {
+	sprintf(line, "%u,%u,%u,%u,%u,%u,%u,%u,%lu,%u,%u\n", a, b, currentProfile.difficulty, currentProfile.matchType, tally->matches,
+		(unsigned int)(tally->wins[0] * 100UL / tally->matches), (unsigned int)(tally->wins[1] * 100UL / tally->matches),
+		tally->draws, tally->ticks / tally->matches, tally->kills[0], tally->kills[1]);
+}
+
+#endif
+
+// End of Source File
@@ -0,0 +1,161 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - Benchmark.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Tick-throughput benchmark for the match loop, only compiled when BENCHMARK is defined. Every stage is
+// played headless by CPU players (2, 3 and 4 of them), plus one two-hand boss fight, for BENCH_TICKS
+// ticks each (build with BENCH_TICKS=n for longer or shorter runs), and one line per run is written to the
+// text variable tlbench:
+//   stage,players,ticks,ticks/s,worst us,players %,collisions %,hands %,items %,other %
+// There is no cycle counter to read, so time is sampled: every programmable timer interrupt is charged to
+// whichever part of the tick is running (see BENCH_PHASE). The timer is sped up from the OS's 20 per second
+// to about 200 while benchmarking, so single ticks are measured to about 5ms instead of 50ms.
+
+#include <tigcclib.h>
+#include "headers.h"
+
+#ifdef BENCHMARK
+
+#ifndef BENCH_TICKS
+#define BENCH_TICKS        600  // ticks played on each stage/player count
+#endif
+#define BENCH_RATE         0xF9 // programmable timer value while benchmarking: 8 counts a sample...
+#define BENCH_OS_US        50000UL // ...where the value the OS sets gives one sample every 50ms
+#define BENCH_FILENAME     "tlbench"
+
+volatile unsigned int benchPhase = BENCH_OTHER;
+static volatile unsigned long benchSamples[BENCH_NUM_PHASES];
+static volatile unsigned long benchTotal; // every sample taken during the current run
+static unsigned long benchUsPerSample; // at BENCH_RATE (the timer's period is proportional to 257 - its value)
+
+static void benchmarkMatch(FILE* out, unsigned int stage, unsigned int players, unsigned int hands);
+static void setupBenchmarkMatch(GAME_STATE* state);
+
+// Sampling profiler on the system timer - replaces timer_int while benchmarking (the clock is stepped by sim_step)
+DEFINE_INT_HANDLER(bench_int) {
+	register void* olda5 asm("%a4");
+	asm volatile("move.l %%a5,%0" : "=a"(olda5));
+	asm volatile("lea __ld_entry_point_plus_0x8000(%pc),%a5");
+
+	benchSamples[benchPhase]++;
+	benchTotal++;
+
+	asm("move.l %0,%%a5" : : "a"(olda5));
+}
+
+// Runs every benchmark configuration and writes the results out; called instead of the menus in benchmark builds
+void runBenchmark(void) {
+	FILE* out;
+	unsigned int s, n;
+	unsigned char osRate;
+
+	out = fopen(BENCH_FILENAME, "w");
+	if (out == NULL) {
+		return;
+	}
+	fprintf(out, "stage,players,ticks,ticks/s,worst us,players %%,collisions %%,hands %%,items %%,other %%\n");
+
+	currentProfile.difficulty = ELITE; // the hardest AI does the most work per tick
+	currentProfile.matchType = STOCK;
+	currentProfile.matchMinutes = 2;
+	currentProfile.crowdPressure = OFF;
+	currentProfile.matchLives = 5;
+	currentProfile.itemProb = 1; // most frequent items
+
+	mode = ARENA_MODE;
+	linked = FALSE;
+	headless = TRUE;
+	p1->team = WHITE_TEAM;
+	p2->team = LIGHTGRAY_TEAM;
+	p3->team = DARKGRAY_TEAM;
+	p4->team = BLACK_TEAM; // free for all
+
+	osRate = peekIO(0x600017);
+	benchUsPerSample = BENCH_OS_US * (257 - BENCH_RATE) / (257 - osRate);
+	pokeIO(0x600017, BENCH_RATE);
+	SetIntVec(AUTO_INT_5, bench_int);
+
+	for (s = 0; s < NUM_STAGES; s++) {
+		for (n = 2; n <= MAX_PLAYERS; n++) {
+			benchmarkMatch(out, s, n, 0);
+		}
+	}
+	benchmarkMatch(out, FINAL_DESTINATION, 1, 2); // Master Hand and Crazy Hand
+
+	SetIntVec(AUTO_INT_5, save_int_5);
+	pokeIO(0x600017, osRate);
+	headless = FALSE;
+	fclose(out);
+}
+
+// Plays one stage for BENCH_TICKS ticks (starting over whenever the match ends) and writes its line
+static void benchmarkMatch(FILE* out, unsigned int stage, unsigned int players, unsigned int hands) {
+	GAME_STATE state;
+	INPUT_FRAME input;
+	unsigned long before, worst = 0, total, ms;
+	unsigned int i;
+
+	memset(&input, 0, sizeof(INPUT_FRAME)); // nobody is pressing keys - every player is a CPU
+	input.beats = 1; // one clock beat per tick, as the headless clock always ran
+
+	stageIndex = stage;
+	numPlayers = players;
+	numHands = hands;
+	p1->characterIndex = stage % NUM_CHARS; // fixed but varied fighters, so every build plays the same matches
+	p2->characterIndex = (stage + 7) % NUM_CHARS;
+	p3->characterIndex = (stage + 13) % NUM_CHARS;
+	p4->characterIndex = (stage + 19) % NUM_CHARS;
+
+	seedMatch(stage * MAX_PLAYERS + players);
+	setupBenchmarkMatch(&state);
+
+	memset((void*)benchSamples, 0, sizeof(benchSamples));
+	benchTotal = 0;
+
+	for (i = 0; i < BENCH_TICKS; i++) {
+		before = benchTotal;
+		if (sim_step(&state, &input) != SIM_RUNNING) {
+			setupBenchmarkMatch(&state);
+		}
+		if (benchTotal - before > worst) {
+			worst = benchTotal - before;
+		}
+	}
+
+	total = benchTotal;
+	freeItemList(&head);
+
+	if (!total) {
+		total = 1; // ran faster than one sample - report it as one
+	}
+	if (!(ms = total * benchUsPerSample / 1000)) {
+		ms = 1;
+	}
+	fprintf(out, "%u,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", stage, players + hands, BENCH_TICKS,
+		(unsigned long)BENCH_TICKS * 1000 / ms, worst * benchUsPerSample,
+		benchSamples[BENCH_PLAYERS] * 100 / total, benchSamples[BENCH_COLLISIONS] * 100 / total,
+		benchSamples[BENCH_HANDS] * 100 / total, benchSamples[BENCH_ITEMS] * 100 / total,
+		benchSamples[BENCH_OTHER] * 100 / total);
+}
+
+// Same setup as a real match, except that p1 is handed to the AI as well
+static void setupBenchmarkMatch(GAME_STATE* state) {
+	freeItemList(&head);
+	setupMatch();
+
+	p1->type = CPU;
+	myPlayer = p1; // the camera still follows p1
+	fightMetal = FALSE;
+	fightCloaked = FALSE;
+
+	memset(state, 0, sizeof(GAME_STATE));
+	benchPhase = BENCH_OTHER;
+}
+
+#endif
+
+// End of Source File
\ No newline at end of file
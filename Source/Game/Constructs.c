@@ -15,7 +15,7 @@
 // limit. Thus, these were broken out into individual fields. For the booleans below, a bit vector could be tried also;
 // kept simple for now.
 
-#include <tigcclib.h>
+#include "platform.h"
 #include "constructs.h"
 
 INT_HANDLER save_int_1;
@@ -43,6 +43,7 @@ HAND* masterHand;
 HAND* crazyHand;
 
 TIMER* timer;
+PROJECTILE* projectiles;
 
 BOOL scrollL;
 BOOL scrollR;
@@ -59,6 +60,7 @@ BOOL cont = FALSE;
 BOOL episodeSuccess;
 BOOL goAheadAndSave = FALSE;
 BOOL linked = FALSE; // current player items
+BOOL headless = FALSE;
 
 int x_fg;
 int y_fg;
@@ -73,6 +75,7 @@ unsigned int numPlayers;
 unsigned int numHands;
 unsigned int battleCounter = 0;
 unsigned int winningTeam;
+unsigned int backIndex;
 GAME_MODE mode = NONE_SELECTED;
 
 unsigned char calc = HOST_CALC; // ID of which calculator is being used in link play (master/host or slave/join/follower)
@@ -84,8 +87,15 @@ MATCHTYPE gameMatchType;
 unsigned int gameMatchLives;
 unsigned int gameItemProb;
 
+unsigned int playerKeys = 0;
+
+GAME_STATE game;
+
 unsigned long points[8]; // classic mode point categories (8 different ways to earn points)
 
+unsigned long rngStreams[NUM_RNG_STREAMS];
+unsigned long matchSeed;
+
 EXTERNAL* dataptr; // pointers for loading from external files
 unsigned long* c1;
 unsigned long* c2;
@@ -136,4 +146,6 @@ STAGE rtfstages[2] = { // race to the finish stages
 	{20,20,NULL,{NULL,20,NULL,NULL,0,0,1},FALSE}, // layout 2
 };
 
+unsigned char collisionGrid[GRID_H << GRID_SHIFT]; // rebuilt whenever a stage is selected
+
 // End of Source File
\ No newline at end of file
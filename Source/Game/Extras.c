@@ -6,10 +6,10 @@
 // and any credit to me would be greatly appreciated! :-)
 // Copyright 2005-2010 Michael Hergenrader
 
-// Small utility file - was originally much larger, but has been reduced. May decide to get rid
-// of this file in the future to consolidate.
+// Small utility file - was originally much larger, but has been reduced. Holds text centering and the
+// random number generators.
 
-#include <tigcclib.h>
+#include "platform.h"
 #include "headers.h"
 
 // Centers the text of a string with certain font width - saves 6 bytes by declaring pure
@@ -17,4 +17,86 @@ inline unsigned int __attribute__ ((pure)) HCENTER(const char* const str, int wi
 	return (160 - (strlen(str) * width)) >> 1;
 }
 
+// Random numbers come from one xorshift generator per subsystem (see RNG_STREAM) instead of the single rand()
+// sequence, so an extra draw in the AI no longer changes which items drop, and a match played from the same seed
+// with the same input always comes out the same
+static unsigned long nextState(RNG_STREAM stream) {
+	unsigned long x = rngStreams[stream];
+	
+	x ^= (x << 13) & 0xFFFFFFFFUL; // the masks cost nothing on the calculator and keep wider longs in step
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xFFFFFFFFUL;
+	return rngStreams[stream] = x;
+}
+
+// 0 to n-1 from a stream - scales the top 16 bits instead of dividing, which is cheaper than a modulo here
+unsigned int randomFrom(RNG_STREAM stream, unsigned int n) {
+	return (unsigned int)(((nextState(stream) >> 16) * n) >> 16);
+}
+
+// A fresh seed for the next match, drawn from the menu stream
+unsigned long newSeed(void) {
+	return nextState(RNG_MENUS);
+}
+
+// Neighbouring seeds are scrambled apart first, and the state is never left at 0 (xorshift would stay there)
+void seedStream(RNG_STREAM stream, unsigned long seed) {
+	seed = (seed + 0x9E3779B9UL * (stream + 1)) & 0xFFFFFFFFUL;
+	seed = ((seed ^ (seed >> 16)) * 0x45D9F3BUL) & 0xFFFFFFFFUL;
+	seed = ((seed ^ (seed >> 16)) * 0x45D9F3BUL) & 0xFFFFFFFFUL;
+	seed ^= seed >> 16;
+	rngStreams[stream] = seed ? seed : 0x2545F491UL;
+}
+
+// Seeds every in-match stream from one number (the menu stream is left alone)
+void seedMatch(unsigned long seed) {
+	RNG_STREAM stream;
+	
+	matchSeed = seed;
+	for (stream = RNG_ITEMS; stream < RNG_MENUS; stream++) {
+		seedStream(stream, seed);
+	}
+}
+
+// Copies one piece of match state into or out of a snapshot; returns where the next piece goes
+char* transferState(char* at, void* var, unsigned int size, STATE_TRANSFER how) {
+	if (how == STATE_SAVE) {
+		memcpy(at, var, size);
+	} else if (how == STATE_LOAD) {
+		memcpy(var, at, size);
+	}
+	return at + size;
+}
+
+// The quicksave's counterpart: one int-sized variable in as few bytes as its value needs, seven bits a byte from the
+// low end, with the top bit set on all but the last. Signed ones are zigzagged first (0, -1, 1, -2...) so that small
+// negative numbers stay short too.
+char* packWord(char* at, void* var, BOOL isSigned, STATE_TRANSFER how) {
+	unsigned int v = 0, shift = 0;
+	unsigned char b;
+	
+	if (how == STATE_LOAD) {
+		do {
+			b = *at++;
+			v |= (unsigned int)(b & 0x7F) << shift;
+			shift += 7;
+		} while (b & 0x80);
+		*(unsigned int*)var = isSigned ? (v >> 1) ^ -(v & 1) : v;
+		return at;
+	}
+	
+	v = *(unsigned int*)var;
+	if (isSigned) {
+		v = (v << 1) ^ -(v >> (sizeof(int) * 8 - 1));
+	}
+	do {
+		if (how == STATE_SAVE) {
+			*at = (v & 0x7F) | ((v > 0x7F) ? 0x80 : 0);
+		}
+		at++;
+		v >>= 7;
+	} while (v);
+	return at;
+}
+
 // End of Source File
\ No newline at end of file
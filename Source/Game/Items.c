@@ -6,7 +6,7 @@
 // and any credit to me would be greatly appreciated! :-)
 // Copyright 2005-2010 Michael Hergenrader
 
-#include <tigcclib.h>
+#include "platform.h"
 #include "headers.h" // All items are perfect and bug free
 
 // Useful macro to determine when two rectangles of size (k, l) and (m, n) are overlapping
@@ -17,44 +17,88 @@ unsigned int rVals[8] = {
 	100, 50, 48, 36, 24, 12, 10, 10
 };
 
-static inline BOOL moveItem(ITEM* item);
+// Every item in a match comes out of this pool (nothing is malloc'd during play)
+static ITEM itemPool[MAX_ITEMS];
+static ITEM* freeItems = NULL; // used items waiting to be dropped again, linked through next
+static unsigned int itemsIssued = 0; // pool entries handed out since the last freeItemList()
+
+// Live items are also bucketed by stage position (64x64 pixel cells, edges clamped) so pickup checks only look nearby
+#define BUCKET_SHIFT      6
+#define BUCKETS_ACROSS    8
+#define BUCKETS_ROW_SHIFT 3
+static ITEM* itemBuckets[BUCKETS_ACROSS * BUCKETS_ACROSS];
+
+static inline unsigned int bucketCoord(int v) __attribute__ ((const));
+static inline void bucketItem(ITEM* item);
+static ITEM* findItemNear(PLAYER* p);
+
+static inline const void* itemSprite(unsigned int index);
 
 // Item methods
 
-// Adds an item to the front of the linked list - created dynamically each time
+// Adds an item to the front of the linked list - recycled items are reused before fresh pool entries
 inline void addItem(unsigned int index) {
-	ITEM* newItem = malloc(sizeof(ITEM));
+	ITEM* newItem;
+	
+	if (freeItems != NULL) {
+		newItem = freeItems;
+		freeItems = freeItems->next;
+	} else if (itemsIssued < MAX_ITEMS) {
+		newItem = &itemPool[itemsIssued++];
+	} else {
+		return; // pool is full - skip this drop (see MAX_ITEMS)
+	}
 	
 	// Choose a random position within the screen to drop an item from the sky
 	// Items under index 5 are larger items
-	newItem->x = (index < 5) ? random((stageTemp->sw << 4) - 16) : random((stageTemp->sw << 4) - 8);
+	newItem->x = (index < 5) ? randomFrom(RNG_ITEMS, (stageTemp->sw << 4) - 16) : randomFrom(RNG_ITEMS, (stageTemp->sw << 4) - 8);
 	newItem->y = 0;
 	newItem->h = (index < 5) ? 16 : 8; // specify the dimensions of the item - big or small
 	
 	newItem->beingHeld = FALSE;
 	newItem->beenUsed = FALSE;
+	newItem->fall = 0;
+	newItem->frac = 0;
 	
 	newItem->replenish = (index < 18) ? 0 : rVals[index-18]; // if a healing item, assign its HP replenish value
 	newItem->index = index;
-	
-	if (index < 5) {
-		newItem->data = dataptr->bigitems[index]; // attach the proper sprites for rendering
-	} else {
-		newItem->data = dataptr->smallitems[index-ITEM_OFFSET];	
-	}	
+	newItem->data = itemSprite(index); // attach the proper sprites for rendering
 	newItem->next = NULL;
 	
 	if (head != NULL) {
 		newItem->next = head;
 	}
 	head = newItem;
+	bucketItem(newItem);
 }
 
-// Draws all items in the level each iteration
-void drawAllItems(void *dest) {
-	ITEM* temp = head;
+// Moves all items in the level each iteration (follows the camera and drops items still falling from the sky; held
+// items stay put). Used items are unlinked here and go back to the pool, and whoever still had one lets go of it, as
+// the next drop reuses it. The rest are put back in their (possibly new) buckets.
+void moveAllItems(void) {
+	ITEM *temp = head, *prev = NULL, *next;
+	unsigned int slot;
+	
+	memset(itemBuckets, 0, sizeof(itemBuckets));
 	while (temp != NULL) {
-		if (!temp->beenUsed && !temp->beingHeld) {
+		next = temp->next;
+		if (temp->beenUsed && !temp->beingHeld) {
+			if (prev == NULL) {
+				head = next;
+			} else {
+				prev->next = next;
+			}
+			for (slot = 0; slot < numPlayers; slot++) {
+				if (PLAYER_SLOT(slot)->currentItem == temp) {
+					PLAYER_SLOT(slot)->currentItem = NULL;
+				}
+			}
+			temp->next = freeItems;
+			freeItems = temp;
+			temp = next;
+			continue;
+		}
+		if (!temp->beingHeld) {
 			if (scrollR)	{
 				temp->x -= myPlayer->moveSpeed;
 			}
@@ -67,67 +111,145 @@ void drawAllItems(void *dest) {
 			if (scrollU) {
 				temp->y += 2; // shift the drawing position of the items as scrolling occurs
 			}
-			if (moveItem(temp)) { // if item is falling from the sky, keep dropping it
-				temp->y += 2;
-			}
-			
-			if (temp->h > 8) {
-				GrayClipISprite16_TRANW_R(temp->x, temp->y, temp->h, temp->data, dest, dest + LCD_SIZE); // draw the item based on its size
-			} else {
-				GrayClipISprite8_TRANW_R(temp->x, temp->y, temp->h, temp->data, dest, dest + LCD_SIZE);
+			if (dropItem(temp)) { // if item is falling from the sky, keep dropping it
+				if (temp->y + y_fg >= (stageTemp->sh << 4)) {
+					temp->beenUsed = TRUE; // fell off the bottom of the stage - recycle it next time
+				}
 			}
 		}
-		temp = temp->next;
+		bucketItem(temp);
+		prev = temp;
+		temp = next;
 	}
 }
 
-// Returns if an item can be moved or whether it has hit a ground tile
-inline BOOL moveItem(ITEM* item) {
-	return (!((stageTemp->tileInfo[getTile(item->x + x_fg, item->y + y_fg + item->h)]) & SOLID));
+// Sprite of an item by index - items under index 5 are the larger ones
+static inline const void* itemSprite(unsigned int index) {
+	return (index < 5) ? (const void*)dataptr->bigitems[index] : (const void*)dataptr->smallitems[index-ITEM_OFFSET];
 }
 
-// Destroys and frees the item linked list in a current level
+// Empties the item linked list in a current level and hands the whole pool back
 void freeItemList(ITEM** head) {
-	ITEM *temp = *head, *next;
-	while (temp != NULL) {
-		next = temp->next;
-		free(temp);
-		temp = next;
-	}
 	*head = NULL; // assign the front of the list to the empty list
+	freeItems = NULL;
+	itemsIssued = 0;
+	memset(itemBuckets, 0, sizeof(itemBuckets));
 }
 
-//==========================================================================================================================================
+// Items' share of a match snapshot - every item lives in the pool, so the list and bucket pointers stay good
+char* itemState(char* at, STATE_TRANSFER how) {
+	at = transferState(at, itemPool, sizeof(itemPool), how);
+	at = transferState(at, &head, sizeof(ITEM*), how);
+	at = transferState(at, &freeItems, sizeof(ITEM*), how);
+	at = transferState(at, &itemsIssued, sizeof(unsigned int), how);
+	return transferState(at, itemBuckets, sizeof(itemBuckets), how);
+}
 
-// Returns the item to pick up that is in the region (and hasn't already been used)
-ITEM* myItem(PLAYER* p) {
-	ITEM* temp = head;
-	while (temp != NULL) {
-		if (!temp->beenUsed && OBJECTS_COLLIDE_2HW(temp->x + x_fg, temp->y + y_fg, p->x + x_fg + ((characters[p->characterIndex].w) / 2) - 8, p->y + y_fg + characters[p->characterIndex].h - 16 + ((characters[p->characterIndex].h) & 1), temp->h, 16, temp->h, 16)) {
-			return temp;
+// Items' share of a quicksave: each live item in list order, with the slot of the player holding it (the players are
+// loaded first), and how many used ones are waiting in the pool. A load puts the live items at the front of the pool
+// and the used ones after them, which plays the same as wherever they were.
+char* itemQuicksave(char* at, STATE_TRANSFER how) {
+	ITEM* item;
+	unsigned int live = 0, spare = 0, i, bits, holder;
+	
+	for (item = head; item != NULL; item = item->next) {
+		live++;
+	}
+	for (item = freeItems; item != NULL; item = item->next) {
+		spare++;
+	}
+	at = packWord(at, &live, FALSE, how);
+	at = packWord(at, &spare, FALSE, how);
+	
+	if (how == STATE_LOAD) {
+		freeItemList(&head);
+		if (live + spare > MAX_ITEMS) {
+			live = spare = 0; // (not from this build)
+		}
+		for (i = 0; i < live + spare; i++) {
+			itemPool[i].next = (i + 1 < live + spare && i + 1 != live) ? &itemPool[i + 1] : NULL;
 		}
-		temp = temp->next;
+		head = live ? itemPool : NULL;
+		freeItems = spare ? &itemPool[live] : NULL;
+		itemsIssued = live + spare;
 	}
-	return NULL;
+	
+	for (item = head; item != NULL; item = item->next) {
+		bits = item->beingHeld | (item->beenUsed << 1);
+		for (holder = 0; holder < numPlayers && PLAYER_SLOT(holder)->currentItem != item; holder++);
+		
+		at = packWord(at, &item->x, TRUE, how);
+		at = packWord(at, &item->y, TRUE, how);
+		at = packWord(at, &item->index, FALSE, how);
+		at = packWord(at, &item->replenish, FALSE, how);
+		at = packWord(at, &item->fall, FALSE, how);
+		at = packWord(at, &item->frac, FALSE, how);
+		at = packWord(at, &bits, FALSE, how);
+		at = packWord(at, &holder, FALSE, how);
+		
+		if (how == STATE_LOAD) {
+			item->beingHeld = bits & 1;
+			item->beenUsed = (bits >> 1) & 1;
+			item->h = (item->index < 5) ? 16 : 8;
+			item->data = itemSprite(item->index);
+			if (holder < numPlayers) {
+				PLAYER_SLOT(holder)->currentItem = item;
+			}
+			bucketItem(item);
+		}
+	}
+	return at;
 }
 
-// Checks for if an item is in the reach of a player
-BOOL existsItemInRegion(PLAYER* p) {
-	ITEM* temp = head;
-	while (temp != NULL) {
-		if (OBJECTS_COLLIDE_2HW(temp->x + x_fg, temp->y + y_fg, p->x + x_fg + ((characters[p->characterIndex].w) / 2) - 8, p->y + y_fg + characters[p->characterIndex].h - 16 + ((characters[p->characterIndex].h) & 1), temp->h, 16, temp->h, 16)) {
-			return TRUE;
+// Bucket row/column of a stage coordinate (anything off either edge goes in the edge bucket)
+static inline unsigned int bucketCoord(int v) {
+	if (v < 0) {
+		return 0;
+	}
+	v >>= BUCKET_SHIFT;
+	return (v >= BUCKETS_ACROSS) ? BUCKETS_ACROSS - 1 : (unsigned int)v;
+}
+
+// Files an item under the bucket for its current stage position
+static inline void bucketItem(ITEM* item) {
+	ITEM** bucket = &itemBuckets[(bucketCoord(item->y + y_fg) << BUCKETS_ROW_SHIFT) + bucketCoord(item->x + x_fg)];
+	item->nextInBucket = *bucket;
+	*bucket = item;
+}
+
+//==========================================================================================================================================
+
+// Returns the item to pick up that is in the region (and hasn't already been used or taken)
+ITEM* myItem(PLAYER* p) {
+	return findItemNear(p);
+}
+
+// Items can only be picked up within 16 pixels of the player's feet, so at most 2x2 buckets need checking
+static ITEM* findItemNear(PLAYER* p) {
+	int px = p->x + x_fg + ((characters[p->characterIndex].w) / 2) - 8;
+	int py = p->y + y_fg + characters[p->characterIndex].h - 16 + ((characters[p->characterIndex].h) & 1);
+	unsigned int bx, by, bxEnd = bucketCoord(px + 16), byEnd = bucketCoord(py + 16);
+	ITEM* temp;
+	
+	for (by = bucketCoord(py - 16); by <= byEnd; by++) {
+		for (bx = bucketCoord(px - 16); bx <= bxEnd; bx++) {
+			temp = itemBuckets[(by << BUCKETS_ROW_SHIFT) + bx];
+			while (temp != NULL) {
+				if (!temp->beenUsed && !temp->beingHeld && OBJECTS_COLLIDE_2HW(temp->x + x_fg, temp->y + y_fg, px, py, temp->h, 16, temp->h, 16)) {
+					return temp;
+				}
+				temp = temp->nextInBucket;
+			}
 		}
-		temp = temp->next;
 	}
-	return FALSE;
+	return NULL;
 }
 
 // Item Helper Functions:
 
-// Player has a free projectile to do damage with
+// Player has a free projectile to do damage with (if they have a shot left)
 PLAYER* throw(PLAYER* p) {
-	p->myProjectile = setupProj(p);
+	setupProj(p);
 	return p;
 }
 
@@ -0,0 +1,678 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - Link.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Link play. Once the calculators are paired, the host sends the match setup (settings, fighters, stage and seed)
+// and from then on the two only trade input: every tick each one sends the keys its player pressed, and both run
+// the whole match - CPUs and items included - from the same inputs, so no game state ever goes over the cable.
+// Rather than wait on the cable every tick, a calculator guesses that the other player is still holding the keys
+// last heard from them and plays on. When the real keys turn out different, it loads the snapshot taken before
+// that tick and plays the ticks since then again (a rollback). It only stops to wait once it gets LINK_WINDOW ticks
+// past what it has heard. Packets carry every input the other side has not acknowledged yet, so a lost packet
+// is simply made up by the next one.
+//
+// As a safety net the host also samples every player every STATE_EVERY ticks (as a LINK_STRUCT, in stage
+// coordinates) and sends the sample once that tick is confirmed. The joining calculator compares it with its own
+// sample of the same tick and, if they differ, puts the host's values into its snapshot and rolls back from there.
+// Samples are sent as changes from the last one the joining calculator acknowledged: per player a 24-bit mask of
+// the words that changed, then just those words (the status flags are already packed two words' worth of bits).
+// Every STATE_KEYFRAME-th sample is sent against zeros instead, so a side that lost its base catches up again.
+//
+// Build with LOOPBACK defined to try all of this on one calculator: single calculator Arena matches then go
+// through the link code, with the cable swapped for a delay line that hands every packet back LOOPBACK_LATENCY
+// packets later and loses one in LOOPBACK_DROP. p2 is sent p1's own keys, so once the rollbacks catch up, p2
+// should follow every key press of p1's on the same tick - if it ever drifts, the snapshot is missing something.
+// host/loopcheck plays such a match on a PC and checks it ends where the same match played in lockstep does.
+
+#include "platform.h"
+#include "headers.h"
+
+#define LINK_HELLO       0x5A // pairing byte sent by establishConnection
+#define LINK_SYNC        0xA5 // first byte of every input packet
+#define LINK_STATE       0xA6 // ...of a host state sample
+#define LINK_STATE_ACK   0xA7 // ...and of its acknowledgement
+#define LINK_QUIT        0xFF // packet count sent on leaving the match
+#define LINK_WINDOW      8    // ticks played past the last input heard before waiting (and snapshots kept)
+#define LINK_KEYS        (LINK_WINDOW * 2) // the other side can be up to a window ahead as well
+#define LINK_TIMEOUT     200  // clock beats (about ten seconds) without a packet before the other calculator is given up on
+
+#define STATE_EVERY      32   // ticks between state samples
+#define STATE_KEYFRAME   4    // every this many samples is sent whole
+#define STATE_HISTORY    4    // samples kept on either side as bases for the next
+#define STATE_WORDS      (sizeof(LINK_STRUCT) / sizeof(unsigned short))
+#define STATE_MAX_BYTES  (MAX_PLAYERS * (3 + sizeof(LINK_STRUCT)))
+
+typedef char stateFitsMask[(STATE_WORDS <= 24) ? 1 : -1]; // a LINK_STRUCT that outgrows the 24-bit mask won't compile
+
+#ifdef LOOPBACK
+#define LOOPBACK_LATENCY 3
+#define LOOPBACK_DROP    8
+#endif
+
+#define BEFORE(__a,__b) ((int)((__a) - (__b)) < 0) // tick a comes before tick b, even once the count wraps
+
+typedef struct linkheader {
+	unsigned char sync;
+	unsigned char count; // inputs that follow (LINK_QUIT = the sender has left the match), or state bytes
+	unsigned short first; // tick of the first input, or of the state sample
+	unsigned short ack; // ticks of input the sender has from the calculator this goes to, or the sample's base tick
+} LINK_HEADER;
+
+typedef struct linkpacket {
+	LINK_HEADER h;
+	union {
+		unsigned short keys[LINK_WINDOW];
+		unsigned char state[STATE_MAX_BYTES];
+	} body;
+} LINK_PACKET;
+
+typedef struct linksample {
+	unsigned int tick;
+	LINK_STRUCT players[MAX_PLAYERS];
+} LINK_SAMPLE;
+
+static char* snapshots = NULL; // LINK_WINDOW match snapshots, each taken before playing its tick
+static unsigned int snapshotSize;
+
+static unsigned short localKeys[LINK_WINDOW]; // by tick: this player's keys not yet acknowledged
+static unsigned short remoteKeys[LINK_KEYS]; // by tick: the other player's keys - heard, or the guess that was played
+static unsigned short heardKeys; // the other player's latest keys, which are the guess for any tick not heard yet
+static unsigned int localSlot, remoteSlot; // input frame slots (p1 for the host, p2 for the joining calculator)
+
+static unsigned int ticks; // ticks played
+static unsigned int remoteTicks; // ticks of input heard from the other calculator
+static unsigned int remoteAck; // ticks of our input the other calculator has
+static BOOL mispredicted; // a tick was played with a wrong guess
+static unsigned int rollbackFrom; // the first one
+static BOOL remoteLeft;
+
+static LINK_SAMPLE sample; // this calculator's latest sample
+static BOOL sampleTaken, sampleFinal; // final once every input up to its tick is confirmed
+static LINK_SAMPLE history[STATE_HISTORY]; // host: samples sent; joining calculator: samples received
+static unsigned int historyNext;
+static unsigned int statesSent;
+static BOOL baseAcked; // host: the joining calculator has acknowledged baseTick
+static unsigned int baseTick;
+
+static LINK_PACKET inbox; // packet being read in
+static unsigned int inboxFill;
+static unsigned int lastHeard, lastSent; // clock beats
+
+#ifdef LOOPBACK
+static LINK_PACKET delayLine[LOOPBACK_LATENCY];
+static unsigned int delayLength[LOOPBACK_LATENCY];
+static unsigned int delayNext;
+static unsigned char arrived[sizeof(LINK_PACKET) * 2]; // bytes through the delay line, waiting to be read
+static unsigned int arrivedFill;
+#endif
+
+static void linkWrite(const void* data, unsigned int size);
+static unsigned int linkRead(void* data, unsigned int size);
+static BOOL readPacket(void);
+static BOOL receivePackets(GAME_STATE* state);
+static void sendInput(GAME_STATE* state);
+static BOOL waitForRemote(GAME_STATE* state);
+static void playTick(GAME_STATE* state);
+static BOOL rollback(GAME_STATE* state);
+static void takeSample(LINK_SAMPLE* s);
+static void applySample(const LINK_SAMPLE* s);
+static void checkSample(void);
+static void sendState(void);
+static void receiveState(void);
+static void resync(const LINK_SAMPLE* truth);
+static LINK_SAMPLE* findSample(unsigned int tick);
+
+// Pairs up with the calculator on the other end of the cable and decides which one hosts: EXIT if ESC is pressed
+// first, NO_SIGNAL if nothing can be sent
+char establishConnection(void) {
+	unsigned char hello[2], other[2];
+	unsigned int got;
+
+	OSLinkReset();
+	linked = TRUE;
+	do {
+		hello[0] = LINK_HELLO;
+		hello[1] = randomFrom(RNG_MENUS, 255) + 1; // the higher roll hosts, and a tie rolls again on both sides
+		if (OSWriteLinkBlock((char*)hello, 2)) {
+			return NO_SIGNAL;
+		}
+		for (got = 0; got < 2; got += OSReadLinkBlock((char*)other + got, 2 - got)) {
+			if (_keytest(RR_ESC)) {
+				return EXIT;
+			}
+		}
+	} while (other[0] != LINK_HELLO || other[1] == hello[1]);
+
+	calc = (hello[1] > other[1]) ? HOST_CALC : JOIN_CALC;
+	return SUCCESSFUL;
+}
+
+// Gets both calculators ready for a linked match: the host's settings and seed (seedMatch already called) are
+// sent to the joining calculator before setupMatch runs on either. FALSE if ESC was pressed while waiting or
+// there is no memory for the snapshots
+BOOL startLink(GAME_STATE* state) {
+	REPLAY_HEADER setup;
+	unsigned int got = 0;
+	unsigned char ready = LINK_HELLO;
+
+	snapshotSize = matchState(NULL, STATE_SIZE);
+	if ((snapshots = malloc(LINK_WINDOW * snapshotSize)) == NULL) {
+		return FALSE;
+	}
+	remoteLeft = FALSE;
+
+#ifdef LOOPBACK
+	calc = HOST_CALC;
+	memset(delayLength, 0, sizeof(delayLength));
+	delayNext = 0;
+	arrivedFill = 0;
+#else
+	if (calc == HOST_CALC) {
+		captureSettings(&setup);
+		setup.seed = matchSeed;
+		linkWrite(&setup, sizeof(REPLAY_HEADER));
+		while (linkRead(&ready, 1) != 1) {
+			if (_keytest(RR_ESC)) {
+				stopLink();
+				return FALSE;
+			}
+		}
+	} else {
+		while (got < sizeof(REPLAY_HEADER)) {
+			if (_keytest(RR_ESC)) {
+				stopLink();
+				return FALSE;
+			}
+			got += linkRead((char*)&setup + got, sizeof(REPLAY_HEADER) - got);
+		}
+		applySettings(&setup);
+		seedMatch(setup.seed);
+		linkWrite(&ready, 1);
+	}
+#endif
+
+	localSlot = (calc == HOST_CALC) ? 0 : 1;
+	remoteSlot = !localSlot;
+	ticks = remoteTicks = remoteAck = 0;
+	heardKeys = 0;
+	mispredicted = FALSE;
+	sampleTaken = sampleFinal = FALSE;
+	memset(history, 0, sizeof(history));
+	historyNext = statesSent = 0;
+	baseAcked = FALSE;
+	inboxFill = 0;
+	lastHeard = lastSent = state->beatCounter;
+	return TRUE;
+}
+
+// Plays the next tick of a linked match with this calculator's input frame; FALSE once the other calculator has
+// left or stopped answering. A result other than SIM_RUNNING is only handed back once the other calculator's
+// input for every tick up to it is in, so both end the match (or go to sudden death) on the same tick - and not
+// before the other calculator has all of this one's, or it would be left waiting for a packet that got lost.
+BOOL linkStep(GAME_STATE* state, const INPUT_FRAME* input) {
+	unsigned short keys = input->keys[localSlot];
+
+	while ((int)(ticks - remoteTicks) >= LINK_WINDOW || (int)(ticks - remoteAck) >= LINK_WINDOW) { // too far ahead to guess on
+		if (!waitForRemote(state)) {
+			return FALSE;
+		}
+	}
+	if (!receivePackets(state)) {
+		return FALSE;
+	}
+	checkSample();
+
+	if (!mispredicted || !rollback(state)) { // (unless the match turned out to have ended already)
+		localKeys[ticks % LINK_WINDOW] = keys;
+		playTick(state);
+	}
+	sendInput(state);
+
+	while (state->result != SIM_RUNNING && (BEFORE(remoteTicks, ticks) || BEFORE(remoteAck, ticks))) {
+		if (!waitForRemote(state)) {
+			return !BEFORE(remoteTicks, ticks); // (with all of its input in, the result stands even if its last acks were lost)
+		}
+		if (mispredicted) {
+			rollback(state);
+		}
+	}
+	return TRUE;
+}
+
+// Tells the other calculator this one has left the match, and frees the snapshots
+void stopLink(void) {
+	LINK_HEADER quit = {LINK_SYNC, LINK_QUIT, 0, 0};
+
+	if (!remoteLeft) {
+		linkWrite(&quit, sizeof(LINK_HEADER));
+	}
+	free(snapshots);
+	snapshots = NULL;
+#ifdef LOOPBACK
+	linked = FALSE;
+#endif
+}
+
+#ifdef LOOPBACK
+
+// Into the delay line instead of the cable: what went in LOOPBACK_LATENCY packets ago comes out (unless it was lost)
+static void linkWrite(const void* data, unsigned int size) {
+	if (delayLength[delayNext] && arrivedFill + delayLength[delayNext] <= sizeof(arrived)) {
+		memcpy(arrived + arrivedFill, &delayLine[delayNext], delayLength[delayNext]);
+		arrivedFill += delayLength[delayNext];
+	}
+	delayLength[delayNext] = randomFrom(RNG_MENUS, LOOPBACK_DROP) ? size : 0;
+	memcpy(&delayLine[delayNext], data, size);
+	delayNext = (delayNext + 1) % LOOPBACK_LATENCY;
+}
+
+static unsigned int linkRead(void* data, unsigned int size) {
+	if (size > arrivedFill) {
+		size = arrivedFill;
+	}
+	memcpy(data, arrived, size);
+	memmove(arrived, arrived + size, arrivedFill - size);
+	arrivedFill -= size;
+	return size;
+}
+
+#else
+
+static void linkWrite(const void* data, unsigned int size) {
+	OSWriteLinkBlock((const char*)data, size); // a block that fails to go is just a lost packet
+}
+
+static unsigned int linkRead(void* data, unsigned int size) {
+	return OSReadLinkBlock((char*)data, size);
+}
+
+#endif
+
+// Reads in as much of the next packet as has arrived; TRUE once a whole one is in the inbox
+static BOOL readPacket(void) {
+	unsigned int size;
+
+	do {
+		while (inboxFill < sizeof(LINK_HEADER)) { // a byte at a time, so a damaged packet is skipped up to the next sync byte
+			if (!linkRead((char*)&inbox + inboxFill, 1)) {
+				return FALSE;
+			}
+			if (inboxFill || inbox.h.sync == LINK_SYNC || inbox.h.sync == LINK_STATE || inbox.h.sync == LINK_STATE_ACK) {
+				inboxFill++;
+			}
+		}
+		if (inbox.h.sync == LINK_SYNC) {
+			size = (inbox.h.count == LINK_QUIT) ? 0 : inbox.h.count * sizeof(unsigned short);
+			if (inbox.h.count > LINK_WINDOW && inbox.h.count != LINK_QUIT) {
+				inboxFill = 0;
+			}
+		} else {
+			size = (inbox.h.sync == LINK_STATE) ? inbox.h.count : 0;
+			if (size > STATE_MAX_BYTES) {
+				inboxFill = 0;
+			}
+		}
+	} while (!inboxFill);
+
+	size += sizeof(LINK_HEADER);
+	inboxFill += linkRead((char*)&inbox + inboxFill, size - inboxFill);
+	if (inboxFill < size) {
+		return FALSE;
+	}
+	inboxFill = 0;
+	return TRUE;
+}
+
+// Takes in every packet that has arrived, noting the first tick that was played with a wrong guess; FALSE once
+// the other calculator has left
+static BOOL receivePackets(GAME_STATE* state) {
+	unsigned int i, t;
+
+	while (readPacket()) {
+		lastHeard = state->beatCounter;
+		if (inbox.h.sync == LINK_STATE) {
+			receiveState();
+			continue;
+		}
+		if (inbox.h.sync == LINK_STATE_ACK) {
+			if (findSample(inbox.h.first) != NULL) {
+				baseTick = inbox.h.first;
+				baseAcked = TRUE;
+			}
+			continue;
+		}
+		if (inbox.h.count == LINK_QUIT) {
+			remoteLeft = TRUE;
+			return FALSE;
+		}
+		if (BEFORE(remoteAck, inbox.h.ack)) {
+			remoteAck = inbox.h.ack;
+		}
+
+		for (i = 0, t = inbox.h.first; i < inbox.h.count; i++, t++) {
+			if (t != remoteTicks) {
+				continue; // heard already
+			}
+			if (BEFORE(t, ticks) && remoteKeys[t % LINK_KEYS] != inbox.body.keys[i] && (!mispredicted || BEFORE(t, rollbackFrom))) {
+				mispredicted = TRUE;
+				rollbackFrom = t;
+			}
+			remoteKeys[t % LINK_KEYS] = heardKeys = inbox.body.keys[i];
+			remoteTicks++;
+		}
+	}
+	return TRUE;
+}
+
+// Sends every input of ours the other calculator does not have yet, and how much of its input we have
+static void sendInput(GAME_STATE* state) {
+	LINK_PACKET out;
+	unsigned int i;
+
+	out.h.sync = LINK_SYNC;
+	out.h.count = BEFORE(remoteAck, ticks) ? ticks - remoteAck : 0;
+	out.h.first = remoteAck;
+	out.h.ack = remoteTicks;
+	for (i = 0; i < out.h.count; i++) {
+		out.body.keys[i] = localKeys[(remoteAck + i) % LINK_WINDOW];
+	}
+	linkWrite(&out, sizeof(LINK_HEADER) + out.h.count * sizeof(unsigned short));
+	lastSent = state->beatCounter;
+}
+
+// One round of waiting on the other calculator: read what came in and send ours again about once a clock beat.
+// FALSE if it has left, has not been heard from for LINK_TIMEOUT beats, or ESC is pressed
+static BOOL waitForRemote(GAME_STATE* state) {
+	if (!receivePackets(state) || _keytest(RR_ESC) || state->beatCounter - lastHeard > LINK_TIMEOUT) {
+		return FALSE;
+	}
+	if (state->beatCounter != lastSent) {
+		sendInput(state);
+	}
+	return TRUE;
+}
+
+// Snapshots and plays the next tick: this player's keys, the other player's (or the guess at them) and one clock
+// beat - a linked match runs its clock off the tick count, so both calculators drop items at the same moments
+static void playTick(GAME_STATE* state) {
+	INPUT_FRAME input;
+
+	matchState(snapshots + (ticks % LINK_WINDOW) * snapshotSize, STATE_SAVE);
+
+	if (!BEFORE(ticks, remoteTicks)) {
+		remoteKeys[ticks % LINK_KEYS] = heardKeys;
+	}
+	memset(&input, 0, sizeof(INPUT_FRAME));
+	input.keys[localSlot] = localKeys[ticks % LINK_WINDOW];
+	input.keys[remoteSlot] = remoteKeys[ticks % LINK_KEYS];
+	input.beats = 1;
+
+	sim_step(state, &input);
+	if (ticks && !(ticks % STATE_EVERY)) {
+		takeSample(&sample);
+		sampleTaken = TRUE;
+		sampleFinal = FALSE;
+	}
+	ticks++;
+}
+
+// Goes back to the snapshot before the first wrongly guessed tick and plays up to the present again with what is
+// known now. TRUE if the match ended on the way - it then stays ended on that tick.
+static BOOL rollback(GAME_STATE* state) {
+	unsigned int end = ticks;
+
+	mispredicted = FALSE;
+	ticks = rollbackFrom;
+	matchState(snapshots + (ticks % LINK_WINDOW) * snapshotSize, STATE_LOAD);
+	while (ticks != end) {
+		playTick(state);
+		if (state->result != SIM_RUNNING) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Every player as a LINK_STRUCT, in stage coordinates so it means the same whichever player the camera follows
+static void takeSample(LINK_SAMPLE* s) {
+	PLAYER* p;
+	LINK_STRUCT* l;
+	unsigned int slot;
+
+	memset(s, 0, sizeof(LINK_SAMPLE));
+	s->tick = ticks;
+	for (slot = 0; slot < numPlayers; slot++) {
+		p = PLAYER_SLOT(slot);
+		l = &s->players[slot];
+		l->x = p->x + x_fg;
+		l->y = p->y + y_fg;
+		l->numKills = p->numKills;
+		l->numTimesKilled = p->numTimesKilled;
+		l->moveSpeed = p->moveSpeed;
+		l->xspeed = p->xspeed;
+		l->yspeed = p->yspeed;
+		l->frac = p->frac;
+		l->numLives = p->numLives;
+		l->power = p->power;
+		l->size = p->size;
+		l->characterIndex = p->characterIndex;
+		l->percent = p->percent;
+		l->numJumps = p->numJumps;
+		l->shots = p->shots;
+		l->breathing = p->breathing;
+		l->running = p->running;
+		l->taunting = p->taunting;
+		l->falling = p->falling;
+		l->climbing = p->climbing;
+		l->crouching = p->crouching;
+		l->hanging = p->hanging;
+		l->smashAttacking = p->smashAttacking;
+		l->specialAttacking = p->specialAttacking;
+		l->skyAttacking = p->skyAttacking;
+		l->beingHeld = p->beingHeld;
+		l->grabbing = p->grabbing;
+		l->invincible = p->invincible;
+		l->dead = p->dead;
+		l->paralyzed = p->paralyzed;
+		l->onStage = p->onStage;
+		l->onHillL = p->onHillL;
+		l->onHillR = p->onHillR;
+		l->canFire = p->canFire;
+		l->cloaked = p->cloaked;
+		l->metal = p->metal;
+		l->direction = p->direction;
+		l->team = p->team;
+		l->type = p->type;
+		l->enemyIndex = (p->enemy != NULL) ? p->enemy - p1 : MAX_PLAYERS;
+	}
+}
+
+// Puts a sample's values back into the players (character, team and type are fixed for the match, so they stay)
+static void applySample(const LINK_SAMPLE* s) {
+	PLAYER* p;
+	const LINK_STRUCT* l;
+	unsigned int slot;
+
+	for (slot = 0; slot < numPlayers; slot++) {
+		p = PLAYER_SLOT(slot);
+		l = &s->players[slot];
+		p->x = l->x - x_fg;
+		p->y = l->y - y_fg;
+		p->numKills = l->numKills;
+		p->numTimesKilled = l->numTimesKilled;
+		p->moveSpeed = l->moveSpeed;
+		p->xspeed = l->xspeed;
+		p->yspeed = l->yspeed;
+		p->frac = l->frac;
+		p->numLives = l->numLives;
+		p->power = l->power;
+		p->size = l->size;
+		p->percent = l->percent;
+		p->numJumps = l->numJumps;
+		p->shots = l->shots;
+		p->breathing = l->breathing;
+		p->running = l->running;
+		p->taunting = l->taunting;
+		p->falling = l->falling;
+		p->climbing = l->climbing;
+		p->crouching = l->crouching;
+		p->hanging = l->hanging;
+		p->smashAttacking = l->smashAttacking;
+		p->specialAttacking = l->specialAttacking;
+		p->skyAttacking = l->skyAttacking;
+		p->beingHeld = l->beingHeld;
+		p->grabbing = l->grabbing;
+		p->invincible = l->invincible;
+		p->dead = l->dead;
+		p->paralyzed = l->paralyzed;
+		p->onStage = l->onStage;
+		p->onHillL = l->onHillL;
+		p->onHillR = l->onHillR;
+		p->canFire = l->canFire;
+		p->cloaked = l->cloaked;
+		p->metal = l->metal;
+		p->direction = l->direction;
+		p->enemy = (l->enemyIndex < numPlayers) ? PLAYER_SLOT(l->enemyIndex) : NULL;
+	}
+}
+
+// Once every input up to the latest sample's tick is in, the host sends it and the joining calculator checks it
+static void checkSample(void) {
+	LINK_SAMPLE* truth;
+
+	if (!sampleTaken || sampleFinal || mispredicted || !BEFORE(sample.tick, remoteTicks)) {
+		return;
+	}
+	sampleFinal = TRUE;
+	if (calc == HOST_CALC) {
+		sendState();
+	}
+	if ((truth = findSample(sample.tick)) != NULL) { // (the host only finds its own, which always matches)
+		resync(truth);
+	}
+}
+
+// Sends the final sample as changes from the last one the joining calculator acknowledged (or from zeros)
+static void sendState(void) {
+	LINK_PACKET out;
+	const unsigned short *now, *then;
+	unsigned char* at = out.body.state;
+	unsigned char* mask;
+	unsigned long bits;
+	unsigned int slot, w;
+	LINK_SAMPLE* base = (baseAcked && statesSent % STATE_KEYFRAME) ? findSample(baseTick) : NULL;
+
+	for (slot = 0; slot < numPlayers; slot++) {
+		now = (const unsigned short*)&sample.players[slot];
+		then = (base != NULL) ? (const unsigned short*)&base->players[slot] : NULL;
+		mask = at;
+		at += 3;
+		for (w = 0, bits = 0; w < STATE_WORDS; w++) {
+			if (now[w] != ((then != NULL) ? then[w] : 0)) {
+				bits |= 1UL << w;
+				*at++ = now[w] >> 8;
+				*at++ = now[w];
+			}
+		}
+		mask[0] = bits >> 16, mask[1] = bits >> 8, mask[2] = bits;
+	}
+
+	out.h.sync = LINK_STATE;
+	out.h.count = at - out.body.state;
+	out.h.first = sample.tick;
+	out.h.ack = (base != NULL) ? base->tick : sample.tick; // a sample based on itself is a keyframe
+	linkWrite(&out, sizeof(LINK_HEADER) + out.h.count);
+
+	history[historyNext] = sample; // (only now: it may take the place of the base it was just sent against)
+	historyNext = (historyNext + 1) % STATE_HISTORY;
+	statesSent++;
+}
+
+// Decodes a sample from the host, keeps it as a base for the next ones and acknowledges it
+static void receiveState(void) {
+	LINK_SAMPLE got;
+	LINK_HEADER ack = {LINK_STATE_ACK, 0, 0, 0};
+	LINK_SAMPLE* base = NULL;
+	const unsigned char* at = inbox.body.state;
+	const unsigned char* end = at + inbox.h.count;
+	unsigned short* now;
+	unsigned long bits;
+	unsigned int slot, w;
+
+	if (inbox.h.ack != inbox.h.first && (base = findSample(inbox.h.ack)) == NULL) {
+		return; // its base never arrived - wait for the next keyframe
+	}
+
+	memset(&got, 0, sizeof(LINK_SAMPLE));
+	got.tick = inbox.h.first;
+	for (slot = 0; slot < numPlayers; slot++) {
+		if (base != NULL) {
+			got.players[slot] = base->players[slot];
+		}
+		if (at + 3 > end) {
+			return;
+		}
+		bits = ((unsigned long)at[0] << 16) | ((unsigned long)at[1] << 8) | at[2];
+		at += 3;
+		now = (unsigned short*)&got.players[slot];
+		for (w = 0; w < STATE_WORDS; w++) {
+			if (bits & (1UL << w)) {
+				if (at + 2 > end) {
+					return;
+				}
+				now[w] = (at[0] << 8) | at[1];
+				at += 2;
+			}
+		}
+	}
+
+	history[historyNext] = got;
+	historyNext = (historyNext + 1) % STATE_HISTORY;
+	ack.first = got.tick;
+	linkWrite(&ack, sizeof(LINK_HEADER));
+
+	if (sampleFinal && got.tick == sample.tick) {
+		resync(&got);
+	}
+}
+
+// The host's sample of a tick differs from ours: put its values into the state after that tick and play on from there
+static void resync(const LINK_SAMPLE* truth) {
+	unsigned int after = truth->tick + 1;
+	char* snapshot = snapshots + (after % LINK_WINDOW) * snapshotSize;
+
+	if (!memcmp(truth->players, sample.players, sizeof(sample.players))) {
+		return;
+	}
+	sample = *truth;
+
+	if (after == ticks) {
+		applySample(truth); // nothing played since
+	} else if ((int)(ticks - after) <= LINK_WINDOW) {
+		matchState(snapshot, STATE_LOAD); // (rolled back over straight away, before another tick is played)
+		applySample(truth);
+		matchState(snapshot, STATE_SAVE);
+		if (!mispredicted || BEFORE(after, rollbackFrom)) {
+			mispredicted = TRUE;
+			rollbackFrom = after;
+		}
+	}
+}
+
+// A kept sample by tick, or NULL
+static LINK_SAMPLE* findSample(unsigned int tick) {
+	unsigned int i;
+
+	for (i = 0; i < STATE_HISTORY; i++) {
+		if (history[i].tick == tick) {
+			return &history[i];
+		}
+	}
+	return NULL;
+}
+
+// End of Source File
\ No newline at end of file
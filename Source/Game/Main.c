@@ -34,12 +34,62 @@ HSym charfile2 = HS_NULL;
 HSym charfile3 = HS_NULL;
 HSym extrafile = HS_NULL;
 
+static const unsigned short* frameOffsets[3]; // per tl_charx file, from its FOFS chunk
+
+// The profile is saved a section to a variable: the record (with the name and initials) as profiles\name, the other
+// sections under the same name in folders of their own, as is an Arena quicksave. Only sections that differ from the
+// copy in the archive are written again, so an exit that just moved the win/loss counts rewrites a few bytes of
+// archive, not all of it. Each variable starts with its length and checksum, and one that does not match is ignored.
+//
+// Before sections, profiles\name held the whole PROFILE of the time with no header. Such a profile is imported on
+// load: its record and settings are where they always were at the front (bar the invitational, which came between
+// them), and its story (and unlocks) are still the last fields, just before the variable's extension. The tournament
+// and quicksave it carried are of a layout that is gone, so they are dropped.
+typedef struct profilesection {
+	const char* folder;
+	unsigned short offset; // into PROFILE
+	unsigned short length;
+} PROFILE_SECTION;
+
+typedef struct profilefileheader {
+	unsigned short length;
+	unsigned short checksum;
+} PROFILE_FILE_HEADER;
+
+#define SECTION_FIELDS(__first,__next) offsetof(PROFILE, __first), offsetof(PROFILE, __next) - offsetof(PROFILE, __first)
+#define SECTION_REST(__first)          offsetof(PROFILE, __first), sizeof(PROFILE) - offsetof(PROFILE, __first)
+
+static const PROFILE_SECTION profileSections[] = {
+	{PROFILE_FOLDERNAME, SECTION_FIELDS(name, difficulty)}, // record
+	{"tlsetup", SECTION_FIELDS(difficulty, invitationalID)}, // settings
+	{"tltour", SECTION_FIELDS(invitationalID, classicCharacterDifficultiesDone)}, // tournament
+#ifdef UNLOCK_CHARS
+	{"tlstory", SECTION_FIELDS(classicCharacterDifficultiesDone, playersUnlocked)},
+	{"tlunlock", SECTION_REST(playersUnlocked)}
+#else
+	{"tlstory", SECTION_REST(classicCharacterDifficultiesDone)}
+#endif
+};
+
+#define NUM_PROFILE_SECTIONS (sizeof(profileSections) / sizeof(PROFILE_SECTION))
+
+#define LEGACY_SETTINGS  (offsetof(PROFILE, difficulty) + sizeof(INVITATIONAL_ID)) // the settings of a whole-PROFILE save
+#define SETTINGS_LENGTH  (offsetof(PROFILE, invitationalID) - offsetof(PROFILE, difficulty))
+#define STORY_LENGTH     (sizeof(PROFILE) - offsetof(PROFILE, classicCharacterDifficultiesDone))
+#define LEGACY_EXTENSION 7 // 0, "user", 0, OTH_TAG
+#define LEGACY_MIN_SIZE  (LEGACY_SETTINGS + SETTINGS_LENGTH + 35 * 13 + STORY_LENGTH + LEGACY_EXTENSION) // (35x13 bracket)
+
 static void initializeCharacters(void);
 static void initializeStages(void);
 
+static void mapCharFile(unsigned int file);
+static void* mapChunk(SYM_ENTRY* sym, unsigned long id, unsigned short length);
+static unsigned short packChecksum(const unsigned char* data, unsigned short length);
 static unsigned char* getDataPtr(const char* file, short offset);
 static void archiveFile(const char* file);
 
+static void profileFile(char* file, const char* folder);
+static BOOL importLegacyProfile(void);
 static void saveCurrentProfile(void);
 
 DEFINE_INT_HANDLER(on_handle_interrupt) { // need to reserve a5 register to enable grayscale; save its old state
@@ -56,7 +106,7 @@ DEFINE_INT_HANDLER(on_handle_interrupt) { // need to reserve a5 register to enab
 	asm("move.l %0,%%a5" : : "a"(olda5)); // restore a5 register
 }
 
-// Main Function - Total malloc'ed memory (not including items) = ~54188 bytes
+// Main Function - Total malloc'ed memory (not including items) = ~49772 bytes
 void _main(void)
 {
 	atexit((atexit_t)exitGame); // set onExit interrupt handler (like callbacks in JavaScript)
@@ -81,7 +131,7 @@ void _main(void)
 	
 	// attempt to allocate sufficient memory to start up program: main memory items + external data sprites
 	// provides good speedup to have this allocated in memory directly on startup (which is itself pretty darn fast)
-	if ((mainBlock = malloc(MCARD)) == NULL || (block = malloc(TCARD)) == NULL || (characters = malloc((24 * sizeof(CHARACTER)))) == NULL || (Home = malloc(LCD_SIZE)) == NULL || (profileNameBlock = malloc(45)) == NULL || (tournamentBlock = malloc(GRAY_BIG_VSCREEN_SIZE)) == NULL) {
+	if ((mainBlock = malloc(MCARD)) == NULL || (block = malloc(TCARD)) == NULL || (characters = malloc((24 * sizeof(CHARACTER)))) == NULL || (Home = malloc(LCD_SIZE)) == NULL || (profileNameBlock = malloc(45)) == NULL || (tournamentBlock = malloc(GRAY_BIG_VSCREEN_SIZE + BRACKET_MAP_WIDTH * BRACKET_MAP_HEIGHT)) == NULL) {
 		ST_helpMsg(NOT_ENOUGH_MEM);
 		ER_throw(ER_MEMORY);
 	}
@@ -98,6 +148,9 @@ void _main(void)
 }
 
 void initialize(void) {
+	const char* folder;
+	unsigned int i;
+	
 	initialContrast = *ActiveContrastAddr(); // returns contrast value from the method	
 	setContrast(TI89_CLASSIC ? CON_CLASSIC : CON_TITANIUM); // set to specific contrast for best visuals
 	
@@ -106,15 +159,15 @@ void initialize(void) {
 		if (!HeapGetLock(stagegfx->handle)) { // obtain the file handle and lock for no other modification
 			HeapLock(stagegfx->handle);
 		}
-		dataptr = (EXTERNAL*)((char*)HeapDeref(stagegfx->handle) + 2); // finally, index into the file (its stored struct) with the char* data pointer
+		dataptr = (EXTERNAL*)mapChunk(stagegfx, CHUNK_STAGES, sizeof(EXTERNAL)); // finally, index into the file (its stored struct) with the char* data pointer
 	}
 	
+	// the character files are only locked here: their chunks are mapped the first time one of their characters is drawn
 	chargfx1 = DerefSym(charfile1);
 	if (chargfx1) {
 		if (!HeapGetLock(chargfx1->handle)) {
 			HeapLock(chargfx1->handle);
 		}
-		c1 = (unsigned long*)((char*)HeapDeref(chargfx1->handle) + 2);	
 	}
 	
 	chargfx2 = DerefSym(charfile2);
@@ -122,7 +175,6 @@ void initialize(void) {
 		if (!HeapGetLock(chargfx2->handle)) {
 			HeapLock(chargfx2->handle);
 		}
-		c2 = (unsigned long*)((char*)HeapDeref(chargfx2->handle) + 2);	
 	}
 	
 	chargfx3 = DerefSym(charfile3);
@@ -130,7 +182,6 @@ void initialize(void) {
 		if (!HeapGetLock(chargfx3->handle)) {
 			HeapLock(chargfx3->handle);
 		}
-		c3 = (unsigned long*)((char*)HeapDeref(chargfx3->handle) + 2);
 	}
 	
 	extragfx = DerefSym(extrafile);
@@ -138,7 +189,12 @@ void initialize(void) {
 		if (!HeapGetLock(extragfx->handle)) {
 			HeapLock(extragfx->handle);
 		}
-		extraptr = (EXTRA_EXTERNAL*)((char*)HeapDeref(extragfx->handle) + 2);	
+		extraptr = (EXTRA_EXTERNAL*)mapChunk(extragfx, CHUNK_EXTRA, sizeof(EXTRA_EXTERNAL));
+	}
+	
+	if (dataptr == NULL || chargfx1 == NULL || chargfx2 == NULL || chargfx3 == NULL || extraptr == NULL) {
+		ST_helpMsg(DATA_OUT_OF_DATE); // stale or damaged data files - refuse them rather than read garbage
+		ER_throw(ER_DATATYPE);
 	}
 	
 	// main pointer initializations for loaded structures and allocated memory (with appropriate offsets into the heap)
@@ -149,12 +205,9 @@ void initialize(void) {
 	p3 = (PLAYER*)(((char*)p2) + sizeof(PLAYER));
 	p4 = (PLAYER*)(((char*)p3) + sizeof(PLAYER));
 	timer = (TIMER*)(((char*)p4) + sizeof(PLAYER));
-	p1->myProjectile = (PROJECTILE*)(((char*)timer) + sizeof(TIMER));
-	p2->myProjectile = (PROJECTILE*)(((char*)p1->myProjectile) + sizeof(PROJECTILE));
-	p3->myProjectile = (PROJECTILE*)(((char*)p2->myProjectile) + sizeof(PROJECTILE));
-	p4->myProjectile = (PROJECTILE*)(((char*)p3->myProjectile) + sizeof(PROJECTILE));
+	projectiles = (PROJECTILE*)(((char*)timer) + sizeof(TIMER));
 	
-	masterHand = (HAND*)((char*)p4->myProjectile + sizeof(PROJECTILE));
+	masterHand = (HAND*)((char*)(projectiles + MAX_PROJECTILES));
 	crazyHand = (HAND*)((char*)masterHand + sizeof(HAND));
 		
 	skylight = ((char*)crazyHand + sizeof(HAND));
@@ -186,8 +239,11 @@ void initialize(void) {
 	initializeCharacters();
 	initializeStages();
 	
-	if (FolderFind(SYMSTR(PROFILE_FOLDERNAME)) == NOT_FOUND) {
-		FolderAdd(SYMSTR(PROFILE_FOLDERNAME)); // add/create profiles folder if currently doesn't exist
+	for (i = 0; i <= NUM_PROFILE_SECTIONS; i++) {
+		folder = (i < NUM_PROFILE_SECTIONS) ? profileSections[i].folder : QUICKSAVE_FOLDERNAME;
+		if (FolderFind(SYMSTR(folder)) == NOT_FOUND) {
+			FolderAdd(SYMSTR(folder)); // add/create profiles folders if currently don't exist
+		}
 	}
 
 	save_int_1 = GetIntVec(AUTO_INT_1);
@@ -199,15 +255,23 @@ void initialize(void) {
 
 	LCD_save(Home); // save buffer of Home screen before launching program
 	randomize();
+	seedStream(RNG_MENUS, ((unsigned long)rand() << 16) | rand()); // every other stream is seeded per match from this one
 	if (!GrayOn()) {
 		return;
 	}
+	
+#ifdef BENCHMARK
+	runBenchmark(); // benchmark builds only time the match loop, then quit
+	return;
+#endif
+#ifdef BATCH
+	runBatch(); // batch builds only play the AI balance sweep, then quit
+	return;
+#endif
 
 	doProfileLoadingOrCreating();
 		
-	if (currentProfile.iHaveBattle) {
-		setupLoadedGame(); // if player quit in the middle of a battle, load it up automatically
-	}
+	setupLoadedGame(); // if player quit in the middle of a battle, load it up automatically
 	
 	numPlayers = 2;
 	p1->team = WHITE_TEAM;
@@ -217,54 +281,31 @@ void initialize(void) {
 	mainMenu();
 }
 
-static void initializeCharacters(void) { // set up the animation progressions of frames for each character
-	unsigned int k, p;
+static void initializeCharacters(void) { // physical attributes of every character (frames are resolved per match)
+	unsigned int k;
 	
 	for (k = 0; k < 24; k++) { // all characters
 		characters[k].w = characterWidths[k];
 		characters[k].h = characterHeights[k];
 		characters[k].specialType = charSpecialAttacks[k];
-		
-		for (p = 0; p < 23; p++) { // all animation frames for each character
-			unsigned short soffset = (characterHeights[k]*3*p+offset[k]);
-			characters[k].frames[p].data = (k<8)?c1+soffset:((k>=16)?c3+soffset:c2+soffset);
-		}
-		
-		// facing right frames - set up the linked list of animation frames
-		characters[k].frames[STAND_RIGHT].next = &characters[k].frames[RUN1_RIGHT];
-		characters[k].frames[BREATHE_RIGHT].next = &characters[k].frames[RUN1_RIGHT];
-		characters[k].frames[RUN1_RIGHT].next = &characters[k].frames[RUN2_RIGHT];
-		characters[k].frames[RUN2_RIGHT].next = &characters[k].frames[STAND_RIGHT];
-		
-		characters[k].frames[SMASH_RIGHT].next = &characters[k].frames[STAND_RIGHT];
-		characters[k].frames[SKY_RIGHT].next = &characters[k].frames[STAND_RIGHT];
-		characters[k].frames[SPECIAL_RIGHT].next = &characters[k].frames[STAND_RIGHT];		
-		characters[k].frames[JUMPUP_RIGHT].next = &characters[k].frames[STAND_RIGHT];
-		characters[k].frames[HURT_RIGHT].next = &characters[k].frames[STAND_LEFT];
-		
-		characters[k].frames[CLIMB_RIGHT].next = &characters[k].frames[STAND_RIGHT];
-		
-		// facing left
-		characters[k].frames[STAND_LEFT].next = &characters[k].frames[RUN1_LEFT];
-		characters[k].frames[BREATHE_LEFT].next = &characters[k].frames[RUN1_LEFT];
-		characters[k].frames[RUN1_LEFT].next = &characters[k].frames[RUN2_LEFT];
-		characters[k].frames[RUN2_LEFT].next = &characters[k].frames[STAND_LEFT];
-		
-		characters[k].frames[SMASH_LEFT].next = &characters[k].frames[STAND_LEFT];
-		characters[k].frames[SKY_LEFT].next = &characters[k].frames[STAND_LEFT];
-		characters[k].frames[SPECIAL_LEFT].next = &characters[k].frames[STAND_LEFT];		
-		characters[k].frames[JUMPUP_LEFT].next = &characters[k].frames[STAND_LEFT];
-		characters[k].frames[HURT_LEFT].next = &characters[k].frames[STAND_RIGHT];
-		
-		characters[k].frames[CLIMB_LEFT].next = &characters[k].frames[STAND_LEFT];
-		
-		// crouching and taunting (not facing any specific direction)
-		characters[k].frames[CROUCH].next = &characters[k].frames[STAND_RIGHT];
-		characters[k].frames[TAUNT1].next = &characters[k].frames[TAUNT2];
-		characters[k].frames[TAUNT2].next = &characters[k].frames[STAND_RIGHT];
 	}
 }
 
+unsigned long* characterPortrait(unsigned int k) {
+	return frameData(k, TAUNT1);
+}
+
+// Where one frame of a character's sprites starts in its tl_charx file
+unsigned long* frameData(unsigned int k, unsigned int frame) {
+	unsigned short soffset;
+	
+	if (frameOffsets[k / CHARS_PER_FILE] == NULL) {
+		mapCharFile(k / CHARS_PER_FILE);
+	}
+	soffset = (characterHeights[k]*3*frame+frameOffsets[k / CHARS_PER_FILE][k % CHARS_PER_FILE]);
+	return (k<8)?c1+soffset:((k>=16)?c3+soffset:c2+soffset);
+}
+
 static void initializeStages(void) {
 	unsigned int i = 0;
 	do {
@@ -379,6 +420,66 @@ static unsigned char* getDataPtr(const char* file, short offset) {
 	return (loc + 2 + offset);
 }
 
+// Maps a tl_charx file's sprites and frame offsets. Checksumming the sprites is most of what loading the data files
+// costs, so each file waits for the first of its characters to be drawn instead of holding up startup
+static void mapCharFile(unsigned int file) {
+	SYM_ENTRY* sym = (file == 0) ? chargfx1 : ((file == 1) ? chargfx2 : chargfx3);
+	unsigned long* sprites = (unsigned long*)mapChunk(sym, CHUNK_SPRITES, 0);
+	const unsigned short* offsets = (const unsigned short*)mapChunk(sym, CHUNK_FRAME_OFFSETS, CHARS_PER_FILE * sizeof(unsigned short));
+	
+	if (sprites == NULL || offsets == NULL) {
+		ST_helpMsg(DATA_OUT_OF_DATE); // as at startup: refuse it rather than draw garbage
+		ER_throw(ER_DATATYPE);
+	}
+	
+	if (file == 0) {
+		c1 = sprites;
+	}
+	else if (file == 1) {
+		c2 = sprites;
+	}
+	else {
+		c3 = sprites;
+	}
+	frameOffsets[file] = offsets;
+}
+
+// Finds a chunk in a (locked) asset pack by ID. The pack must be of this game's format version and the chunk must be
+// intact and at least length bytes (0 = any size); otherwise NULL
+static void* mapChunk(SYM_ENTRY* sym, unsigned long id, unsigned short length) {
+	unsigned char* base = (unsigned char*)HeapDeref(sym->handle);
+	unsigned short fileSize = *(unsigned short*)base; // size word of the variable
+	const PACK_HEADER* pack = (const PACK_HEADER*)(base + 2);
+	const PACK_CHUNK* chunk = pack->toc;
+	unsigned long tocEnd = sizeof(PACK_HEADER) + (unsigned long)pack->numChunks * sizeof(PACK_CHUNK);
+	unsigned short i;
+	
+	if (fileSize < sizeof(PACK_HEADER) || pack->magic != PACK_MAGIC || pack->version != PACK_VERSION || tocEnd > fileSize) {
+		return NULL;
+	}
+	
+	for (i = 0; i < pack->numChunks; i++, chunk++) {
+		if (chunk->id == id) {
+			if (chunk->length < length || chunk->offset < tocEnd || (unsigned long)chunk->offset + chunk->length > fileSize || (chunk->offset & 1) || packChecksum((const unsigned char*)pack + chunk->offset, chunk->length) != chunk->checksum) {
+				return NULL;
+			}
+			return (unsigned char*)pack + chunk->offset;
+		}
+	}
+	return NULL; // no such chunk in this file
+}
+
+// Fletcher-style sum of a chunk (the installer computes the same one when writing packs)
+static unsigned short packChecksum(const unsigned char* data, unsigned short length) {
+	unsigned char a = 0, b = 0;
+	
+	while (length--) {
+		a += *data++;
+		b += a;
+	}
+	return ((unsigned short)b << 8) | a;
+}
+
 // Thanks and credit to Fisch2 for these two helper routines
 static void archiveFile(const char* file) { // all files after read/writes should be archived for protection in case of system crashes/RAM clears
 	SYM_ENTRY* sym = NULL;
@@ -402,29 +503,134 @@ void unarchiveFile(const char* file) { // all files, in order to be loaded into
 	}
 }
 
-void saveCurrentProfile(void) {
+// Where the current profile keeps its file in the given folder
+static void profileFile(char* file, const char* folder) {
+	sprintf(file, "%s\\%s", folder, (const char*)currentProfile.name);
+}
+
+// The current profile's file in the given folder, read straight from the archive: NULL if it is missing or damaged,
+// otherwise its contents, with their size in length
+const void* readProfileFile(const char* folder, unsigned int* length) {
+	const PROFILE_FILE_HEADER* saved;
+	unsigned short size;
+	char file[19];
+	
+	profileFile(file, folder);
+	if ((saved = (const PROFILE_FILE_HEADER*)getDataPtr(file, 0)) == NULL) {
+		return NULL;
+	}
+	size = *((const unsigned short*)saved - 1); // size word of the variable
+	if (size < sizeof(PROFILE_FILE_HEADER) || size < sizeof(PROFILE_FILE_HEADER) + saved->length || packChecksum((const unsigned char*)(saved + 1), saved->length) != saved->checksum) {
+		return NULL;
+	}
+	*length = saved->length;
+	return saved + 1;
+}
+
+// Replaces the current profile's file in the given folder with length bytes of data, and archives it; FALSE if
+// there was no room (the copy already on the calculator is then kept)
+BOOL writeProfileFile(const char* folder, const void* data, unsigned int length) {
 	static const unsigned char extension[7] = { 0, 'u', 's', 'e', 'r', 0, OTH_TAG }; // file custom extension
-	unsigned short size = sizeof(PROFILE) + 9; // add space for 8 character name + null terminator (8 characters allowed for TI files)
+	unsigned short size = 2 + sizeof(PROFILE_FILE_HEADER) + length + sizeof(extension); // (size word first)
+	PROFILE_FILE_HEADER* header;
+	char file[19];
 	char* base;
 	HANDLE h;
-
-	if ((h = HeapAlloc(size)) == H_NULL) { // could not allocate space on the heap to write out this profile
-		return;
+	
+	if ((h = HeapAlloc(size)) == H_NULL) { // could not allocate space on the heap to write out this file
+		return FALSE;
 	}
 	
+	profileFile(file, folder);
+	SymDel(SYMSTR(file)); // the old copy, archived or not
+	
 	// note: HeapDeref(H_NULL) == 0xFFFFFFFF
-	if ((base = HeapDeref(DerefSym(SymAdd(SYMSTR((const char*)fileName)))->handle = h)) == (void*)0xFFFFFFFF) {
+	if ((base = HeapDeref(DerefSym(SymAdd(SYMSTR(file)))->handle = h)) == (void*)0xFFFFFFFF) {
 		HeapFree(h);
-		return;
+		return FALSE;
 	} // could not execute write to file, due to null heap reference
 	
-	// write custom profile data to profile VAT file
 	*(short*)base = size - 2;
-	base += 2;
-	memcpy(base, &currentProfile, sizeof(PROFILE));
-	base += sizeof(PROFILE);
-	memcpy(base, extension, sizeof(extension));
-	archiveFile((const char*)fileName); // archive to avoid deletion during crashes and RAM clears
+	header = (PROFILE_FILE_HEADER*)(base + 2);
+	header->length = length;
+	header->checksum = packChecksum((const unsigned char*)data, length);
+	memcpy(header + 1, data, length);
+	memcpy((char*)(header + 1) + length, extension, sizeof(extension));
+	archiveFile(file); // archive to avoid deletion during crashes and RAM clears
+	return TRUE;
+}
+
+// Removes the current profile's file in the given folder, if there is one
+void deleteProfileFile(const char* folder) {
+	char file[19];
+	
+	profileFile(file, folder);
+	SymDel(SYMSTR(file));
+}
+
+// Sets up the named profile: every section that is on the calculator intact is read straight from the archive,
+// and any other keeps the defaults (and is written out on the next save). A profile saved whole by an older version
+// of the game is imported and saved in sections straight away.
+void loadCurrentProfile(const char* name) {
+	const PROFILE_SECTION* section = profileSections;
+	const void* saved;
+	unsigned int i, length;
+	
+	defaultProfile();
+	memset(currentProfile.initials, 0, sizeof(currentProfile.initials));
+	strncpy((char*)currentProfile.name, name, 8);
+	currentProfile.name[8] = 0;
+	sprintf(fileName, "%s\\%s", PROFILE_FOLDERNAME, name);
+	
+	if (readProfileFile(PROFILE_FOLDERNAME, &length) == NULL && importLegacyProfile()) {
+		saveCurrentProfile();
+		return;
+	}
+	
+	for (i = 0; i < NUM_PROFILE_SECTIONS; i++, section++) {
+		if ((saved = readProfileFile(section->folder, &length)) == NULL || length != section->length) {
+			continue; // missing, damaged or from another version of the game
+		}
+		memcpy((char*)&currentProfile + section->offset, saved, length);
+	}
+}
+
+// Reads the current profile's record, settings and story out of a whole-PROFILE save in profiles\name, if that is
+// what is there (see the top of this file)
+static BOOL importLegacyProfile(void) {
+	static const unsigned char extension[LEGACY_EXTENSION] = { 0, 'u', 's', 'e', 'r', 0, OTH_TAG };
+	const unsigned char* saved;
+	unsigned short size;
+	char file[19];
+	
+	profileFile(file, PROFILE_FOLDERNAME);
+	if ((saved = getDataPtr(file, 0)) == NULL) {
+		return FALSE;
+	}
+	size = *((const unsigned short*)saved - 1); // size word of the variable
+	if (size < LEGACY_MIN_SIZE || memcmp(saved + size - LEGACY_EXTENSION, extension, LEGACY_EXTENSION)) {
+		return FALSE; // too short to have been a whole profile, or not a profile at all
+	}
+	
+	memcpy(currentProfile.initials, saved + offsetof(PROFILE, initials), offsetof(PROFILE, difficulty) - offsetof(PROFILE, initials)); // and record
+	memcpy(&currentProfile.difficulty, saved + LEGACY_SETTINGS, SETTINGS_LENGTH);
+	memcpy(currentProfile.classicCharacterDifficultiesDone, saved + size - LEGACY_EXTENSION - STORY_LENGTH, STORY_LENGTH);
+	return TRUE;
+}
+
+// Writes out each section of the current profile that differs from its copy in the archive; the others are left alone
+void saveCurrentProfile(void) {
+	const PROFILE_SECTION* section = profileSections;
+	const void* saved;
+	unsigned int i, length;
+	
+	for (i = 0; i < NUM_PROFILE_SECTIONS; i++, section++) {
+		if ((saved = readProfileFile(section->folder, &length)) != NULL && length == section->length
+			&& !memcmp(saved, (char*)&currentProfile + section->offset, length)) {
+			continue; // unchanged
+		}
+		writeProfileFile(section->folder, (char*)&currentProfile + section->offset, section->length);
+	}
 }
 
 // interrupt handler called when player wants to exit the game
@@ -40,10 +40,10 @@ static unsigned int option = 1, cursor = 1; // episode mode
 
 // Tournament mode variables
 unsigned int numBattles = 0; // tournament mode
-unsigned int fighter1, fighter2;
+static unsigned int matchNode; // the bracket node the current match decides - its fighters are in nodes 2n+1 and 2n+2
+static BOOL humanFighting; // the human is always the top entrant, so fights the first match of every round
 BOOL playerLost, playerWon;
 Plane bracketPlane;
-static const unsigned int maxRoundBattles[4] = { 8, 4, 2, 1 };
 
 // Profile Variables
 int numProfiles = 0;
@@ -200,17 +200,14 @@ static void tournamentMenu(void);
 static void drawTournamentMenu(void);
 static void drawRoundScreen(void);
 static BOOL prepScreen(void);
+static void pickTournamentStage(void);
+static void advanceWinner(void);
 static void renderBracket(void);
+static void buildBracketMap(void);
+static inline unsigned int bracketRow(unsigned int round, unsigned int index);
+static unsigned int bracketX(unsigned int round);
 static BOOL invitationalMenu(void);
 static void drawInvitationalMenu(unsigned int choice);
-static unsigned int round0LayoutReturn(void);
-static unsigned int round1LayoutReturn(void);
-static unsigned int round2LayoutReturn(void);
-static unsigned int (*roundReturnMethods[3])(void) = {
-	round0LayoutReturn,
-	round1LayoutReturn,
-	round2LayoutReturn
-};
 
 // Options Menu
 static void optionsMenu(void);
@@ -231,9 +228,6 @@ static void drawLoadProfileScreen(void);
 static void loadProfileScreen(void);
 static void profileScreen(void);
 
-// Link Play Menu Functions
-static char establishConnection(void);
-
 
 static inline void waitForKeyReleased(void) {
 	while (_rowread(0)); // don't need more than one test - this covers the whole keyboard! (no separate test for esc)
@@ -398,7 +392,7 @@ static BOOL stageSelectMenu(void) { // hand-cursor-moving-type menu
 			return TRUE;
 		}
 		if (_keytest(RR_DIAMOND)) {
-			stageIndex = (char)random(NUM_STAGES);
+			stageIndex = (char)randomFrom(RNG_MENUS, NUM_STAGES);
 			if (linked) {
 				stagesHostPress = STAGES_COMPLETE;
 			}
@@ -518,9 +512,9 @@ static BOOL characterSelectMenu(void) {
 			}			
 			if (_keytest(RR_DIAMOND)) { // select random character
 				if (!linked || (linked && calc == HOST_CALC)) {
-					p1->characterIndex = random(NUM_CHARS);
+					p1->characterIndex = randomFrom(RNG_MENUS, NUM_CHARS);
 				} else if (linked && calc == JOIN_CALC) {
-					p2->characterIndex = random(NUM_CHARS);
+					p2->characterIndex = randomFrom(RNG_MENUS, NUM_CHARS);
 				}
 				characterSelected = TRUE;
 				
@@ -623,30 +617,30 @@ static BOOL characterSelectMenu(void) {
 			
 		if (!linked && characterSelected) { // select the AI characters
 			if (numPlayers > 1) {
-				p2->characterIndex = random(NUM_CHARS), charsSelected[1] = characters[p2->characterIndex].frames[TAUNT1].data, charHeights[1] = characters[p2->characterIndex].h;
+				p2->characterIndex = randomFrom(RNG_MENUS, NUM_CHARS), charsSelected[1] = characterPortrait(p2->characterIndex), charHeights[1] = characters[p2->characterIndex].h;
 			}
 			if (numPlayers > 2) {
-				p3->characterIndex = random(NUM_CHARS),charsSelected[2] = characters[p3->characterIndex].frames[TAUNT1].data,charHeights[2] = characters[p3->characterIndex].h;
+				p3->characterIndex = randomFrom(RNG_MENUS, NUM_CHARS),charsSelected[2] = characterPortrait(p3->characterIndex),charHeights[2] = characters[p3->characterIndex].h;
 			}
 			if (numPlayers > 3) {
-				p4->characterIndex = random(NUM_CHARS),charsSelected[3] = characters[p4->characterIndex].frames[TAUNT1].data,charHeights[3] = characters[p4->characterIndex].h;
+				p4->characterIndex = randomFrom(RNG_MENUS, NUM_CHARS),charsSelected[3] = characterPortrait(p4->characterIndex),charHeights[3] = characters[p4->characterIndex].h;
 			}
 		}
 		
 		if (!linked || (linked && hostSelected > 0)) {
-	  		charsSelected[0] = characters[p1->characterIndex].frames[TAUNT1].data; // set up Player 1
+	  		charsSelected[0] = characterPortrait(p1->characterIndex); // set up Player 1
 			charHeights[0] = characters[p1->characterIndex].h;
 	 	}
 	 	if (linked && joinSelected > 0) {
-	 		charsSelected[1] = characters[p2->characterIndex].frames[TAUNT1].data; // set up Player 2
+	 		charsSelected[1] = characterPortrait(p2->characterIndex); // set up Player 2
 			charHeights[1] = characters[p2->characterIndex].h;
 	 	}
 	 	if (linked && hostSelected > 0 && numPlayers > 2) {
-	 		charsSelected[2] = characters[p3->characterIndex].frames[TAUNT1].data; // set up Player 3
+	 		charsSelected[2] = characterPortrait(p3->characterIndex); // set up Player 3
 			charHeights[2] = characters[p3->characterIndex].h;
 	 	}
 	 	if (linked && hostSelected > 0 && numPlayers > 3) {
-	 		charsSelected[3] = characters[p4->characterIndex].frames[TAUNT1].data; // set up Player 4
+	 		charsSelected[3] = characterPortrait(p4->characterIndex); // set up Player 4
 			charHeights[3] = characters[p4->characterIndex].h;
 	 	}
 		
@@ -664,10 +658,10 @@ static void handleLinkportKeypressCharMenu(void) {
 		hostSelected = 1;
 		
 		if (numPlayers > 2) {
-			p3->characterIndex = p3Index = random(NUM_CHARS);
+			p3->characterIndex = p3Index = randomFrom(RNG_MENUS, NUM_CHARS);
 		}
 		if (numPlayers > 3) {
-			p4->characterIndex = p4Index = random(NUM_CHARS);
+			p4->characterIndex = p4Index = randomFrom(RNG_MENUS, NUM_CHARS);
 		}
 		
 		char hostLinkInfo[4] = { hostSelected, p1->characterIndex, p3Index, p4Index };
@@ -923,7 +917,9 @@ static void howManyUsersMenu(void) {
 					break;
 					
 					case SUCCESSFUL: // if reaches here, then should all be good (failure = comes back to howManyUsersMenu)
-					doGame();					
+					if (characterSelectMenu() && (calc == JOIN_CALC || stageSelectMenu())) { // the host's stage comes with the match setup
+						doGame();
+					}
 					OSLinkClose();
 					linked = FALSE;
 					break;
@@ -939,6 +935,10 @@ static void howManyUsersMenu(void) {
 				}
 			}
 		}		
+		if (_keytest(RR_F5)) { // watch the last single calculator match again
+			waitForKeyReleased();
+			doReplay();
+		}
 		if (_keytest(RR_ESC)) {
 			return;
 		}
@@ -1046,7 +1046,7 @@ static void storyMode(void) {
 			doPointsStuff();
 		}
 		
-		p2->characterIndex = random(24), p3->characterIndex = random(24), p4->characterIndex = random(24);
+		p2->characterIndex = randomFrom(RNG_MENUS, 24), p3->characterIndex = randomFrom(RNG_MENUS, 24), p4->characterIndex = randomFrom(RNG_MENUS, 24);
 		
 		p1ClassicLives = p1->numLives; // reset number of lives after each round that player survives
 		battleCounter++;
@@ -1079,12 +1079,12 @@ static void storyMode(void) {
 static void generateStoryModeList(void) {
 	int c = 0;	
 	do {
-		storyModeStages[c] = random(NUM_STAGES);
+		storyModeStages[c] = randomFrom(RNG_MENUS, NUM_STAGES);
 		if (c > 0) {
 			int c2 = 0;
 			while (c2 < c) {
 				if (storyModeStages[c2] == storyModeStages[c]) { // if duplicate found, start the loop over and do another random number
-					storyModeStages[c] = random(NUM_STAGES), c2 = -1;
+					storyModeStages[c] = randomFrom(RNG_MENUS, NUM_STAGES), c2 = -1;
 				}
 				c2++;
 			}
@@ -1246,7 +1246,7 @@ static void drawEpisodeMenu(void) {
 	
 	unsigned i = 0; // this will eventually use the profile data to tell which to display
 	do {
-		GraySprite8_TRANB_R(4,(i*9)+21,4,episodeMarker[random(2)],episodeMarker[random(2)]+4,v2,v3);
+		GraySprite8_TRANB_R(4,(i*9)+21,4,episodeMarker[randomFrom(RNG_MENUS, 2)],episodeMarker[randomFrom(RNG_MENUS, 2)]+4,v2,v3);
 		i++;
 	} while (i < 5);
 	
@@ -1286,7 +1286,7 @@ static void evaluationScreen(void) {
 static void tournamentMenu(void) {
 	waitForKeyReleased();
 	savePlayers = numPlayers;
-	fighter1 = 0, fighter2 = 1; // 0 is the only human player in a tournament
+	numBattles = 0; // a saved tournament always picks up at the human's match, the first of the round
 	playerLost = FALSE, playerWon = FALSE;
 
 	if (!currentProfile.iHaveTournament) {
@@ -1311,7 +1311,8 @@ static void tournamentMenu(void) {
 			}
 			if (_keytest(RR_2ND)) { // select the current option
 				currentProfile.roundNum = 0;
-				memmove(&currentProfile.tourBracketLayout,&extraptr->bracketLayout,455); // sets this to a blank bracket
+				currentProfile.tQuickCPU = FALSE; // CPU matches are watched until asked otherwise on the prep screen
+				memset(currentProfile.tourBracket,NONE,BRACKET_NODES); // sets this to a blank bracket
 				
 				switch (choice) {
 					case 0: // new tournament - initialize all fields			
@@ -1325,16 +1326,15 @@ static void tournamentMenu(void) {
 						break;
 					}
 					
-					currentProfile.tourBracketLayout[0][2] = currentProfile.characterIndexes[0] = p1->characterIndex;
-					unsigned int i = 1, y = 2;
+					currentProfile.tourBracket[BRACKET_ENTRANTS - 1] = p1->characterIndex; // the entrants are the last row of the tree
+					unsigned int i = 1;
 					do {
-						currentProfile.tourBracketLayout[y][2] = currentProfile.characterIndexes[i] = (char)random(24);
-						y+=2, i++;
-					} while (i < 16);
+						currentProfile.tourBracket[BRACKET_ENTRANTS - 1 + i] = (char)randomFrom(RNG_MENUS, 24);
+					} while (++i < BRACKET_ENTRANTS);
 					
 					numPlayers = 2;
-					bracketPlane.matrix = currentProfile.tourBracketLayout;  
-					bracketPlane.width = 13;
+					bracketPlane.matrix = BRACKET_MAP;  
+					bracketPlane.width = BRACKET_MAP_WIDTH;
 					bracketPlane.sprites = extraptr->tournamentTiles;
 					bracketPlane.big_vscreen = tournamentBlock;
 					bracketPlane.force_update = 1;
@@ -1352,17 +1352,16 @@ static void tournamentMenu(void) {
 						break;
 					}
 					
-					currentProfile.tourBracketLayout[0][2] = currentProfile.characterIndexes[0] = p1->characterIndex;
+					currentProfile.tourBracket[BRACKET_ENTRANTS - 1] = p1->characterIndex;
 					
-					i = 1, y = 2; // this is only for creating a tournament - not for invitationals
+					i = 1; // invitationals list 15 opponents - any more places in a bigger bracket are drawn at random
 					do {
-						currentProfile.tourBracketLayout[y][2] = currentProfile.characterIndexes[i] = (extraptr->invitationalList[currentProfile.invitationalID]).opponents[i - 1];
-						y+=2, i++;
-					} while (i < 16); // make sure this doesn't go out of bounds
+						currentProfile.tourBracket[BRACKET_ENTRANTS - 1 + i] = (i <= 15) ? (char)(extraptr->invitationalList[currentProfile.invitationalID]).opponents[i - 1] : (char)randomFrom(RNG_MENUS, 24);
+					} while (++i < BRACKET_ENTRANTS);
 					
 					numPlayers = 2;
-					bracketPlane.matrix = currentProfile.tourBracketLayout;  
-					bracketPlane.width = 13;
+					bracketPlane.matrix = BRACKET_MAP;  
+					bracketPlane.width = BRACKET_MAP_WIDTH;
 					bracketPlane.sprites = extraptr->tournamentTiles;
 					bracketPlane.big_vscreen = tournamentBlock;
 					bracketPlane.force_update = 1;
@@ -1381,8 +1380,8 @@ static void tournamentMenu(void) {
 	}
 	
 	numPlayers = 2;
-	bracketPlane.matrix = currentProfile.tourBracketLayout;  
-	bracketPlane.width = 13;
+	bracketPlane.matrix = BRACKET_MAP;  
+	bracketPlane.width = BRACKET_MAP_WIDTH;
 	bracketPlane.sprites = extraptr->tournamentTiles;
 	bracketPlane.big_vscreen = tournamentBlock;
 	bracketPlane.force_update = 1;
@@ -1410,10 +1409,11 @@ static void drawRoundScreen(void) {
 
 // animations for the bracket for all tournament matches - the main loop
 static void renderBracket(void)	{
-	unsigned int x_fg = 0, y_fg = 0;
+	unsigned int x_fg = bracketX(currentProfile.roundNum), y_fg = 0;
 	BOOL scrolling = FALSE;
 	BOOL updating = TRUE;
 	
+	buildBracketMap();
   	do {
     	if (!numBattles && updating) {
 			drawRoundScreen();
@@ -1422,7 +1422,7 @@ static void renderBracket(void)	{
 	    	DrawGrayPlane(x_fg,y_fg,&bracketPlane,v2,v3,TM_GRPLC89,TM_G16B);
   			copyScreens();
 					
-			if ((scrolling = (y_fg < (currentProfile.roundNum == 0 ? (numBattles << 6) : currentProfile.roundNum == 1 ? (numBattles << 7) + 16 : currentProfile.roundNum == 2 ? (numBattles * 256 + 48) : 112)))) {
+			if ((scrolling = (y_fg < (bracketRow(currentProfile.roundNum,numBattles<<1) << 4)))) { // down to this match's upper fighter
 				y_fg+=2;
 			} else {
 				WaitForMillis(2000);
@@ -1430,6 +1430,7 @@ static void renderBracket(void)	{
 	    		if (!prepScreen()) {
 	    			return;
 				}
+				buildBracketMap(); // with the winner moved on
 			}
 		}
 	    
@@ -1444,13 +1445,9 @@ static void renderBracket(void)	{
 	    	while (!_rowread(0)); // wait for any keypress
 	    	break;
 	    }	    
-	    if (numBattles == maxRoundBattles[currentProfile.roundNum]) { // reached max num battles - move on to next round
+	    if (numBattles == (BRACKET_ENTRANTS >> (currentProfile.roundNum + 1))) { // reached max num battles - move on to next round
 	    	currentProfile.roundNum++, updating = TRUE, numBattles = 0, y_fg = 0;
-	    	if (currentProfile.roundNum == 2) {
-	    		x_fg = 32;
-			} else if (currentProfile.roundNum == 3) {
-	    		x_fg = 48, y_fg = 112;
-			}
+	    	x_fg = bracketX(currentProfile.roundNum);
 	    }	    
 	    if (playerLost) { // tell the player that he or she has lost the tournament
 	    	currentProfile.iHaveTournament = FALSE, numPlayers = savePlayers, currentProfile.invitationalID = NONE;
@@ -1469,30 +1466,28 @@ static void renderBracket(void)	{
 // preparation screen showing all characters before any battle
 static BOOL prepScreen(void) {
 	waitForKeyReleased();
-	if (currentProfile.roundNum > 0) {
-		BOOL p1Found = FALSE;
-		unsigned int i = (currentProfile.roundNum==1?(numBattles<<2):(currentProfile.roundNum==2?(numBattles<<3):0));
-		do {			
-			if (p1Found && currentProfile.characterIndexes[i] > -1) {
-				fighter2 = i;
-				break;
-			}
-			if (!p1Found && currentProfile.characterIndexes[i] > -1) {
-				fighter1 = i;
-				p1Found = TRUE;
-			}			
-			i++;
-		} while (i < 16);		
-	}
+	matchNode = (BRACKET_ENTRANTS >> (currentProfile.roundNum + 1)) - 1 + numBattles; // a round's matches, top to bottom
+	humanFighting = !numBattles;
 	
 	p1->type = CPU;
-	if (!fighter1) {
+	if (humanFighting) {
 		p1->type = HUMAN;
 	}
 	p2->type = CPU; // p2 is always the computer player, no matter the fight
 	
-	p1->characterIndex = currentProfile.characterIndexes[fighter1];
-	p2->characterIndex = currentProfile.characterIndexes[fighter2];
+	p1->characterIndex = currentProfile.tourBracket[matchNode * 2 + 1];
+	p2->characterIndex = currentProfile.tourBracket[matchNode * 2 + 2];
+	
+	if (!humanFighting && currentProfile.tQuickCPU) { // nobody to watch - play it out headless and just move the winner on
+		drawScreen(powbufferlight);
+		GrayDrawStrExt2B(44,45,"CPU MATCH",A_NORMAL,F_8x10,v2,v3);
+		copyScreens();
+		
+		pickTournamentStage();
+		doQuickGame();
+		advanceWinner();
+		return TRUE;
+	}
 	
 	do {
 		drawScreen(skylight);
@@ -1500,79 +1495,50 @@ static BOOL prepScreen(void) {
 		drawCustomFontString(44,6,(unsigned char*)"GET READY");		
 		drawCustomFontString(36,24,(unsigned char*)"P1");
 		drawCustomFontString(116,24,(unsigned char*)"P2");
+		GrayDrawStr2B(24,80,currentProfile.tQuickCPU ? "F1: Watch CPU Matches" : "F1: Quick CPU Matches",A_NORMAL,v2,v3);
 		drawCustomFontString(8,90,(unsigned char*)"PRESS 2ND TO START");
 		
-		GraySprite32_SMASK_R(24,34,characters[p1->characterIndex].h,characters[p1->characterIndex].frames[TAUNT1].data,characters[p1->characterIndex].frames[TAUNT1].data+characters[p1->characterIndex].h,characters[p1->characterIndex].frames[TAUNT1].data+2*characters[p1->characterIndex].h,v2,v3);
-		GraySprite32_SMASK_R(104,34,characters[p2->characterIndex].h,characters[p2->characterIndex].frames[TAUNT1].data,characters[p2->characterIndex].frames[TAUNT1].data+characters[p2->characterIndex].h,characters[p2->characterIndex].frames[TAUNT1].data+2*characters[p2->characterIndex].h,v2,v3);
+		GraySprite32_SMASK_R(24,34,characters[p1->characterIndex].h,characterPortrait(p1->characterIndex),characterPortrait(p1->characterIndex)+characters[p1->characterIndex].h,characterPortrait(p1->characterIndex)+2*characters[p1->characterIndex].h,v2,v3);
+		GraySprite32_SMASK_R(104,34,characters[p2->characterIndex].h,characterPortrait(p2->characterIndex),characterPortrait(p2->characterIndex)+characters[p2->characterIndex].h,characterPortrait(p2->characterIndex)+2*characters[p2->characterIndex].h,v2,v3);
 		copyScreens();
 		
+		if (_keytest(RR_F1)) { // for the rest of this tournament, CPU-only matches are either watched or played out headless
+			waitForKeyReleased();
+			currentProfile.tQuickCPU = !currentProfile.tQuickCPU;
+			if (!humanFighting && currentProfile.tQuickCPU) {
+				return prepScreen(); // this match too
+			}
+			continue;
+		}
 		if (_keytest(RR_2ND)) // endless here - soon, need to add to it
 			{
 			// start the game - either watch, or play if one of the indexes (not characterIndex) of tour is 0				
 			
-			if (currentProfile.tStageSelect == ALL_SELECT) {
-				stageSelectMenu(); // don't worry about stageSelect return value here - user cannot quit tournament mode
-			} else if (currentProfile.tStageSelect == ONE_SELECT) {
-				if (!currentProfile.roundNum && !numBattles && currentProfile.invitationalID < 0) {
-					stageSelectMenu();
-					currentProfile.savedStage = stageIndex;
-				} else {
-					stageIndex = currentProfile.savedStage;				
-				}
-			} else if (currentProfile.tStageSelect == ALL_RANDOM || (currentProfile.tStageSelect == ONE_RANDOM && !currentProfile.roundNum && !numBattles)) {
-				stageIndex = (char)random(26);
-			}
-			
+			pickTournamentStage();
 			doGame();
 			
-			// tests for victory and eliminates the loser player
-			if (!fighter1) {
-				if (p1->team == winningTeam) {
-					if (currentProfile.roundNum > 2) {
-						currentProfile.numTournamentWins++, playerWon = TRUE;
-						break;
-					}
-					currentProfile.numTournamentWins++;
-					currentProfile.tourBracketLayout[roundReturnMethods[currentProfile.roundNum]()][currentProfile.roundNum*3+5] = (char)currentProfile.characterIndexes[fighter1];
-					currentProfile.characterIndexes[fighter2] = -1; // eliminate player from tourny (p2)
-				} else {// p1 lost the game (as a human), so exit the tournament
+			// tests for victory and moves the winner on
+			if (humanFighting) {
+				if (p1->team != winningTeam) { // p1 lost the game (as a human), so exit the tournament
 					currentProfile.numTournamentLosses++, playerLost = TRUE;
+					break;
 				}
-    			break;
-			} else {
-				if (p1->team == winningTeam) {
-					currentProfile.characterIndexes[fighter2] = -1, currentProfile.tourBracketLayout[roundReturnMethods[currentProfile.roundNum]()][currentProfile.roundNum*3+5] = (char)currentProfile.characterIndexes[fighter1];
-				} else {// p2 won
-					currentProfile.characterIndexes[fighter1] = -1, currentProfile.tourBracketLayout[roundReturnMethods[currentProfile.roundNum]()][currentProfile.roundNum*3+5] = (char)currentProfile.characterIndexes[fighter2];
-				}
-			}			
-			numBattles++;
-			
-			if (!currentProfile.roundNum) {
-				fighter1+=2;
-				fighter2+=2; // increment to next battle
-			}					
+				currentProfile.numTournamentWins++;
+				playerWon = (matchNode == 0); // that was the final
+			}
+			advanceWinner();
 			break;
 		}
 		if (_keytest(RR_ESC)) // exit the tournament/skip a battle
 			{
 			// if not player1 (human) in this fight, ignore
-			if (!fighter1) {
+			if (humanFighting) {
 				currentProfile.iHaveTournament = TRUE;
 				return FALSE;
 			} else {
 				// simulates the game between two cpus
-				winningTeam = random(2);
-				if (winningTeam) {
-					currentProfile.characterIndexes[fighter2] = -1, currentProfile.tourBracketLayout[roundReturnMethods[currentProfile.roundNum]()][currentProfile.roundNum*3+5] = (char)currentProfile.characterIndexes[fighter1];
-				} else {
-					currentProfile.characterIndexes[fighter1] = -1, currentProfile.tourBracketLayout[roundReturnMethods[currentProfile.roundNum]()][currentProfile.roundNum*3+5] = (char)currentProfile.characterIndexes[fighter2];
-				}
-				numBattles++;
-				
-				if (!currentProfile.roundNum) {
-					fighter1+=2, fighter2+=2; // increment to next battle
-				}
+				winningTeam = randomFrom(RNG_MENUS, 2) ? p1->team : p2->team;
+				advanceWinner();
 			}
 			break;
 		}
@@ -1581,17 +1547,79 @@ static BOOL prepScreen(void) {
 	return TRUE;
 }
 
+// sets stageIndex for the coming match from the tournament's stage select setting (CPU matches played out headless
+// pick at random rather than stop for the stage select menu)
+static void pickTournamentStage(void) {
+	if (currentProfile.tStageSelect == ALL_SELECT && (humanFighting || !currentProfile.tQuickCPU)) {
+		stageSelectMenu(); // don't worry about stageSelect return value here - user cannot quit tournament mode
+	} else if (currentProfile.tStageSelect == ONE_SELECT) {
+		if (!currentProfile.roundNum && !numBattles && currentProfile.invitationalID < 0) {
+			stageSelectMenu();
+			currentProfile.savedStage = stageIndex;
+		} else {
+			stageIndex = currentProfile.savedStage;				
+		}
+	} else if (currentProfile.tStageSelect != ONE_RANDOM || (!currentProfile.roundNum && !numBattles)) {
+		stageIndex = (char)randomFrom(RNG_MENUS, 26);
+	}
+}
+
+// the winner of the match goes on to the next round of the bracket (the loser just stays behind in the last one)
+static void advanceWinner(void) {
+	currentProfile.tourBracket[matchNode] = (char)((p1->team == winningTeam) ? p1->characterIndex : p2->characterIndex);
+	numBattles++;
+}
+
 // Bracket drawing methods
-static unsigned int round0LayoutReturn(void) {
-	return (numBattles<<2)+1;
+
+// Lays the bracket tree out as tiles behind bracketPlane: every round is a column, three tiles on from the last, with
+// each fighter on a line of its own, joined to its opponent by a line down the right side (the winner's place in the
+// next round is level with the middle of it). Fighters not decided yet are left as just the line.
+static void buildBracketMap(void) {
+	char (*map)[BRACKET_MAP_WIDTH] = (char (*)[BRACKET_MAP_WIDTH])BRACKET_MAP;
+	unsigned int round = 0, index, row, col, y;
+	int fighter;
+	
+	memset(map,BRACKET_TILE_BACK,BRACKET_MAP_WIDTH * BRACKET_MAP_HEIGHT);
+	do {
+		col = round * 3 + 2;
+		for (index = 0; index < (BRACKET_ENTRANTS >> round); index++) {
+			row = bracketRow(round,index);
+			fighter = currentProfile.tourBracket[(BRACKET_ENTRANTS >> round) - 1 + index];
+			
+			map[row][col-1] = BRACKET_TILE_BOTTOM;
+			map[row][col] = (fighter > NONE) ? (char)fighter : BRACKET_TILE_BOTTOM; // character tiles come first in the set
+			map[row+1][col-1] = map[row+1][col] = BRACKET_TILE_TOP;
+			if (index & 1) { // lower of the two - the line down from the upper one ends here
+				map[row][col+1] = BRACKET_TILE_RIGHT_BOTTOM;
+				map[row+1][col+1] = BRACKET_TILE_TOP;
+			} else {
+				map[row][col+1] = BRACKET_TILE_BOTTOM;
+				map[row+1][col+1] = BRACKET_TILE_RIGHT_TOP;
+				for (y = row + 2; y < row + (2 << round); y++) {
+					map[y][col+1] = BRACKET_TILE_RIGHT;
+				}
+			}
+		}
+	} while (++round < BRACKET_ROUNDS);
+	
+	bracketPlane.force_update = 1;
 }
 
-static unsigned int round1LayoutReturn(void) {
-	return (numBattles<<3)+3;
+// tile row of a round's fighter (0 at the top): the first round's are every other row, and each round after that
+// sits halfway between the two it came from
+static inline unsigned int bracketRow(unsigned int round, unsigned int index) {
+	return (index << (round + 1)) + (1 << round) - 1;
 }
 
-static unsigned int round2LayoutReturn(void) {
-	return (numBattles<<4)+7;
+// horizontal scroll that shows a round's column a little left of center, without running off the bracket
+static unsigned int bracketX(unsigned int round) {
+	int x = ((round * 3 + 2) << 4) - 96;
+	
+	if (x > (BRACKET_MAP_WIDTH << 4) - 160) {
+		x = (BRACKET_MAP_WIDTH << 4) - 160;
+	}
+	return (x < 0) ? 0 : x;
 }
 
 // Invitational mode menu - predefined tournaments
@@ -2163,7 +2191,12 @@ static void createProfileScreen(void) {
 	memcpy(&currentProfile.initials,buffer2,3);
 	
 	sprintf(fileName,"profiles\\%s",currentProfile.name);
-	
+	defaultProfile();
+	goAheadAndSave = TRUE;
+}
+
+// Everything but the name and initials of a new profile (and what a loaded one keeps where a section is missing)
+void defaultProfile(void) {
 	currentProfile.numWins = 0, currentProfile.numLosses = 0;
 	currentProfile.numTournamentWins = 0, currentProfile.numTournamentLosses = 0;
 	currentProfile.numSuddenDeathWins = 0, currentProfile.numSuddenDeathLosses = 0;
@@ -2181,14 +2214,12 @@ static void createProfileScreen(void) {
 	currentProfile.roundNum = 0;
 	
 	currentProfile.iHaveTournament = FALSE;
-	currentProfile.iHaveBattle = FALSE;
+	currentProfile.tQuickCPU = FALSE;
 	
-	memcpy(&currentProfile.tourBracketLayout,&extraptr->bracketLayout,455);
+	memset(currentProfile.tourBracket,NONE,BRACKET_NODES);
 	
 	memset(&currentProfile.classicCharacterDifficultiesDone,11,24*sizeof(unsigned int));
 	memset(&currentProfile.classicCharacterHighScores,0,24*sizeof(unsigned long));
-	
-	goAheadAndSave = TRUE;
 }
 
 static void drawCreateProfileScreen(char* buffer, short width, PROFILE_ENTRY whatToEnter) {
@@ -2239,17 +2270,9 @@ static void loadProfileScreen(void) {
 				}
 			}
 			
-			// load the current profile after unarchiving it			
-			sprintf(fileName,"profiles\\%s",profileNames[choice]);
-			unarchiveFile((const char*)fileName);
-			SYM_ENTRY* mySym = DerefSym(SymFind(SYMSTR((const char*)fileName)));
-			if (mySym) {
-				PROFILE* load = (PROFILE*)((char*)HeapDeref(mySym->handle)+2);
-				currentProfile = *load;
-				SymDel(SYMSTR((const char*)fileName)); // overwrite the current file if it exists
-				goAheadAndSave = TRUE;
-				return;
-			}			
+			loadCurrentProfile((const char*)profileNames[choice]); // read straight from the archive - only changes are written back
+			goAheadAndSave = TRUE;
+			return;
 		}
 		if (_keytest(RR_ESC)) {
 			goAheadAndSave = FALSE;
@@ -2339,13 +2362,13 @@ void VSScreen(void) {
 	if (mode == ARENA_MODE) {
 		GraySprite32_SMASK_R(20,16,charHeights[0],charsSelected[0],charsSelected[0]+charHeights[0],charsSelected[0]+(charHeights[0]<<1),v2,v3);
 	} else {
-		GraySprite32_SMASK_R(20,16,characters[p1->characterIndex].h,characters[p1->characterIndex].frames[TAUNT1].data,characters[p1->characterIndex].frames[TAUNT1].data+characters[p1->characterIndex].h,characters[p1->characterIndex].frames[TAUNT1].data+2*characters[p1->characterIndex].h,v2,v3);
+		GraySprite32_SMASK_R(20,16,characters[p1->characterIndex].h,characterPortrait(p1->characterIndex),characterPortrait(p1->characterIndex)+characters[p1->characterIndex].h,characterPortrait(p1->characterIndex)+2*characters[p1->characterIndex].h,v2,v3);
 	}
 	
 	if (mode == ARENA_MODE) {
 		GraySprite32_SMASK_R(20,50,charHeights[1],charsSelected[1],charsSelected[1]+charHeights[1],charsSelected[1]+(charHeights[1]<<1),v2,v3);
 	} else {
-		GraySprite32_SMASK_R(20,50,characters[p2->characterIndex].h,characters[p2->characterIndex].frames[TAUNT1].data,characters[p2->characterIndex].frames[TAUNT1].data+characters[p2->characterIndex].h,characters[p2->characterIndex].frames[TAUNT1].data+2*characters[p2->characterIndex].h,v2,v3);
+		GraySprite32_SMASK_R(20,50,characters[p2->characterIndex].h,characterPortrait(p2->characterIndex),characterPortrait(p2->characterIndex)+characters[p2->characterIndex].h,characterPortrait(p2->characterIndex)+2*characters[p2->characterIndex].h,v2,v3);
 	}
 
 	if (numPlayers > 2) {
@@ -2353,7 +2376,7 @@ void VSScreen(void) {
 		if (mode == ARENA_MODE) {
 			GraySprite32_SMASK_R(108,16,charHeights[2],charsSelected[2],charsSelected[2]+charHeights[2],charsSelected[2]+2*charHeights[2],v2,v3);
 		} else {
-			GraySprite32_SMASK_R(108,16,characters[p3->characterIndex].h,characters[p3->characterIndex].frames[TAUNT1].data,characters[p3->characterIndex].frames[TAUNT1].data+characters[p3->characterIndex].h,characters[p3->characterIndex].frames[TAUNT1].data+2*characters[p3->characterIndex].h,v2,v3);
+			GraySprite32_SMASK_R(108,16,characters[p3->characterIndex].h,characterPortrait(p3->characterIndex),characterPortrait(p3->characterIndex)+characters[p3->characterIndex].h,characterPortrait(p3->characterIndex)+2*characters[p3->characterIndex].h,v2,v3);
 		}
 
 		sprintf(teamNum,"%u",p3->team);
@@ -2364,7 +2387,7 @@ void VSScreen(void) {
 		if (mode == ARENA_MODE) {
 			GraySprite32_SMASK_R(108,50,charHeights[3],charsSelected[3],charsSelected[3]+charHeights[3],charsSelected[3]+2*charHeights[3],v2,v3);
 		} else {
-			GraySprite32_SMASK_R(108,50,characters[p4->characterIndex].h,characters[p4->characterIndex].frames[TAUNT1].data,characters[p4->characterIndex].frames[TAUNT1].data+characters[p4->characterIndex].h,characters[p4->characterIndex].frames[TAUNT1].data+2*characters[p4->characterIndex].h,v2,v3);
+			GraySprite32_SMASK_R(108,50,characters[p4->characterIndex].h,characterPortrait(p4->characterIndex),characterPortrait(p4->characterIndex)+characters[p4->characterIndex].h,characterPortrait(p4->characterIndex)+2*characters[p4->characterIndex].h,v2,v3);
 		}
 
 		sprintf(teamNum,"%u",p4->team);
@@ -2378,35 +2401,30 @@ void VSScreen(void) {
 }
 
 // Decompresses the Run-length encryption Vertically Compressed Titlescreen
+// Splashscreens are stored a column at a time (100 lines, 20 bytes per line), as runs of SENTINEL_VALUE, value, length
+// and single literal bytes. The column order must match RLE_Encode in the installer's rleencode.c.
 void RLE_Decompress(unsigned char *src, unsigned char *dest, short size) {
-	int i = 0, j;
-	int pos = 0;
-	int dcmpNum = 0;
-	
-	while (dcmpNum < size) {
-		// decompress a run
-		if (src[i] == SENTINEL_VALUE) {
-			i++;
-			for (j = 0; j < src[i+1]; j++) {
-				dest[pos] = src[i];
-				pos += 20;
-				if (pos > 2000) {
-					pos -= 2000;
-					pos++;
-				}
-			}
-			i++;
-			dcmpNum += src[i];
+	unsigned char *pos = dest, *last = dest + 2000;
+	unsigned char value;
+	unsigned short count;
+	
+	while (size > 0) {
+		if (*src == SENTINEL_VALUE) { // decompress a run
+			value = src[1];
+			count = src[2];
+			src += 3;
 		} else {
-			dest[pos] = src[i];
-			pos += 20; // next line
-			if (pos > 2000) { // 100 lines, 20 bytes per line
-				pos -= 2000;
-				pos++;
+			value = *src++;
+			count = 1;
+		}
+		size -= count;
+		
+		while (count--) {
+			*pos = value;
+			if ((pos += 20) > last) { // next line, or the top of the next column
+				pos -= 1999;
 			}
-			dcmpNum++;
 		}
-		i++;
 	}
 }
 
@@ -0,0 +1,337 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - Physics.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Knockback physics. A player who has been hit (or thrown, or caught in an explosion) flies on 8.8 fixed-point
+// speeds - xspeed and yspeed in 256ths of a pixel per tick, with the leftover fraction of a pixel kept in frac -
+// under gravity and a little air drag, until the arc ends. Every flying player is moved once a tick, before anyone
+// is controlled, by sweeping their box through the collision grid a tile at a time, so a fast launch stops at the
+// first wall or floor in its path instead of being probed for and then stepped (and sometimes stepped through).
+// Walking, jumping and climbing still move in whole pixels (see Players.c), and the hands never fall.
+//
+// Items dropping in from the sky fall on the same 8.8 speeds, from rest up to ITEM_FALL, and are swept down the grid
+// the same way, so each comes to rest on top of the first solid tile under it (clouds included, as they always did).
+//
+// Shots come out of one pool (SHOTS_PER_PLAYER each) and are swept too: a shot's box over the whole of its step is
+// tested against the grid and against every fighter's middle, so it cannot hop over a thin character or into a wall.
+// A shot flies level bar sinking a pixel every few steps, which is not gravity and is not tested against the grid.
+// Which shots and fighters are even near one another comes from a sort-and-sweep along x, done once a tick after
+// everyone has moved and shared with the player-against-player checks in MainGame.c.
+
+#include "platform.h"
+#include "headers.h"
+
+#define GRAVITY          FIX(2)  // taken off yspeed every tick
+#define AIR_DRAG         0x0010  // taken off |xspeed| every tick (a sixteenth of a pixel)
+#define LAUNCH_BASE      FIX(2)  // upward speed of a hit at 0%...
+#define LAUNCH_PER_18    FIX(2)  // ...plus this much for every 18%, in steps of a 256th rather than of 18%
+#define HUMAN_ARC_END    FIX(-8) // a human's flight ends once falling this fast (a CPU's at the top of the arc)
+#define ITEM_GRAVITY     0x0040  // added to a falling item's speed every tick...
+#define ITEM_FALL        FIX(2)  // ...up to this (the two pixels a tick items always fell at)
+
+#define SHOT_SPEED       4       // pixels a tick
+#define SHOT_RANGE       90      // ticks a shot flies before it fizzles out
+#define NUM_SPANS        (MAX_PLAYERS + MAX_PROJECTILES)
+#define ON_SCREEN(__j)   ((__j)->x > 0 && (__j)->x < 152 && (__j)->y > 0 && (__j)->y < 92) // where a spent shot still bursts
+
+typedef struct {
+	int left;
+	int right;
+	unsigned int id; // player slot, or MAX_PLAYERS + pool index for a shot
+} SPAN;
+
+static unsigned char nearPlayers[NUM_SPANS]; // for each span, a bit per player slot whose span it overlaps (this tick)
+
+static BOOL tileBlocks(int px, int py, BOOL landing);
+static int sweepX(int left, int top, int dx);
+static int sweepY(int left, int top, int dy);
+static void land(PLAYER* p);
+static int sweepItem(int px, int bottom, int dy);
+static int sweepShot(PROJECTILE* j, int dx);
+static void spendShot(PROJECTILE* j, BOOL blast);
+
+// Knocks a player into the air: xspeed in whole pixels a tick, and an upward speed that grows with the damage taken
+void launchPlayer(PLAYER* p, int xspeed) {
+	p->xspeed = FIX(xspeed);
+	p->yspeed = LAUNCH_BASE + (int)(((unsigned long)((p->percent < MAX_HP) ? p->percent : MAX_HP) * LAUNCH_PER_18) / 18);
+	p->frac = 0;
+	p->paralyzed = TRUE;
+}
+
+// Moves every flying player one tick along their arc
+void flyPlayers(void) {
+	PLAYER* p = pHead;
+	int left, top, move, moved, sum;
+
+	while (p != NULL) {
+		if (p->paralyzed && !p->dead) {
+			if (p->yspeed <= ((p->type == CPU) ? 0 : HUMAN_ARC_END)) {
+				land(p);
+			} else {
+				// the box canMovePlayer probes around: 16 pixels wide at the sprite's middle, its bottom 16 rows
+				left = p->x + x_fg + (characters[p->characterIndex].w / 2) - 8 + ((characters[p->characterIndex].w / 2) & 1);
+				top = p->y + y_fg + characters[p->characterIndex].h + (characters[p->characterIndex].h & 1) - 16;
+
+				sum = (int)(p->frac & 0xFF) - p->yspeed; // up is negative y, so the speed is taken away
+				move = sum >> 8; // (rounds down for negative sums too, leaving a positive fraction)
+				moved = sweepY(left, top, move);
+				p->y += moved;
+				top += moved;
+				p->yspeed -= GRAVITY;
+
+				if (moved != move) { // hit a ceiling or the ground
+					land(p);
+				} else {
+					p->frac = (p->frac & 0xFF00) | (sum & 0xFF);
+
+					sum = (int)(p->frac >> 8) + p->xspeed;
+					move = sum >> 8;
+					moved = sweepX(left, top, move);
+					p->x += moved;
+					if (moved != move) { // bounce off the wall
+						p->xspeed = -p->xspeed;
+						sum = 0;
+					}
+					p->frac = (p->frac & 0x00FF) | ((sum & 0xFF) << 8);
+
+					if (p->xspeed > AIR_DRAG) {
+						p->xspeed -= AIR_DRAG;
+					} else if (p->xspeed < -AIR_DRAG) {
+						p->xspeed += AIR_DRAG;
+					}
+
+					if (p->xspeed < 0) {
+						p->rightCurrent = p->leftCurrent = &p->frames[HURT_LEFT];
+					} else if (p->xspeed > 0) {
+						p->rightCurrent = p->leftCurrent = &p->frames[HURT_RIGHT];
+					}
+				}
+			}
+		}
+		p = p->next;
+	}
+}
+
+// The flight is over - the player takes input again from this tick on
+static void land(PLAYER* p) {
+	p->paralyzed = FALSE;
+	p->xspeed = 0;
+	p->yspeed = 0;
+	p->frac = 0;
+}
+
+// Drops a loose item one tick, or stops it if it is standing on something solid. Returns whether it is still falling.
+BOOL dropItem(ITEM* item) {
+	int px = item->x + x_fg, bottom = item->y + y_fg + item->h - 1, sum, move, moved;
+
+	if (tileFlags(px, bottom + 1) & GRID_SOLID) { // resting
+		item->fall = 0;
+		item->frac = 0;
+		return FALSE;
+	}
+	if (item->fall < ITEM_FALL) {
+		item->fall += ITEM_GRAVITY;
+	}
+	sum = (int)(item->frac & 0xFF) + (int)item->fall;
+	move = sum >> 8;
+	moved = sweepItem(px, bottom, move);
+	item->y += moved;
+	item->frac = (moved == move) ? (sum & 0xFF) : 0;
+	return TRUE;
+}
+
+// whether a flying player may not enter the tile at stage pixel (px, py); clouds only stop a player landing on them
+static BOOL tileBlocks(int px, int py, BOOL landing) {
+	unsigned char flags = tileFlags(px, py);
+
+	if (flags & GRID_CLOUD) {
+		return landing && (flags & GRID_SOLID);
+	}
+	return (flags & (GRID_SOLID | GRID_SLOPELEFT | GRID_SLOPERIGHT)) != 0; // hills are solid from the side and below
+}
+
+// How far a 16x16 box at (left, top) can move dx pixels sideways: the whole way, or up to the first blocking column
+static int sweepX(int left, int top, int dx) {
+	int edge, col, last, row;
+
+	if (!dx) {
+		return 0;
+	}
+	edge = (dx > 0) ? left + 15 : left; // the leading edge
+	last = (edge + dx) >> 4;
+	for (col = edge >> 4; col != last; ) {
+		col += (dx > 0) ? 1 : -1; // each column the leading edge goes into
+		for (row = top >> 4; row <= (top + 15) >> 4; row++) {
+			if (tileBlocks(col << 4, row << 4, FALSE)) {
+				return (dx > 0) ? (col << 4) - 1 - edge : ((col + 1) << 4) - edge;
+			}
+		}
+	}
+	return dx;
+}
+
+// ...and dy pixels up or down (down onto a cloud counts as landing on it)
+static int sweepY(int left, int top, int dy) {
+	int edge, row, last, col;
+
+	if (!dy) {
+		return 0;
+	}
+	edge = (dy > 0) ? top + 15 : top;
+	last = (edge + dy) >> 4;
+	for (row = edge >> 4; row != last; ) {
+		row += (dy > 0) ? 1 : -1;
+		for (col = left >> 4; col <= (left + 15) >> 4; col++) {
+			if (tileBlocks(col << 4, row << 4, dy > 0)) {
+				return (dy > 0) ? (row << 4) - 1 - edge : ((row + 1) << 4) - edge;
+			}
+		}
+	}
+	return dy;
+}
+
+// How far an item's bottom pixel at (px, bottom) can fall dy pixels, up to the top of the first solid tile below it
+static int sweepItem(int px, int bottom, int dy) {
+	int row, last = (bottom + dy) >> 4;
+
+	for (row = bottom >> 4; row != last; ) {
+		row++;
+		if (tileFlags(px, row << 4) & GRID_SOLID) {
+			return (row << 4) - 1 - bottom;
+		}
+	}
+	return dy;
+}
+
+// Sorts every fighter's and every flying shot's extent along x and sweeps the list for overlaps - after the sort, only
+// spans starting before one ends can overlap it. A shot's span covers the step it is about to take.
+void sortAndSweep(void) {
+	SPAN spans[NUM_SPANS], s;
+	PLAYER* p;
+	PROJECTILE* j;
+	unsigned int n = 0, i, k, a, b;
+	
+	for (i = 0; i < numPlayers; i++) {
+		p = PLAYER_SLOT(i);
+		spans[n].left = p->x;
+		spans[n].right = p->x + characters[p->characterIndex].w - 1;
+		spans[n++].id = i;
+	}
+	for (i = 0, j = projectiles; i < MAX_PROJECTILES; i++, j++) {
+		if (j->flying) {
+			spans[n].left = j->x - ((j->dir < 0) ? SHOT_SPEED : 0);
+			spans[n].right = j->x + 8 + ((j->dir > 0) ? SHOT_SPEED : 0);
+			spans[n++].id = MAX_PLAYERS + i;
+		}
+	}
+	
+	for (i = 1; i < n; i++) { // insertion sort: a dozen spans at most, and it keeps ties in slot order
+		s = spans[i];
+		for (k = i; k > 0 && spans[k - 1].left > s.left; k--) {
+			spans[k] = spans[k - 1];
+		}
+		spans[k] = s;
+	}
+	
+	memset(nearPlayers, 0, sizeof(nearPlayers));
+	for (i = 0; i < n; i++) {
+		for (k = i + 1; k < n && spans[k].left <= spans[i].right; k++) {
+			a = spans[i].id, b = spans[k].id;
+			if (b < MAX_PLAYERS) {
+				nearPlayers[a] |= 1 << b;
+			}
+			if (a < MAX_PLAYERS) {
+				nearPlayers[b] |= 1 << a;
+			}
+		}
+	}
+}
+
+// Whether two fighters' spans overlapped at the last sortAndSweep (so whether they are worth a full test)
+BOOL mayTouch(PLAYER* a, PLAYER* b) {
+	return (nearPlayers[a - p1] >> (b - p1)) & 1;
+}
+
+// Steps every flying shot, and every explosion along. A shot hits the first fighter whose middle it passes this step,
+// stops at the first wall, or fizzles out when off the screen or out of range.
+void moveProjectiles(void) {
+	PROJECTILE* j;
+	PLAYER *p, *hit;
+	unsigned int i, slot;
+	int dx, moved, from, to, middle, hitMiddle = 0;
+	
+	for (i = 0, j = projectiles; i < MAX_PROJECTILES; i++, j++) {
+		if (j->flying) {
+			if (j->distance >= SHOT_RANGE || j->x < 0 || j->x > 156) {
+				spendShot(j, ON_SCREEN(j));
+			} else {
+				dx = j->dir * SHOT_SPEED;
+				moved = sweepShot(j, dx);
+				from = (moved < 0) ? j->x + moved : j->x; // the pixels the shot covers over its step
+				to = ((moved > 0) ? j->x + moved : j->x) + 8;
+				
+				hit = NULL;
+				for (slot = 0; slot < numPlayers; slot++) {
+					p = PLAYER_SLOT(slot);
+					middle = p->x + (characters[p->characterIndex].w / 2); // a shot hits a fighter where it crosses their middle
+					if (((nearPlayers[MAX_PLAYERS + i] >> slot) & 1) && slot != j->owner && !p->invincible && !p->onStage
+						&& middle >= from && middle <= to && j->y <= p->y + characters[p->characterIndex].h - 1 && j->y + 8 >= p->y
+						&& (hit == NULL || abs(middle - j->x) < abs(hitMiddle - j->x))) {
+						hit = p, hitMiddle = middle;
+					}
+				}
+				
+				if (hit != NULL) {
+					j->x = (j->dir > 0) ? max(j->x, hitMiddle - 8) : min(j->x, hitMiddle); // burst on them, not past them
+					hit->percent += randomFrom(RNG_COMBAT, 6) + 6;
+					spendShot(j, TRUE);
+				} else if (moved != dx) {
+					j->x += moved;
+					spendShot(j, ON_SCREEN(j));
+				} else {
+					j->x += dx; // move the projectile and drop it ever so slightly
+					if ((++j->distance & 9) == 0) {
+						j->y++;
+					}
+				}
+			}
+		}
+		if (j->exploding) {
+			explode(j);
+		}
+	}
+}
+
+// How far a shot can go of its next dx pixels before a solid tile (only its top row is tested, as it always was)
+static int sweepShot(PROJECTILE* j, int dx) {
+	int edge = j->x + x_fg + ((dx > 0) ? 7 : 0), col, last, py = j->y + y_fg;
+	
+	last = (edge + dx) >> 4;
+	for (col = edge >> 4; col != last; ) {
+		col += (dx > 0) ? 1 : -1;
+		if (tileFlags(col << 4, py) & GRID_SOLID) {
+			return (dx > 0) ? (col << 4) - 1 - edge : ((col + 1) << 4) - edge;
+		}
+	}
+	return dx;
+}
+
+// The shot is done: hand it back to its owner, blowing it up or not
+static void spendShot(PROJECTILE* j, BOOL blast) {
+	PLAYER* owner = PLAYER_SLOT(j->owner);
+	
+	j->flying = FALSE;
+	j->distance = 0;
+	j->e = 0;
+	j->exploding = blast;
+	if (owner->shots) {
+		owner->shots--;
+	}
+	owner->canFire = TRUE;
+}
+
+// End of Source File
@@ -9,13 +9,72 @@
 // This file contains all routines for handling human control of characters and AI control as well.
 // In addition, this file contains all logic for a player's interaction with the different types of terrain.
 
-#include <tigcclib.h>
+#include "platform.h"
 #include "headers.h"
 
 static BOOL holding = FALSE;
 static BOOL specialHolding = FALSE;
 static BOOL invHolding = FALSE;
 static BOOL grabHolding = FALSE;
+static unsigned int missile = 0; // ticks into a missile-type special
+
+// Navigation graph for the AI, built with the collision grid whenever a stage is set up. Nodes are platforms (runs of
+// tiles a player can stand in on one row) and links are the ways from one to another: walking off an end, dropping
+// through a cloud floor, jumping (double jumping when it is high) and climbing a ladder. Each CPU keeps a route to the
+// platform its enemy stands on - the link to take from every platform - and only plans it again when that changes.
+#define NAV_MAX_PLATFORMS 48
+#define NAV_MAX_LINKS     160
+#define NAV_NONE          0xFF
+#define NAV_JUMP_ROWS     2 // a single jump clears two tiles
+#define NAV_DOUBLE_ROWS   4
+#define NAV_JUMP_GAP      3 // widest gap (in tiles) a running jump gets across
+
+#define NAV_WALK          0 // walk off the end of the platform
+#define NAV_DROP          1 // drop through a cloud floor
+#define NAV_JUMP          2
+#define NAV_DOUBLE_JUMP   3
+#define NAV_LADDER        4
+
+typedef struct navplatform {
+	unsigned char row;
+	unsigned char left;
+	unsigned char right; // tile columns, inclusive
+} NAV_PLATFORM;
+
+typedef struct navlink {
+	unsigned char from;
+	unsigned char to;
+	unsigned char type;
+	unsigned char x; // column to take the link from
+	unsigned char aim; // column to steer for in the air (for a ladder: the row to climb to)
+} NAV_LINK;
+
+typedef struct navroute {
+	unsigned char target; // platform the route leads to (NAV_NONE = none planned)
+	unsigned char aim; // column being steered for during a jump or fall the route asked for
+	unsigned char doubleJump;
+	int climbY; // world y to climb the ladder to (-1 = not climbing for the route)
+	unsigned char next[NAV_MAX_PLATFORMS]; // link to take from each platform (NAV_NONE = none)
+} NAV_ROUTE;
+
+static NAV_PLATFORM navPlatforms[NAV_MAX_PLATFORMS];
+static NAV_LINK navLinks[NAV_MAX_LINKS]; // sorted by destination
+static unsigned char navFirstLink[NAV_MAX_PLATFORMS + 1]; // first link into each platform
+static unsigned int navNumPlatforms, navNumLinks;
+static NAV_ROUTE navRoutes[MAX_PLAYERS]; // by player slot
+
+// The AI's expensive decisions (picking a new enemy, planning a route, looking for an item underfoot) are rationed:
+// a CPU that wants one asks for it, and scheduleAI() hands out AI_DECISIONS_PER_TICK of them at the start of each
+// tick, going round the slots in turn. So three CPUs retargeting at once after a KO take a few ticks to do it rather
+// than all landing on the same one. Dodging and attacking still happen every tick.
+#define AI_RETARGET           0x01
+#define AI_REPLAN             0x02
+#define AI_ITEMS              0x04
+#define AI_DECISIONS_PER_TICK 2
+
+static unsigned char aiPending[MAX_PLAYERS]; // decisions each slot is waiting for
+static unsigned char aiGranted[MAX_PLAYERS]; // decisions each slot may make this tick
+static unsigned int aiTurn = 0; // slot served first next tick
 
 static void smashAttack(PLAYER* player);
 static void standStillSpecial(PLAYER* p);
@@ -32,7 +91,7 @@ static inline BOOL playerFall(PLAYER* player);
 static inline BOOL playerClimb(PLAYER* player);
 
 static inline BOOL ladder(int px, int py); // auxiliary terrain finding methods (helper methods)
-static inline BOOL hill(int px, int py, unsigned long slope);
+static inline BOOL hill(int px, int py, unsigned char slope);
 static inline BOOL hotTile(int px, int py);
 static inline BOOL waterTile(int px, int py);
 
@@ -44,6 +103,19 @@ static void updateFrames(PLAYER* p);
 static void scanForEnemy(PLAYER* cpu); // if I don't already have an enemy, need to find one (decides how here)
 static inline BOOL solidTileBeneath(int x, int y);
 
+// Navigation graph
+static void buildNavGraph(void);
+static BOOL navOpen(unsigned int tx, unsigned int ty);
+static BOOL navStandable(unsigned int tx, unsigned int ty);
+static unsigned char navPlatformAt(unsigned int tx, unsigned int ty);
+static unsigned char navLanding(unsigned int tx, unsigned int ty);
+static void addNavLink(unsigned char from, unsigned char to, unsigned char type, unsigned char x, unsigned char aim);
+static unsigned char platformOf(PLAYER* p);
+static void planRoute(NAV_ROUTE* route, unsigned char target);
+static BOOL followRoute(PLAYER* cpu);
+static void startJump(PLAYER* cpu, DIRECTION d);
+static BOOL aiMayDecide(PLAYER* cpu, unsigned char decision);
+
 // Enemy scanning method(s)
 static PLAYER* closestEnemyScan(PLAYER* cpu); // obviously scan for the closest player (the one I have now)
 static PLAYER* fatiguedEnemyScan(PLAYER* cpu); // AI will look for an easy kill
@@ -55,7 +127,7 @@ static void attackEnemy(PLAYER* cpu); // decide best idea to hurt enemy
 static int horizontalDistanceBetween(PLAYER* a, PLAYER* b);
 static int xHorizontalDistanceBetween(int x1, int x2);
 
-static inline BOOL projLook(int tileX, int tileY);
+static PROJECTILE* freeProjectile(void);
 
 static void (*specialAttacks[3])(PLAYER* p) =  {
 	standStillSpecial,
@@ -88,33 +160,7 @@ void handlePlayer(PLAYER* player) {
 		player->specialAttacking = FALSE;
 		player->skyAttacking = FALSE; // so that not continuously under same attack
 		
-		// -8 gives the arc a parabolic shape instead of a straight drop
-		if (player->yspeed <= -8 || !canMovePlayer(player,0,UP) || (player->yspeed < 0 && !canMovePlayer(player,0,DOWN))) {
-			player->paralyzed = FALSE;
-			player->yspeed = 0;
-			player->xspeed = 0;
-		} else {
-			player->y -= player->yspeed, player->yspeed -= 2;
-			
-			if (player->xspeed < 0) { // paralyzed to the left
-				if (canMovePlayer(player,LEFT,0)) {
-					player->x += player->xspeed;
-					player->rightCurrent = &characters[player->characterIndex].frames[HURT_LEFT];
-					player->leftCurrent = &characters[player->characterIndex].frames[HURT_LEFT];
-				} else {
-					player->xspeed = -player->xspeed;
-				}
-			} else if (player->xspeed > 0) { // paralyzed to the right
-				if (canMovePlayer(player,RIGHT,0)) {
-					player->x += player->xspeed;
-					player->rightCurrent = &characters[player->characterIndex].frames[HURT_RIGHT];
-					player->leftCurrent = &characters[player->characterIndex].frames[HURT_RIGHT];
-				} else {
-					player->xspeed = -player->xspeed;
-				}
-			}
-			return; // if player is paralyzed, don't take in any keypress input/further actions
-		}
+		return; // flown by flyPlayers() - a paralyzed player doesn't take in any keypress input/further actions
 	}
 	
 	if (player->jumpValue > 0) { // will perform an automatic jump when placed here (recommended for this action game)
@@ -137,15 +183,15 @@ void handlePlayer(PLAYER* player) {
   	}
 	
   	// Makes player jump
-  	if (_keytest(RR_SHIFT) && player->numJumps == 0 && !player->beingHeld) {
+  	if ((playerKeys & INPUT_JUMP) && player->numJumps == 0 && !player->beingHeld) {
 		player->jumpValue = JUMPVALUE;
 		player->numJumps = 1;
 		player->onHillL = FALSE;
 		player->onHillR = FALSE;
 		player->climbing = FALSE;
 		player->hanging = FALSE;
-		player->leftCurrent = &characters[player->characterIndex].frames[JUMPUP_LEFT]; // jumping frames
-		player->rightCurrent = &characters[player->characterIndex].frames[JUMPUP_RIGHT];
+		player->leftCurrent = &player->frames[JUMPUP_LEFT]; // jumping frames
+		player->rightCurrent = &player->frames[JUMPUP_RIGHT];
 	}
 
 	if (!player->running || disabled) {
@@ -155,16 +201,14 @@ void handlePlayer(PLAYER* player) {
 	player->running = FALSE;
 	
 	if (!disabled) {
-		if (_keytest(RR_LEFT)) {
+		if (playerKeys & INPUT_LEFT) {
 			if (player->grabbing && !numHands) {
-				player->enemy->xspeed = -4; // if player is moving, then adjust his enemy position
-				player->enemy->yspeed = (((player->enemy->percent/18)*2)+2);
-				player->enemy->paralyzed = TRUE;
+				launchPlayer(player->enemy, -4); // if player is moving, then adjust his enemy position
 				player->enemy->beingHeld = FALSE;
 				player->grabbing = FALSE;
 				points[STRONG_GRIP] = 1000; // special points category in classic mode
 			}
-			if (_keytest(RR_ALPHA)) { // try to dodge
+			if (playerKeys & INPUT_DODGE) { // try to dodge
 				if (!invHolding && !player->beingHeld) {
 					dodge(player,LEFT);
 					invHolding = TRUE;
@@ -177,16 +221,14 @@ void handlePlayer(PLAYER* player) {
 				}
 			}			
 		}		
-		if (_keytest(RR_RIGHT)) {
+		if (playerKeys & INPUT_RIGHT) {
 			if (player->grabbing && !numHands) {
-				player->enemy->xspeed = 4;
-				player->enemy->yspeed = (((player->enemy->percent/18)*2)+2);
-				player->enemy->paralyzed = TRUE;
+				launchPlayer(player->enemy, 4);
 				player->enemy->beingHeld = FALSE;
 				player->grabbing = FALSE;
 				points[STRONG_GRIP] = 1000;
 			}			
-			if (_keytest(RR_ALPHA)) {
+			if (playerKeys & INPUT_DODGE) {
 				if (!invHolding && !player->beingHeld) { // try to dodge
 					dodge(player,RIGHT);
 					invHolding = TRUE, player->direction = -player->direction; // automatically change direction to attack quickly!
@@ -200,7 +242,7 @@ void handlePlayer(PLAYER* player) {
 		}
 	}
 	
-  	if (_keytest(RR_2ND)) { // attack/pick up items
+  	if (playerKeys & INPUT_ATTACK) { // attack/pick up items
 		if (player->beingHeld) {
    			if (numHands) {
    				masterHand->attackMarker-=2;
@@ -213,7 +255,7 @@ void handlePlayer(PLAYER* player) {
    		}
 	}
    	if (player->currentItem == NULL) { // if overlapping an item, pick it up
-		if (head != NULL && existsItemInRegion(player)) {				
+		if (head != NULL) { // myItem() already answers whether there is one in reach
 			ITEM* it = myItem(player);
  			if (it != NULL && !it->beenUsed) {
 	 			if (it->replenish > 0) { // food item, so don't keep it
@@ -224,18 +266,13 @@ void handlePlayer(PLAYER* player) {
 	 				it->beenUsed = TRUE; // instantly get rid of all the food items
 	 			} else {
 	 				player->currentItem = it;
+	 				it->beingHeld = TRUE; // stops falling and is no longer drawn where it lay
 				}
 	 				
 	 			if (it->index > 13 && it->index < 16) { // EXPLOSIVE ITEMS! (use it immediately)
-	 				player->myProjectile->x = player->x+8;
-					player->myProjectile->y = player->y+4;
-					player->myProjectile->e = 0;
-					player->myProjectile->exploding = TRUE;
-	 				player->canFire = TRUE;
-	 				player->xspeed = 4-(random(2)*8);
-					player->yspeed = ((player->percent/18)*2)+2;
-					player->percent += 50+random(10);
-					player->paralyzed = TRUE;
+	 				explodeOn(player);
+	 				launchPlayer(player, 4-(randomFrom(RNG_COMBAT, 2)*8));
+					player->percent += 50+randomFrom(RNG_COMBAT, 10);
 	  				player->currentItem->beenUsed = TRUE;
 					player->currentItem->beingHeld = FALSE;
 					player->currentItem = NULL;
@@ -259,7 +296,7 @@ void handlePlayer(PLAYER* player) {
 		holding = FALSE;
 	}
 
-	if (_keytest(RR_DIAMOND) && !player->beingHeld) { // for some special attacks (like missile)
+	if ((playerKeys & INPUT_SPECIAL) && !player->beingHeld) { // for some special attacks (like missile)
 		if (!player->smashAttacking && !player->specialAttacking && !specialHolding) {
 			specialAttacks[characters[player->characterIndex].specialType](player);
 		}
@@ -268,7 +305,7 @@ void handlePlayer(PLAYER* player) {
 		specialHolding = FALSE;
 	}
 
-	if (_keytest(RR_UP) && !player->beingHeld) { // now includes center of gravity; can go up a ladder or jump
+	if ((playerKeys & INPUT_UP) && !player->beingHeld) { // now includes center of gravity; can go up a ladder or jump
 		player->crouching = FALSE;
 		
 		// if a player is currently overlapping a ladder tile
@@ -305,10 +342,10 @@ void handlePlayer(PLAYER* player) {
 					player->direction = -player->direction; // simulate climbing procedure of L-R-L-R
 				}
 				if (player->direction < 0) {
-					player->leftCurrent = &characters[player->characterIndex].frames[CLIMB_LEFT];
+					player->leftCurrent = &player->frames[CLIMB_LEFT];
 				}
 				else {
-					player->rightCurrent = &characters[player->characterIndex].frames[CLIMB_RIGHT];
+					player->rightCurrent = &player->frames[CLIMB_RIGHT];
 				}
 			}
 		}
@@ -316,8 +353,8 @@ void handlePlayer(PLAYER* player) {
 		if (player->hanging) { // hanging on a ledge: up = jump up from the ledge
 			player->jumpValue = JUMPVALUE;
 			player->hanging = FALSE;
-			player->leftCurrent = &characters[player->characterIndex].frames[JUMPUP_LEFT];
-			player->rightCurrent = &characters[player->characterIndex].frames[JUMPUP_RIGHT];
+			player->leftCurrent = &player->frames[JUMPUP_LEFT];
+			player->rightCurrent = &player->frames[JUMPUP_RIGHT];
 		}		
 		if (player->jumpValue > 0 && player->jumpValue < 16 && player->numJumps == 1) { // double jump (if already in air from shift)
 			player->jumpValue = JUMPVALUE;
@@ -328,11 +365,11 @@ void handlePlayer(PLAYER* player) {
 			player->direction = RIGHT;
 			player->taunting = TRUE;
 			player->attackMarker = player->playerCounter;
-			player->rightCurrent = &characters[player->characterIndex].frames[TAUNT1];
+			player->rightCurrent = &player->frames[TAUNT1];
 		}
 	}
 
-	if (_keytest(RR_DOWN) && !player->beingHeld) { // if player wants to climb back down the ladder, else crouch
+	if ((playerKeys & INPUT_DOWN) && !player->beingHeld) { // if player wants to climb back down the ladder, else crouch
 		player->hanging = FALSE; // if on the edge, then drop down from it (if holding on)
 		if (player->climbing) {
 			if (canMovePlayer(player,0,DOWN)) { // offset at bottom is added in here
@@ -353,22 +390,22 @@ void handlePlayer(PLAYER* player) {
 				player->direction = -player->direction;
 			}
 			if (player->direction < 0) {
-				player->leftCurrent = &characters[player->characterIndex].frames[CLIMB_LEFT];
+				player->leftCurrent = &player->frames[CLIMB_LEFT];
 			} else {
-				player->rightCurrent = &characters[player->characterIndex].frames[CLIMB_RIGHT];
+				player->rightCurrent = &player->frames[CLIMB_RIGHT];
 			}
 		}
 		
 		if (player->falling) { // sky attack! (similar to down-A attacks in SSBM)
 			player->skyAttacking = TRUE;
-			player->leftCurrent = &characters[player->characterIndex].frames[SKY_LEFT];
-			player->rightCurrent = &characters[player->characterIndex].frames[SKY_RIGHT];
+			player->leftCurrent = &player->frames[SKY_LEFT];
+			player->rightCurrent = &player->frames[SKY_RIGHT];
 		}
 		
 		// check the two tiles beneath the character
-		unsigned long sd = stageTemp->tileInfo[getTile(player->x+x_fg+(characters[player->characterIndex].w/2)-8+((characters[player->characterIndex].w/2)&1),player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1))];
-		unsigned long sd2 = stageTemp->tileInfo[getTile(player->x+x_fg+(characters[player->characterIndex].w/2)+7+((characters[player->characterIndex].w/2)&1),player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1))];
-		if ((sd == (SOLID | CLOUD) && sd2 != SOLID) || (sd2 == (SOLID | CLOUD) && sd != SOLID)) {
+		unsigned char sd = tileFlags(player->x+x_fg+(characters[player->characterIndex].w/2)-8+((characters[player->characterIndex].w/2)&1),player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1));
+		unsigned char sd2 = tileFlags(player->x+x_fg+(characters[player->characterIndex].w/2)+7+((characters[player->characterIndex].w/2)&1),player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1));
+		if ((sd == (GRID_SOLID | GRID_CLOUD) && sd2 != GRID_SOLID) || (sd2 == (GRID_SOLID | GRID_CLOUD) && sd != GRID_SOLID)) {
 			player->y += 4; // fall through cloud block
 		}
 		
@@ -379,7 +416,7 @@ void handlePlayer(PLAYER* player) {
 		player->crouching = FALSE; // revert to non-crouching state once DOWN is released
 	}
 	
-	if (_keytest(RR_F1) && !grabHolding && !player->beingHeld) { // F1 is now the grab button
+	if ((playerKeys & INPUT_GRAB) && !grabHolding && !player->beingHeld) { // F1 is now the grab button
 		if (!player->grabbing) {
 			grabPlayer(player);
 		}
@@ -415,11 +452,12 @@ static void fireProjectile(PLAYER* p) {
 	p->attackMarker = p->playerCounter;
 	p->specialAttacking = TRUE;
 	if (p->canFire) {
-		p->myProjectile = setupProj(p);
+		setupProj(p);
 	}
 }
 
 static void missileSpecial(PLAYER* p) {
+	p->attackMarker = p->playerCounter;
 	p->specialAttacking = TRUE;
 	p->climbing = FALSE;
 }
@@ -469,7 +507,7 @@ static void movePlayerLeft(PLAYER* player) {
 	player->hanging = FALSE;
 	
 	// Going up a hill to the left
-	if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-7-player->moveSpeed-((characters[player->characterIndex].w/2)&1),player->y+y_fg+characters[player->characterIndex].h-16+((characters[player->characterIndex].h)&1),SLOPELEFT) || player->onHillL) {
+	if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-7-player->moveSpeed-((characters[player->characterIndex].w/2)&1),player->y+y_fg+characters[player->characterIndex].h-16+((characters[player->characterIndex].h)&1),GRID_SLOPELEFT) || player->onHillL) {
 		if (((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) {
 			player->onHillL = TRUE;
 		} else {
@@ -477,19 +515,19 @@ static void movePlayerLeft(PLAYER* player) {
 				player->x-=2;
 			}
 		}
-		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-6-player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h-16+((characters[player->characterIndex].h)&1),SLOPELEFT)) {
+		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-6-player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h-16+((characters[player->characterIndex].h)&1),GRID_SLOPELEFT)) {
 			player->onHillL = FALSE;
 		}
 		if (player->onHillL) { // not entering hill, so move up the 45 degree angle block
 			player->y-=2;
 			player->x-=2;
 		}
-	} else if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-7-player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),SLOPERIGHT) || player->onHillR) {
+	} else if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-7-player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),GRID_SLOPERIGHT) || player->onHillR) {
 		// Going down a hill to the left	
 		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9)) {
 			player->onHillR = TRUE;
 		}
-		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-6-player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),SLOPERIGHT)) {
+		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)-6-player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),GRID_SLOPERIGHT)) {
 			player->onHillR = FALSE;
 		}
 		
@@ -522,7 +560,7 @@ static void movePlayerRight(PLAYER* player) {
 	player->hanging = FALSE; // disable special actions since back to running now
 	
 	// going up a hill to the right
-	if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+6+player->moveSpeed+2*((characters[player->characterIndex].w/2)&1),player->y+y_fg+(characters[player->characterIndex].h)-16+((characters[player->characterIndex].h)&1),SLOPERIGHT) || player->onHillR) {
+	if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+6+player->moveSpeed+2*((characters[player->characterIndex].w/2)&1),player->y+y_fg+(characters[player->characterIndex].h)-16+((characters[player->characterIndex].h)&1),GRID_SLOPERIGHT) || player->onHillR) {
 		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9)) {
 			player->onHillR = TRUE;
 		} else {
@@ -531,7 +569,7 @@ static void movePlayerRight(PLAYER* player) {
 			}
 		}
 		
-		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+5+player->moveSpeed,player->y+y_fg+(characters[player->characterIndex].h)-16+((characters[player->characterIndex].h)&1),SLOPERIGHT)) {
+		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+5+player->moveSpeed,player->y+y_fg+(characters[player->characterIndex].h)-16+((characters[player->characterIndex].h)&1),GRID_SLOPERIGHT)) {
 			player->onHillR = FALSE; // no more hill terrain
 		}
 		
@@ -539,7 +577,7 @@ static void movePlayerRight(PLAYER* player) {
 			player->y-=2;
 			player->x+=2;
 		}
-	} else if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+6+player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),SLOPELEFT) || player->onHillL) {
+	} else if (hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+6+player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),GRID_SLOPELEFT) || player->onHillL) {
 		// going down a hill to the right
 		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9)) {
 			player->onHillL = TRUE;
@@ -548,7 +586,7 @@ static void movePlayerRight(PLAYER* player) {
 				player->x+=2;
 			}
 		}
-		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+5+player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),SLOPELEFT)) {
+		if ((((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 8 || ((player->x+x_fg+((characters[player->characterIndex].w)/2)-8)&15) == 9) && !hill(player->x+x_fg+((characters[player->characterIndex].w)/2)+5+player->moveSpeed,player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1),GRID_SLOPELEFT)) {
 			player->onHillL = FALSE; // no more hill terrain
 		}		
 		if (player->onHillL) {
@@ -601,9 +639,293 @@ inline unsigned int __attribute__ ((pure)) getTile(int txx, int tyy) {
 	return (unsigned int)(*((char*)(stageTemp->fgPlane.matrix + (tyy / 16) * stageTemp->fgPlane.width + (txx / 16))));
 }
 
+// forgets held keys and a missile in flight from the last match
+void resetControls(void) {
+	holding = specialHolding = invHolding = grabHolding = FALSE;
+	missile = 0;
+	memset(aiPending,0,sizeof(aiPending));
+	memset(aiGranted,0,sizeof(aiGranted));
+	aiTurn = 0;
+}
+
+// Players.c's share of a match snapshot: held keys, missiles, routes and the AI scheduler
+char* playerState(char* at, STATE_TRANSFER how) {
+	at = transferState(at, &holding, sizeof(BOOL), how);
+	at = transferState(at, &specialHolding, sizeof(BOOL), how);
+	at = transferState(at, &invHolding, sizeof(BOOL), how);
+	at = transferState(at, &grabHolding, sizeof(BOOL), how);
+	at = transferState(at, &missile, sizeof(unsigned int), how);
+	at = transferState(at, navRoutes, sizeof(navRoutes), how);
+	at = transferState(at, aiPending, sizeof(aiPending), how);
+	at = transferState(at, aiGranted, sizeof(aiGranted), how);
+	return transferState(at, &aiTurn, sizeof(unsigned int), how);
+}
+
+// The same for a quicksave, packed: a route is kept as its target (the links to take are planned again from it on
+// loading) and the held keys as bits
+char* playerQuicksave(char* at, STATE_TRANSFER how) {
+	NAV_ROUTE* route;
+	unsigned int held, slot, i, v[4];
+	
+	held = holding | (specialHolding << 1) | (invHolding << 2) | (grabHolding << 3);
+	at = packWord(at, &held, FALSE, how);
+	at = packWord(at, &missile, FALSE, how);
+	at = packWord(at, &aiTurn, FALSE, how);
+	if (how == STATE_LOAD) {
+		holding = held & 1;
+		specialHolding = (held >> 1) & 1;
+		invHolding = (held >> 2) & 1;
+		grabHolding = (held >> 3) & 1;
+	}
+	
+	for (slot = 0; slot < numPlayers; slot++) {
+		route = &navRoutes[slot];
+		v[0] = route->target;
+		v[1] = route->aim;
+		v[2] = route->doubleJump;
+		v[3] = aiPending[slot] | (aiGranted[slot] << 8);
+		for (i = 0; i < 4; i++) {
+			at = packWord(at, &v[i], FALSE, how);
+		}
+		at = packWord(at, &route->climbY, TRUE, how);
+		
+		if (how == STATE_LOAD) {
+			planRoute(route, v[0]);
+			route->aim = v[1];
+			route->doubleJump = v[2];
+			aiPending[slot] = v[3] & 0xFF;
+			aiGranted[slot] = v[3] >> 8;
+		}
+	}
+	return at;
+}
+
+// packs the flags of every tile of the current stage into collisionGrid - must be called whenever stageTemp changes
+void buildCollisionGrid(void) {
+	unsigned int tx, ty;
+	unsigned long info;
+	unsigned char flags;
+	
+	memset(collisionGrid, GRID_EMPTY, sizeof(collisionGrid)); // anything past the edges of the stage is open air
+	
+	for (ty = 0; ty < stageTemp->sh && ty < GRID_H; ty++) {
+		for (tx = 0; tx < stageTemp->fgPlane.width && tx < GRID_W; tx++) {
+			info = stageTemp->tileInfo[(unsigned int)(*((char*)(stageTemp->fgPlane.matrix + ty * stageTemp->fgPlane.width + tx)))];
+			flags = GRID_EMPTY;
+			
+			if (info & SOLID) {
+				flags |= GRID_SOLID;
+			}
+			if (info & CLOUD) {
+				flags |= GRID_CLOUD;
+			}
+			if (info & SLOPELEFT) {
+				flags |= GRID_SLOPELEFT;
+			}
+			if (info & SLOPERIGHT) {
+				flags |= GRID_SLOPERIGHT;
+			}
+			if (info & LADDER) {
+				flags |= GRID_LADDER;
+			}
+			if (info & HOTTILE) {
+				flags |= GRID_HOT;
+			}
+			if (info & WATERTILE) {
+				flags |= GRID_WATER;
+			}
+			if (info & ~(SOLID | CLOUD | SLOPELEFT | SLOPERIGHT | LADDER | HOTTILE | WATERTILE)) {
+				flags |= GRID_SPECIAL; // doors, collapsing and partial tiles (and any other bits), so equal flags still mean equal tiles
+			}
+			collisionGrid[(ty << GRID_SHIFT) + tx] = flags;
+		}
+	}
+	
+	buildNavGraph();
+}
+
+// Finds the platforms of the current stage and every link between them (see NAV_ROUTE)
+static void buildNavGraph(void) {
+	unsigned int tx, ty, w = stageTemp->fgPlane.width, h = stageTemp->sh, i, j;
+	unsigned char a, b, top, found[8], numFound;
+	NAV_PLATFORM *p, *q;
+	NAV_LINK link;
+	
+	if (w > GRID_W) {
+		w = GRID_W;
+	}
+	if (h > GRID_H) {
+		h = GRID_H;
+	}
+	navNumPlatforms = navNumLinks = 0;
+	for (i = 0; i < MAX_PLAYERS; i++) {
+		navRoutes[i].target = navRoutes[i].aim = NAV_NONE;
+		navRoutes[i].climbY = -1;
+	}
+	
+	// platforms: runs of tiles on one row that can be stood in
+	for (ty = 0; ty < h; ty++) {
+		for (tx = 0; tx < w; tx++) {
+			if (navStandable(tx,ty) && navNumPlatforms < NAV_MAX_PLATFORMS) {
+				p = &navPlatforms[navNumPlatforms++];
+				p->row = ty, p->left = tx;
+				while (tx + 1 < w && navStandable(tx + 1,ty)) {
+					tx++;
+				}
+				p->right = tx;
+			}
+		}
+	}
+	
+	for (a = 0; a < navNumPlatforms; a++) {
+		p = &navPlatforms[a];
+		
+		// walking off either end
+		if (p->left > 0 && (b = navLanding(p->left - 1,p->row)) != NAV_NONE && b != a) {
+			addNavLink(a,b,NAV_WALK,p->left - 1,p->left - 1);
+		}
+		if (p->right + 1 < w && (b = navLanding(p->right + 1,p->row)) != NAV_NONE && b != a) {
+			addNavLink(a,b,NAV_WALK,p->right + 1,p->right + 1);
+		}
+		
+		// dropping through a cloud floor
+		for (tx = p->left; tx <= p->right; tx++) {
+			if ((tileFlags(tx << 4,(p->row + 1) << 4) & GRID_CLOUD) && (b = navLanding(tx,p->row + 1)) != NAV_NONE && b != a) {
+				addNavLink(a,b,NAV_DROP,tx,tx);
+			}
+		}
+		
+		// jumping across a gap or up onto a platform within reach
+		for (b = 0; b < navNumPlatforms; b++) {
+			q = &navPlatforms[b];
+			if (b == a || q->row + NAV_DOUBLE_ROWS < p->row) {
+				continue;
+			}
+			if (q->right < p->left && p->left - q->right - 1 <= NAV_JUMP_GAP) {
+				link.x = p->left, link.aim = q->right;
+			} else if (q->left > p->right && q->left - p->right - 1 <= NAV_JUMP_GAP) {
+				link.x = p->right, link.aim = q->left;
+			} else if (q->row < p->row && q->left > p->left && q->left - 1 <= p->right) {
+				link.x = q->left - 1, link.aim = q->left; // jump up past the left end of the platform above
+			} else if (q->row < p->row && q->right < p->right && q->right + 1 >= p->left) {
+				link.x = q->right + 1, link.aim = q->right;
+			} else {
+				continue;
+			}
+			if (q->row >= p->row && (q->right < p->left ? p->left - q->right : q->left - p->right) <= 1) {
+				continue; // right next to it - walking over is enough
+			}
+			for (ty = (q->row < p->row ? q->row : p->row); ty < p->row && navOpen(link.x,ty); ty++); // headroom above the take-off
+			if (ty == p->row) {
+				addNavLink(a,b,(q->row + NAV_JUMP_ROWS < p->row) ? NAV_DOUBLE_JUMP : NAV_JUMP,link.x,link.aim);
+			}
+		}
+	}
+	
+	// ladders: every platform a ladder passes by is linked to every other one on it
+	for (tx = 0; tx < w; tx++) {
+		for (ty = 0; ty < h; ty++) {
+			if (!(tileFlags(tx << 4,ty << 4) & GRID_LADDER)) {
+				continue;
+			}
+			top = ty;
+			while (ty + 1 < h && (tileFlags(tx << 4,(ty + 1) << 4) & GRID_LADDER)) {
+				ty++;
+			}
+			for (numFound = 0, a = 0; a < navNumPlatforms && numFound < 8; a++) {
+				p = &navPlatforms[a];
+				if (p->row + 1 >= top && p->row <= ty && p->left <= tx + 1 && p->right + 1 >= tx) {
+					found[numFound++] = a;
+				}
+			}
+			for (i = 0; i < numFound; i++) {
+				for (j = 0; j < numFound; j++) {
+					if (i != j && navPlatforms[found[i]].row != navPlatforms[found[j]].row) {
+						addNavLink(found[i],found[j],NAV_LADDER,tx,navPlatforms[found[j]].row);
+					}
+				}
+			}
+		}
+	}
+	
+	// sort by destination, so a route can be planned backwards from the target platform
+	for (i = 1; i < navNumLinks; i++) {
+		link = navLinks[i];
+		for (j = i; j > 0 && navLinks[j - 1].to > link.to; j--) {
+			navLinks[j] = navLinks[j - 1];
+		}
+		navLinks[j] = link;
+	}
+	for (a = 0, i = 0; a <= NAV_MAX_PLATFORMS; a++) {
+		while (i < navNumLinks && navLinks[i].to < a) {
+			i++;
+		}
+		navFirstLink[a] = i;
+	}
+}
+
+// Whether a player can pass through a tile (clouds and hills can be walked in)
+static BOOL navOpen(unsigned int tx, unsigned int ty) {
+	unsigned char flags = tileFlags(tx << 4,ty << 4);
+	return !(flags & GRID_SOLID) || (flags & (GRID_CLOUD | GRID_SLOPELEFT | GRID_SLOPERIGHT));
+}
+
+// Whether a player can stand in a tile: open, with a floor (or the top of a ladder) under it
+static BOOL navStandable(unsigned int tx, unsigned int ty) {
+	unsigned char below = tileFlags(tx << 4,(ty + 1) << 4);
+	if (!navOpen(tx,ty) || (tileFlags(tx << 4,ty << 4) & (GRID_HOT | GRID_WATER))) {
+		return FALSE;
+	}
+	return (below & (GRID_SOLID | GRID_CLOUD)) || ((below & GRID_LADDER) && !(tileFlags(tx << 4,ty << 4) & GRID_LADDER));
+}
+
+// Platform a tile belongs to (NAV_NONE if none)
+static unsigned char navPlatformAt(unsigned int tx, unsigned int ty) {
+	unsigned char i;
+	for (i = 0; i < navNumPlatforms; i++) {
+		if (navPlatforms[i].row == ty && navPlatforms[i].left <= tx && navPlatforms[i].right >= tx) {
+			return i;
+		}
+	}
+	return NAV_NONE;
+}
+
+// Platform a player falling down from a tile lands on (NAV_NONE if it falls off the stage or hits a wall)
+static unsigned char navLanding(unsigned int tx, unsigned int ty) {
+	for (; ty < GRID_H && navOpen(tx,ty); ty++) {
+		if (navStandable(tx,ty)) {
+			return navPlatformAt(tx,ty);
+		}
+	}
+	return NAV_NONE;
+}
+
+static void addNavLink(unsigned char from, unsigned char to, unsigned char type, unsigned char x, unsigned char aim) {
+	unsigned int i;
+	for (i = 0; i < navNumLinks; i++) {
+		if (navLinks[i].from == from && navLinks[i].to == to) {
+			return; // one way between two platforms is enough (the first found is the simplest)
+		}
+	}
+	if (navNumLinks < NAV_MAX_LINKS) {
+		navLinks[navNumLinks++] = (NAV_LINK){from,to,type,x,aim};
+	}
+}
+
 // findTerrain() function - used for determining whether a player can move for special terrain items
 static BOOL findTerrain(PLAYER* player, VERT_DIRECTION diry, int tileX, int tileY) {
-	unsigned long tempTileInfo = stageTemp->tileInfo[getTile(tileX,tileY)];
+	unsigned char flags = tileFlags(tileX,tileY);
+	unsigned long tempTileInfo;
+	
+	if (!(flags & GRID_SPECIAL)) { // plain tiles never need the full tile info word
+		collapse = 0;
+		if (flags & GRID_SOLID) {
+			return ((flags & GRID_CLOUD) && !(flags & (GRID_SLOPELEFT | GRID_SLOPERIGHT)) && (diry <= 0 || (tileY&15) != 0));
+		}
+		return !(flags & (GRID_SLOPELEFT | GRID_SLOPERIGHT));
+	}
+	
+	tempTileInfo = stageTemp->tileInfo[getTile(tileX,tileY)]; // doors, collapsing and partial tiles
 	
 	if (tempTileInfo & DOOR) {
 		if (((player->y+y_fg+characters[player->characterIndex].h+((characters[player->characterIndex].h)&1))&15) == 0) {
@@ -655,21 +977,22 @@ static inline BOOL playerClimb(PLAYER* player) {
 
 // Returns if there is a ladder at the desired coordinates
 static inline BOOL ladder(int px, int py) {
-	return (stageTemp->tileInfo[getTile(px,py)]&LADDER);
+	return (tileFlags(px,py)&GRID_LADDER);
 }
 
-static inline BOOL hill(int px, int py, unsigned long slope) {
-	return ((stageTemp->tileInfo[getTile(px,py)]&SOLID) && (stageTemp->tileInfo[getTile(px,py)]&slope));
+static inline BOOL hill(int px, int py, unsigned char slope) {
+	unsigned char flags = tileFlags(px,py);
+	return ((flags&GRID_SOLID) && (flags&slope));
 }
 
 // Tests if there is a hot tile to make player automatically jump (and deal damage to him/her)
 static inline BOOL hotTile(int px, int py) {
-	return (stageTemp->tileInfo[getTile(px,py)]&HOTTILE);
+	return (tileFlags(px,py)&GRID_HOT);
 }
 
 // Tests if there is a water tile at the desired coordinates
 static inline BOOL waterTile(int px, int py) {
-	return (stageTemp->tileInfo[getTile(px,py)]&WATERTILE);
+	return (tileFlags(px,py)&GRID_WATER);
 }
 
 // determine if two characters collided (match their sprite dimensions via the player w,h fields)
@@ -686,18 +1009,18 @@ static void checkForFallingPlayer(PLAYER* me) { // if player is not on solid gro
 	if (!me->onStage && me->jumpValue == 0 && playerFall(me) && !me->climbing && !me->hanging) {
 		me->falling = TRUE;
 		if (hotTile(me->x+x_fg,me->y+y_fg+characters[me->characterIndex].h)) {
-   			me->percent+=20+random(3), me->jumpValue = JUMPVALUE; // now does an auto jump from burn
+   			me->percent+=20+randomFrom(RNG_COMBAT, 3), me->jumpValue = JUMPVALUE; // now does an auto jump from burn
 		}
    		if (waterTile(me->x+x_fg,me->y+y_fg+characters[me->characterIndex].h)) {
    			waterGrav = 2; // increase the amount the player will drop/"sink" by if in water
 		}
-	} else if (!playerFall(me) && me->falling && hill(me->x+x_fg+(characters[me->characterIndex].w/2)+((characters[me->characterIndex].w/2)&1),me->y+y_fg+characters[me->characterIndex].h+((characters[me->characterIndex].h)&1),SLOPERIGHT)) {
+	} else if (!playerFall(me) && me->falling && hill(me->x+x_fg+(characters[me->characterIndex].w/2)+((characters[me->characterIndex].w/2)&1),me->y+y_fg+characters[me->characterIndex].h+((characters[me->characterIndex].h)&1),GRID_SLOPERIGHT)) {
 		// hill with right slope below
 		disabled = TRUE;
 		me->y+= (((me->x+x_fg+(characters[me->characterIndex].w/2))&15)==0)?16:(16-((me->x+x_fg+(characters[me->characterIndex].w/2))&15))-((characters[me->characterIndex].w/2)&1);
 		me->falling = FALSE;
 		me->onHillR = TRUE;
-	} else if (!playerFall(me) && me->falling && hill(me->x+x_fg+(characters[me->characterIndex].w/2)-1-((characters[me->characterIndex].w/2)&1),me->y+y_fg+characters[me->characterIndex].h+((characters[me->characterIndex].h)&1),SLOPELEFT)) {
+	} else if (!playerFall(me) && me->falling && hill(me->x+x_fg+(characters[me->characterIndex].w/2)-1-((characters[me->characterIndex].w/2)&1),me->y+y_fg+characters[me->characterIndex].h+((characters[me->characterIndex].h)&1),GRID_SLOPELEFT)) {
 		// falling onto left sloped hill
 		disabled = TRUE;
 		me->y+= (((me->x+x_fg+(characters[me->characterIndex].w/2)-1)&15)==15)?16:((((me->x+x_fg+(characters[me->characterIndex].w/2)-2+((characters[me->characterIndex].w/2)&1))&15)));
@@ -723,7 +1046,7 @@ static void checkForFallingPlayer(PLAYER* me) { // if player is not on solid gro
 static void checkForMovingLevelFallingPlayer(PLAYER* me) {
 	switch (scrollType) {
  		case SCROLL_DOWN:
-		me->falling = (playerFall(me) || _keytest(RR_DOWN));
+		me->falling = (playerFall(me) || (playerKeys & INPUT_DOWN));
 		if (!me->falling) {
 			me->y-=2;
 		}
@@ -748,11 +1071,11 @@ static void checkForMovingLevelFallingPlayer(PLAYER* me) {
 
 // central function for updating all animation frames
 static void updateFrames(PLAYER* p) {
-	if (p->leftCurrent == &characters[p->characterIndex].frames[STAND_RIGHT]) { // for switching directions
-		p->leftCurrent = &characters[p->characterIndex].frames[STAND_LEFT];
+	if (p->leftCurrent == &p->frames[STAND_RIGHT]) { // for switching directions
+		p->leftCurrent = &p->frames[STAND_LEFT];
 	}
-	if (p->rightCurrent == &characters[p->characterIndex].frames[STAND_LEFT]) {
-		p->rightCurrent = &characters[p->characterIndex].frames[STAND_RIGHT];
+	if (p->rightCurrent == &p->frames[STAND_LEFT]) {
+		p->rightCurrent = &p->frames[STAND_RIGHT];
 	}
 	
 	if ((p->playerCounter&31) == 0) { // could add a fatigue factor - breathe faster if the p has larger HP (between 32 and 64)
@@ -762,38 +1085,37 @@ static void updateFrames(PLAYER* p) {
 	// no special action under way, so just breathing or standing
 	if (!p->running && !p->jumpValue && !p->taunting && !p->climbing && !p->falling) {
 		if (p->breathing) {
-			p->leftCurrent = &characters[p->characterIndex].frames[BREATHE_LEFT];
-			p->rightCurrent = &characters[p->characterIndex].frames[BREATHE_RIGHT];
+			p->leftCurrent = &p->frames[BREATHE_LEFT];
+			p->rightCurrent = &p->frames[BREATHE_RIGHT];
 		} else {
-			p->leftCurrent = &characters[p->characterIndex].frames[STAND_LEFT];
-			p->rightCurrent = &characters[p->characterIndex].frames[STAND_RIGHT];
+			p->leftCurrent = &p->frames[STAND_LEFT];
+			p->rightCurrent = &p->frames[STAND_RIGHT];
 		}
 	}	
 	if (p->smashAttacking) {
 		if (p->playerCounter-p->attackMarker > ATTACK_ANIM_DELAY) {
-			p->leftCurrent = &characters[p->characterIndex].frames[STAND_LEFT];
-			p->rightCurrent = &characters[p->characterIndex].frames[STAND_RIGHT];
+			p->leftCurrent = &p->frames[STAND_LEFT];
+			p->rightCurrent = &p->frames[STAND_RIGHT];
 			p->smashAttacking = FALSE;
 		} else {
-			p->leftCurrent = &characters[p->characterIndex].frames[SMASH_LEFT];
-			p->rightCurrent = &characters[p->characterIndex].frames[SMASH_RIGHT];
+			p->leftCurrent = &p->frames[SMASH_LEFT];
+			p->rightCurrent = &p->frames[SMASH_RIGHT];
 		}
 	}
 	if (p->specialAttacking) {
 		if (p->playerCounter-p->attackMarker > ATTACK_ANIM_DELAY) {
-			p->leftCurrent = &characters[p->characterIndex].frames[STAND_LEFT];
-			p->rightCurrent = &characters[p->characterIndex].frames[STAND_RIGHT];
+			p->leftCurrent = &p->frames[STAND_LEFT];
+			p->rightCurrent = &p->frames[STAND_RIGHT];
 			p->specialAttacking = FALSE;
 		} else {
-			p->leftCurrent = &characters[p->characterIndex].frames[SPECIAL_LEFT];
-			p->rightCurrent = &characters[p->characterIndex].frames[SPECIAL_RIGHT];
+			p->leftCurrent = &p->frames[SPECIAL_LEFT];
+			p->rightCurrent = &p->frames[SPECIAL_RIGHT];
 		}
 		if (characters[p->characterIndex].specialType == 2) { // missile-type special attack for this player
-			static unsigned int missile = 0;
 			if (++missile < 15 && canMovePlayer(p,p->direction,0)) {
 				p->specialAttacking = TRUE;
-				p->leftCurrent = &characters[p->characterIndex].frames[SPECIAL_LEFT];
-				p->rightCurrent = &characters[p->characterIndex].frames[SPECIAL_RIGHT];
+				p->leftCurrent = &p->frames[SPECIAL_LEFT];
+				p->rightCurrent = &p->frames[SPECIAL_RIGHT];
 				p->x+=(p->direction*4); // recoil from the shot!
 			}
 			else {
@@ -805,19 +1127,19 @@ static void updateFrames(PLAYER* p) {
 	
 	// miscellaneous moves
 	if (p->invincible || p->crouching) {
-		p->leftCurrent = &characters[p->characterIndex].frames[CROUCH];
-		p->rightCurrent = &characters[p->characterIndex].frames[CROUCH];
+		p->leftCurrent = &p->frames[CROUCH];
+		p->rightCurrent = &p->frames[CROUCH];
 	}
 	if (p->beingHeld) {
-		p->leftCurrent = &characters[p->characterIndex].frames[HURT_LEFT];
-		p->rightCurrent = &characters[p->characterIndex].frames[HURT_RIGHT];
+		p->leftCurrent = &p->frames[HURT_LEFT];
+		p->rightCurrent = &p->frames[HURT_RIGHT];
 	}
 	if (p->taunting) { // loop through the player taunting frames based on counter
 		if (p->playerCounter - p->attackMarker > 8) {
-			p->rightCurrent = &characters[p->characterIndex].frames[TAUNT2];
+			p->rightCurrent = &p->frames[TAUNT2];
 		}
 		if (p->playerCounter - p->attackMarker > 16) {
-			p->rightCurrent = &characters[p->characterIndex].frames[STAND_RIGHT];
+			p->rightCurrent = &p->frames[STAND_RIGHT];
 			p->taunting = FALSE;
 		}
 	}
@@ -832,8 +1154,8 @@ void executeNewAI(PLAYER* cpu) {
 	 * update animation frames
 	 */
 	
-	if (numPlayers > 2 && cpu->enemy != NULL && (cpu->enemy->onStage || cpu->enemy->dead || cpu->enemy->paralyzed)) {
-		cpu->enemy = NULL; // reset the enemy that I'm targeting
+	if (numPlayers > 2 && cpu->enemy != NULL && (cpu->enemy->onStage || cpu->enemy->dead || cpu->enemy->paralyzed) && aiMayDecide(cpu,AI_RETARGET)) {
+		cpu->enemy = NULL; // reset the enemy that I'm targeting (keeps after the old one until its turn comes)
 	}
 	if (cpu->enemy == NULL) {
 		scanForEnemy(cpu); // find new enemy if I don't have one (what drives the AI players)
@@ -853,32 +1175,7 @@ void executeNewAI(PLAYER* cpu) {
 		cpu->smashAttacking = FALSE;
 		cpu->specialAttacking = FALSE;
 		cpu->skyAttacking = FALSE;
-		
-		if (cpu->yspeed <= 0 || !canMovePlayer(cpu,0,UP) || (cpu->yspeed < 0 && !canMovePlayer(cpu,0,DOWN))) {
-			cpu->paralyzed = FALSE, cpu->xspeed = 0, cpu->yspeed = 0;
-		} else {// yspeed > -8, so cpu is still flying up
-			cpu->y -= cpu->yspeed;
-			cpu->yspeed -= 2; // could even be 4
-			
-			if (cpu->xspeed < 0) { // paralyzed to the left
-				if (canMovePlayer(cpu,LEFT,0)) {
-					cpu->x += cpu->xspeed;
-					cpu->rightCurrent = &characters[cpu->characterIndex].frames[HURT_LEFT];
-					cpu->leftCurrent = &characters[cpu->characterIndex].frames[HURT_LEFT];
-				} else {
-					cpu->xspeed = -cpu->xspeed;
-				}
-			} else if (cpu->xspeed > 0) { // paralyzed to the right
-				if (canMovePlayer(cpu,RIGHT,0)) {
-					cpu->x += cpu->xspeed;
-					cpu->rightCurrent = &characters[cpu->characterIndex].frames[HURT_RIGHT];
-					cpu->leftCurrent = &characters[cpu->characterIndex].frames[HURT_RIGHT];
-				} else {
-					cpu->xspeed = -cpu->xspeed;
-				}
-			}
-			return;
-		}
+		return; // flown by flyPlayers()
 	}
 	
 	if (cpu->jumpValue > 0) { // will perform an automatic jump when placed here (recommended for this action game)
@@ -894,7 +1191,7 @@ void executeNewAI(PLAYER* cpu) {
 		}
 	
 		if (cpu->currentItem == NULL) { // picking up items
-			if (head != NULL && existsItemInRegion(cpu)) {
+			if (head != NULL && aiMayDecide(cpu,AI_ITEMS)) {
 				ITEM* it = myItem(cpu);
 				if (it != NULL && !it->beenUsed) {
 					if (it->replenish > 0) {
@@ -905,18 +1202,13 @@ void executeNewAI(PLAYER* cpu) {
  						it->beenUsed = TRUE; // instantly get rid of all the food items
  					} else {
 	 					cpu->currentItem = it;
+	 					it->beingHeld = TRUE;
 					}
 	 			
 					if (it->index > 13 && it->index < 16) { // EXPLOSIVE ITEMS!
-						cpu->myProjectile->x = cpu->x+8;
-						cpu->myProjectile->y = cpu->y+4;
-						cpu->myProjectile->e = 0;
-						cpu->myProjectile->exploding = TRUE;
-	 					cpu->canFire = TRUE;
-	 					cpu->xspeed = 4-(random(2)*8);
-						cpu->yspeed = ((cpu->percent/18)*2)+2;
-						cpu->percent += 50+random(10);
-						cpu->paralyzed = TRUE;
+						explodeOn(cpu);
+	 					launchPlayer(cpu, 4-(randomFrom(RNG_COMBAT, 2)*8));
+						cpu->percent += 50+randomFrom(RNG_COMBAT, 10);
 	  					cpu->currentItem->beenUsed = TRUE;
 						cpu->currentItem->beingHeld = FALSE;
 						cpu->currentItem = NULL;
@@ -935,24 +1227,25 @@ void executeNewAI(PLAYER* cpu) {
 	}
 	
 	if (cpu->climbing) {
-		if (cpu->y > cpu->enemy->y) {
+		int goalY = (navRoutes[cpu - p1].climbY >= 0) ? navRoutes[cpu - p1].climbY - y_fg : cpu->enemy->y; // a route's ladder, or the enemy
+		if (cpu->y > goalY) {
 			cpu->y-=2;
-		} else if (cpu->y < cpu->enemy->y) {
+		} else if (cpu->y < goalY) {
 			cpu->y+=2;
 		}
 		if (!(cpu->playerCounter&7)) {
 			cpu->direction = -cpu->direction;
 		}
 		if (cpu->direction < 0) {
-			cpu->leftCurrent = &characters[cpu->characterIndex].frames[CLIMB_LEFT];
+			cpu->leftCurrent = &cpu->frames[CLIMB_LEFT];
 		}
 		else {
-			cpu->rightCurrent = &characters[cpu->characterIndex].frames[CLIMB_RIGHT];
+			cpu->rightCurrent = &cpu->frames[CLIMB_RIGHT];
 		}
 	}
 	
 	// this double jumping is specifically for enemy tracking, not normally yet
-	if (((cpu->y > cpu->enemy->y && cpu->enemy->y > 0) || recovering) && cpu->numJumps == 1 && cpu->jumpValue > 0 && cpu->jumpValue < 4) {
+	if (((cpu->y > cpu->enemy->y && cpu->enemy->y > 0) || recovering || navRoutes[cpu - p1].doubleJump) && cpu->numJumps == 1 && cpu->jumpValue > 0 && cpu->jumpValue < 4) {
 		cpu->jumpValue = JUMPVALUE;
 		cpu->numJumps = 2;
 	}
@@ -972,8 +1265,8 @@ void executeNewAI(PLAYER* cpu) {
 			// vertical tests			
 			if (!canMovePlayer(cpu,RIGHT,0) || !canMovePlayer(cpu,LEFT,0)) { // check if can hang - if so, do it and get back to jumping
 				cpu->hanging = TRUE;
-				cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-				cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+				cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+				cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 			}
 						
 			if (cpu->hanging) { // jump up from hanging on the ledge to get back into the action
@@ -991,19 +1284,24 @@ void executeNewAI(PLAYER* cpu) {
 		}
 	}
 	
-	int a0 = cpu->enemy->myProjectile->x; // dodge enemy bullets!
-	int a1 = cpu->enemy->myProjectile->y;
-	if (!cpu->enemy->canFire && a1 > cpu->y && a1 < cpu->y+characters[cpu->characterIndex].h-1) {
-		if (a0 < cpu->x && cpu->enemy->myProjectile->dir > 0) {
-			if (xHorizontalDistanceBetween(a0,cpu->x) < 10 && !random(gameDifficulty)) {
-				dodge(cpu,LEFT); // dodge to the left
-			}
-		} else if (a0 > cpu->x && cpu->enemy->myProjectile->dir < 0) {
-			if (xHorizontalDistanceBetween(a0+8,cpu->x+characters[cpu->characterIndex].w-1) < 10 && !random(gameDifficulty)) {
-				dodge(cpu,RIGHT); // dodge to the right
+	PROJECTILE* shot = projectiles; // dodge enemy bullets!
+	for ( ; shot < projectiles + MAX_PROJECTILES; shot++) {
+		int a0 = shot->x;
+		int a1 = shot->y;
+		if (shot->flying && PLAYER_SLOT(shot->owner) == cpu->enemy && a1 > cpu->y && a1 < cpu->y+characters[cpu->characterIndex].h-1) {
+			if (a0 < cpu->x && shot->dir > 0) {
+				if (xHorizontalDistanceBetween(a0,cpu->x) < 10 && !randomFrom(RNG_AI, gameDifficulty)) {
+					dodge(cpu,LEFT); // dodge to the left
+					break;
+				}
+			} else if (a0 > cpu->x && shot->dir < 0) {
+				if (xHorizontalDistanceBetween(a0+8,cpu->x+characters[cpu->characterIndex].w-1) < 10 && !randomFrom(RNG_AI, gameDifficulty)) {
+					dodge(cpu,RIGHT); // dodge to the right
+					break;
+				}
 			}
 		}
-	}		
+	}
 	
 	// "KEYTEST" STUFF - moving, attacking actions much like a human player would	
 	cpu->running = FALSE;
@@ -1018,10 +1316,8 @@ void executeNewAI(PLAYER* cpu) {
 	}
 	
 	if (cpu->grabbing) {
-		if (!random(4)) {
-			cpu->enemy->xspeed = 4-(random(2)*8);
-			cpu->enemy->yspeed = (((cpu->enemy->percent/18)*2)+2);
-			cpu->enemy->paralyzed = TRUE; // if the current CPU is grabbing, then affect its enemy
+		if (!randomFrom(RNG_AI, 4)) {
+			launchPlayer(cpu->enemy, 4-(randomFrom(RNG_COMBAT, 2)*8)); // if the current CPU is grabbing, then affect its enemy
 			cpu->enemy->beingHeld = FALSE;
 			cpu->grabbing = FALSE;
 		}
@@ -1069,14 +1365,14 @@ static void scanForEnemy(PLAYER* cpu) {
 		// second criterion: find out who has most fatigue: this helps find easy kills/poaching for players that are about to be smashed off anyway
 		PLAYER* temp2 = fatiguedEnemyScan(cpu);
 		if (temp2->percent > 200) {
-			cpu->pointsHolder[1]+= 6 + random(5); // creates more random behavior in the intermediates
+			cpu->pointsHolder[1]+= 6 + randomFrom(RNG_AI, 5); // creates more random behavior in the intermediates
 		} else if (temp2->percent > 100) {
-			cpu->pointsHolder[1] += 3 + random(3);
+			cpu->pointsHolder[1] += 3 + randomFrom(RNG_AI, 3);
 		}
 		
 		// third criterion: found a slacker/"pro" in a stock match! attack lazy players so that they can't just hold onto their lives while watching the rest fight
 		if (gameMatchType && myPlayer->numLives == currentProfile.matchLives && myPlayer->percent < 30 && !myPlayer->running && !myPlayer->jumpValue && !myPlayer->falling && !myPlayer->smashAttacking && !myPlayer->specialAttacking) { 
-			cpu->pointsHolder[2] += 19 + random(5);
+			cpu->pointsHolder[2] += 19 + randomFrom(RNG_AI, 5);
 		}
 		
 		// Data is now gathered about other level entities, so now choose enemy as one with highest score
@@ -1116,20 +1412,20 @@ static inline BOOL solidTileBeneath(int x, int y) {
 	int dropY = myY;
 		
 	do {
-		if (((stageTemp->tileInfo[getTile(myX,dropY)])&SOLID) || ((stageTemp->tileInfo[getTile(myX,dropY)])&(SOLID|CLOUD))) {
+		if (tileFlags(myX,dropY)&(GRID_SOLID|GRID_CLOUD)) {
 			return TRUE;
 		}
 		dropY+=16;
-	} while (dropY <= stageTemp->sh);
+	} while (dropY < (stageTemp->sh << 4)); // sh is in tiles, dropY in pixels
 	return FALSE;
 }
 
 // returns the other player on a different team that is closest to the AI
 static PLAYER* closestEnemyScan(PLAYER* cpu) {
 	PLAYER *temp = pHead, *closest = NULL;
-	unsigned int dist = 65000, d;
+	unsigned long dist = 0xFFFFFFFF, d; // squared distances across a wide stage don't fit in 16 bits
 	while (temp != NULL) {
-		if (!temp->dead && !temp->onStage && cpu->team != temp->team && (d = (cpu->x-temp->x)*(cpu->x-temp->x)+(cpu->y-temp->y)*(cpu->y-temp->y)) < dist) {
+		if (!temp->dead && !temp->onStage && cpu->team != temp->team && (d = (long)(cpu->x-temp->x)*(cpu->x-temp->x)+(long)(cpu->y-temp->y)*(cpu->y-temp->y)) < dist) {
 			closest = temp;
 			dist = d;
 		}
@@ -1165,6 +1461,9 @@ static void moveToEnemy(PLAYER* cpu) {
 	if (stageTemp->movingLevel && !scrollType) {
 		return;
 	}
+	if (followRoute(cpu)) {
+		return; // on another platform than the enemy - the route says where to go
+	}
 	
 	if (cpu->x > cpu->enemy->x) { // move to the left
 		if (canMovePlayer(cpu,LEFT,0)) { // or if a hill, can move
@@ -1186,15 +1485,15 @@ static void moveToEnemy(PLAYER* cpu) {
 							cpu->onHillR = FALSE;
 							cpu->climbing = FALSE;
 							cpu->hanging = FALSE;
-							cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-							cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+							cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+							cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 						}
 						movePlayerLeft(cpu);
 					}
 				} else {
 					// get the tile info below the current CPU player
-					unsigned long sa = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-9-((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-					if (!cpu->enemy->falling || sa == EMPTY || sa == WATERTILE || sa == HOTTILE) {
+					unsigned char sa = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-9-((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+					if (!cpu->enemy->falling || sa == GRID_EMPTY || sa == GRID_WATER || sa == GRID_HOT) {
 						if (cpu->numJumps == 0) {
 							cpu->direction = LEFT;
 							cpu->jumpValue = JUMPVALUE;
@@ -1203,8 +1502,8 @@ static void moveToEnemy(PLAYER* cpu) {
 							cpu->onHillR = FALSE;
 							cpu->climbing = FALSE;
 							cpu->hanging = FALSE;
-							cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-							cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+							cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+							cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 						}
 						movePlayerLeft(cpu);
 					}
@@ -1212,9 +1511,9 @@ static void moveToEnemy(PLAYER* cpu) {
 			} else if ((cpu->y+characters[cpu->characterIndex].h-16+((characters[cpu->characterIndex].h)&1)) < (cpu->enemy->y+characters[cpu->enemy->characterIndex].h-16+((characters[cpu->enemy->characterIndex].h)&1))) {
 				// current CPU player is above the enemy
 				if (!playerFall(cpu)) { // player cannot move down, so need to either move manually or find alternate route
-					unsigned long sd = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-					unsigned long sd2 = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+7+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-					if (sd == (SOLID | CLOUD) || sd2 == (SOLID | CLOUD)) {
+					unsigned char sd = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+					unsigned char sd2 = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+7+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+					if (sd == (GRID_SOLID | GRID_CLOUD) || sd2 == (GRID_SOLID | GRID_CLOUD)) {
 						cpu->y+=4;
 						cpu->onHillL = FALSE;
 						cpu->onHillR = FALSE;
@@ -1236,8 +1535,8 @@ static void moveToEnemy(PLAYER* cpu) {
 				cpu->onHillR = FALSE;
 				cpu->climbing = FALSE;
 				cpu->hanging = FALSE;
-				cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-				cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+				cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+				cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 			}
 		}
 	} else if (cpu->x == cpu->enemy->x) {
@@ -1250,15 +1549,15 @@ static void moveToEnemy(PLAYER* cpu) {
 				cpu->onHillR = FALSE;
 				cpu->climbing = FALSE;
 				cpu->hanging = FALSE;
-				cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-				cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+				cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+				cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 			}
 		} else if ((cpu->y+characters[cpu->characterIndex].h-16+((characters[cpu->characterIndex].h)&1)) < (cpu->enemy->y+characters[cpu->enemy->characterIndex].h-16+((characters[cpu->enemy->characterIndex].h)&1))) {
 			if (!playerFall(cpu)) {
 				// scan the two tiles beneath the player
-				unsigned long sd = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-				unsigned long sd2 = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+7+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-				if (sd == (SOLID | CLOUD) || sd2 == (SOLID | CLOUD)) {
+				unsigned char sd = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+				unsigned char sd2 = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+7+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+				if (sd == (GRID_SOLID | GRID_CLOUD) || sd2 == (GRID_SOLID | GRID_CLOUD)) {
 					cpu->y+=4, cpu->onHillL = FALSE, cpu->onHillR = FALSE;
 				} else {
 					movePlayerRight(cpu);
@@ -1284,14 +1583,14 @@ static void moveToEnemy(PLAYER* cpu) {
 							cpu->onHillR = FALSE;
 							cpu->climbing = FALSE;
 							cpu->hanging = FALSE;
-							cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-							cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+							cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+							cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 						}
 						movePlayerRight(cpu);
 					}
 				} else {
-					unsigned long sa = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-					if (!cpu->enemy->falling || sa == EMPTY || sa == WATERTILE || sa == HOTTILE) {
+					unsigned char sa = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+					if (!cpu->enemy->falling || sa == GRID_EMPTY || sa == GRID_WATER || sa == GRID_HOT) {
 						if (cpu->numJumps == 0) {
 							cpu->direction = RIGHT;
 							cpu->jumpValue = JUMPVALUE;
@@ -1300,8 +1599,8 @@ static void moveToEnemy(PLAYER* cpu) {
 							cpu->onHillR = FALSE;
 							cpu->climbing = FALSE;
 							cpu->hanging = FALSE;
-							cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-							cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+							cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+							cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
 						}
 						movePlayerRight(cpu);
 					}
@@ -1309,9 +1608,9 @@ static void moveToEnemy(PLAYER* cpu) {
 			} else if ((cpu->y+characters[cpu->characterIndex].h-16+((characters[cpu->characterIndex].h)&1)) < (cpu->enemy->y+characters[cpu->enemy->characterIndex].h-16+((characters[cpu->enemy->characterIndex].h)&1))) {
 				// player is above the enemy
 				if (!playerFall(cpu)) { // player cannot move down, so need to either move manually or find alternate route
-					unsigned long sd = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-					unsigned long sd2 = stageTemp->tileInfo[getTile(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+7+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1))];
-					if (sd == (SOLID | CLOUD) || sd2 == (SOLID | CLOUD)) {
+					unsigned char sd = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)-8+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+					unsigned char sd2 = tileFlags(cpu->x+x_fg+(characters[cpu->characterIndex].w/2)+7+((characters[cpu->characterIndex].w/2)&1),cpu->y+y_fg+characters[cpu->characterIndex].h+((characters[cpu->characterIndex].h)&1));
+					if (sd == (GRID_SOLID | GRID_CLOUD) || sd2 == (GRID_SOLID | GRID_CLOUD)) {
 						cpu->y+=4;
 					} else {
 						movePlayerRight(cpu);
@@ -1331,19 +1630,201 @@ static void moveToEnemy(PLAYER* cpu) {
 				cpu->onHillR = FALSE;
 				cpu->climbing = FALSE;
 				cpu->hanging = FALSE;
-				cpu->leftCurrent = &characters[cpu->characterIndex].frames[JUMPUP_LEFT];
-				cpu->rightCurrent = &characters[cpu->characterIndex].frames[JUMPUP_RIGHT];
+				cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+				cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
+			}
+		}
+	}
+}
+
+// Platform a player is standing on (NAV_NONE when in the air or somewhere off the graph)
+static unsigned char platformOf(PLAYER* p) {
+	unsigned int tx = (p->x + x_fg + characters[p->characterIndex].w / 2) >> 4;
+	int feet = p->y + y_fg + characters[p->characterIndex].h + (characters[p->characterIndex].h & 1) - 1;
+	unsigned char i;
+	
+	if (feet < 0 || p->dead || p->onStage) {
+		return NAV_NONE;
+	}
+	if ((i = navPlatformAt(tx,feet >> 4)) != NAV_NONE || !p->climbing) {
+		return i;
+	}
+	for (i = 0; i < navNumPlatforms; i++) { // on a ladder beside the platform
+		if (navPlatforms[i].row == (feet >> 4) && navPlatforms[i].left <= tx + 1 && navPlatforms[i].right + 1 >= tx) {
+			return i;
+		}
+	}
+	return NAV_NONE;
+}
+
+// Plans the way to the target platform from every other one at once (walking the links backwards from it)
+static void planRoute(NAV_ROUTE* route, unsigned char target) {
+	unsigned char queue[NAV_MAX_PLATFORMS], reached[NAV_MAX_PLATFORMS];
+	unsigned int head = 0, tail = 0, i;
+	unsigned char v;
+	
+	route->target = target;
+	memset(route->next,NAV_NONE,NAV_MAX_PLATFORMS);
+	if (target == NAV_NONE) {
+		return;
+	}
+	memset(reached,FALSE,NAV_MAX_PLATFORMS);
+	reached[target] = TRUE;
+	queue[tail++] = target;
+	
+	while (head < tail) {
+		v = queue[head++];
+		for (i = navFirstLink[v]; i < navFirstLink[v + 1]; i++) {
+			if (!reached[navLinks[i].from]) {
+				reached[navLinks[i].from] = TRUE;
+				route->next[navLinks[i].from] = i;
+				queue[tail++] = navLinks[i].from;
 			}
 		}
 	}
 }
 
+// Follows the route to the enemy's platform; FALSE leaves the move to the direct chase (same platform, or no way there)
+static BOOL followRoute(PLAYER* cpu) {
+	NAV_ROUTE* route = &navRoutes[cpu - p1];
+	NAV_LINK* link;
+	unsigned int tx = (cpu->x + x_fg + characters[cpu->characterIndex].w / 2) >> 4;
+	unsigned char here, there;
+	
+	if (stageTemp->movingLevel) {
+		return FALSE; // the tiles move under the graph
+	}
+	if ((there = platformOf(cpu->enemy)) == NAV_NONE) {
+		there = route->target; // enemy in the air - keep heading for where it last stood
+	} else if (there != route->target) {
+		if (aiMayDecide(cpu,AI_REPLAN)) {
+			planRoute(route,there); // the only time a route is planned again
+		} else {
+			there = route->target; // keep to the old route until this CPU's turn
+		}
+	}
+	if (!cpu->climbing) {
+		route->climbY = -1;
+	}
+	
+	if (cpu->jumpValue || cpu->numJumps || cpu->falling) { // in the air - steer for where the link lands
+		if (route->aim == NAV_NONE) {
+			return FALSE;
+		}
+		if (tx < route->aim) {
+			movePlayerRight(cpu);
+		} else if (tx > route->aim) {
+			movePlayerLeft(cpu);
+		}
+		return TRUE;
+	}
+	if (route->climbY >= 0 && abs(cpu->y + y_fg - route->climbY) > 1) {
+		return TRUE; // still on the way up (or down) the ladder
+	}
+	route->aim = NAV_NONE;
+	route->doubleJump = FALSE;
+	
+	here = platformOf(cpu);
+	if (there == NAV_NONE || here == NAV_NONE || here == there || route->next[here] == NAV_NONE) {
+		return FALSE;
+	}
+	link = &navLinks[route->next[here]];
+	
+	if (link->type != NAV_LADDER) {
+		route->aim = link->aim;
+	}
+	if (tx < link->x) {
+		movePlayerRight(cpu);
+		return TRUE;
+	}
+	if (tx > link->x) {
+		movePlayerLeft(cpu);
+		return TRUE;
+	}
+	
+	switch (link->type) {
+		case NAV_WALK:
+		if (link->aim < navPlatforms[here].left) {
+			movePlayerLeft(cpu);
+		} else {
+			movePlayerRight(cpu);
+		}
+		break;
+		
+		case NAV_DROP:
+		cpu->y += 4;
+		cpu->onHillL = FALSE;
+		cpu->onHillR = FALSE;
+		break;
+		
+		case NAV_DOUBLE_JUMP:
+		route->doubleJump = TRUE; // executeNewAI jumps again at the top of the first one
+		case NAV_JUMP:
+		startJump(cpu,(link->aim < tx) ? LEFT : RIGHT);
+		break;
+		
+		case NAV_LADDER:
+		route->climbY = ((link->aim + 1) << 4) - characters[cpu->characterIndex].h - (characters[cpu->characterIndex].h & 1);
+		cpu->climbing = TRUE;
+		break;
+	}
+	return TRUE;
+}
+
+// Hands out this tick's expensive AI decisions - called once per tick before the players move
+void scheduleAI(void) {
+	unsigned int budget = AI_DECISIONS_PER_TICK, i, slot;
+	unsigned char decision;
+	
+	memset(aiGranted,0,sizeof(aiGranted)); // unused grants from last tick lapse
+	for (i = 0; i < MAX_PLAYERS && budget; i++) {
+		slot = (aiTurn + i) & (MAX_PLAYERS - 1);
+		for (decision = AI_RETARGET; decision <= AI_ITEMS && budget; decision <<= 1) {
+			if (aiPending[slot] & decision) {
+				aiPending[slot] &= ~decision;
+				aiGranted[slot] |= decision;
+				budget--;
+			}
+		}
+		if (aiGranted[slot]) {
+			aiTurn = (slot + 1) & (MAX_PLAYERS - 1);
+		}
+	}
+}
+
+// TRUE if the CPU may make an expensive decision this tick; otherwise it is put in line for one
+static BOOL aiMayDecide(PLAYER* cpu, unsigned char decision) {
+	unsigned int slot = cpu - p1;
+	
+	if (aiGranted[slot] & decision) {
+		aiGranted[slot] &= ~decision;
+		return TRUE;
+	}
+	aiPending[slot] |= decision;
+	return FALSE;
+}
+
+// Jumps off the ground toward a direction
+static void startJump(PLAYER* cpu, DIRECTION d) {
+	if (cpu->numJumps == 0) {
+		cpu->direction = d;
+		cpu->jumpValue = JUMPVALUE;
+		cpu->numJumps = 1;
+		cpu->onHillL = FALSE;
+		cpu->onHillR = FALSE;
+		cpu->climbing = FALSE;
+		cpu->hanging = FALSE;
+		cpu->leftCurrent = &cpu->frames[JUMPUP_LEFT];
+		cpu->rightCurrent = &cpu->frames[JUMPUP_RIGHT];
+	}
+}
+
 static void attackEnemy(PLAYER* cpu) {
 	if (cpu->falling) { // if falling, do a sky attack
-		if (cpu->enemy->y > cpu->y && horizontalDistanceBetween(cpu,cpu->enemy) < 16 && !random(gameDifficulty)) {
+		if (cpu->enemy->y > cpu->y && horizontalDistanceBetween(cpu,cpu->enemy) < 16 && !randomFrom(RNG_AI, gameDifficulty)) {
 			cpu->skyAttacking = TRUE;
-			cpu->leftCurrent = &characters[cpu->characterIndex].frames[SKY_LEFT];
-			cpu->rightCurrent = &characters[cpu->characterIndex].frames[SKY_RIGHT];
+			cpu->leftCurrent = &cpu->frames[SKY_LEFT];
+			cpu->rightCurrent = &cpu->frames[SKY_RIGHT];
 			
 			if (cpu->x+(characters[cpu->characterIndex].w/2)-8 < cpu->enemy->x+(characters[cpu->enemy->characterIndex].w/2)-8) {
 				cpu->direction = RIGHT;
@@ -1354,8 +1835,8 @@ static void attackEnemy(PLAYER* cpu) {
 	}
 	
 	// AI sees the player is about to hit them (collisions tested after me so it gives a fair playing field), so try to dodge
-	if (playersCollided(cpu,cpu->enemy) && !cpu->onStage && (cpu->enemy->smashAttacking || cpu->enemy->specialAttacking || cpu->enemy->skyAttacking) && !random(gameDifficulty)) { 
-		if (!random(2)) {
+	if (playersCollided(cpu,cpu->enemy) && !cpu->onStage && (cpu->enemy->smashAttacking || cpu->enemy->specialAttacking || cpu->enemy->skyAttacking) && !randomFrom(RNG_AI, gameDifficulty)) { 
+		if (!randomFrom(RNG_AI, 2)) {
 			if (cpu->x > cpu->enemy->x && cpu->enemy->direction > 0) {
 				dodge(cpu,LEFT);
 				cpu->direction = -cpu->direction;
@@ -1370,7 +1851,7 @@ static void attackEnemy(PLAYER* cpu) {
 	// very important to make smashing only occur once for p1 and then turn it off instantly so doesn't last through frame, because cpu can keep changing
 	// directions and dodging
 	
-	if (playersCollided(cpu,cpu->enemy) && !random(gameDifficulty)) {
+	if (playersCollided(cpu,cpu->enemy) && !randomFrom(RNG_AI, gameDifficulty)) {
 		if (cpu->x+(characters[cpu->characterIndex].w/2)-8 < cpu->enemy->x+(characters[cpu->enemy->characterIndex].w/2)-8 && cpu->direction < 0) {
 			cpu->direction = RIGHT;
 		}
@@ -1378,7 +1859,7 @@ static void attackEnemy(PLAYER* cpu) {
 			cpu->direction = LEFT;
 		}
 		
-		unsigned int a = random(24); // random number to help determine which type of attack in general to perform (relatively even, except for special)
+		unsigned int a = randomFrom(RNG_AI, 24); // random number to help determine which type of attack in general to perform (relatively even, except for special)
 		if (a < 9) {
 			grabPlayer(cpu);
 		} else if (a < 18) {
@@ -1398,43 +1879,60 @@ static int xHorizontalDistanceBetween(int x1, int x2) {
 	return abs(x1-x2);
 }
 
-// Initializes a player's projectile
+// Projectile functions (they are flown by moveProjectiles() - see Physics.c)
+
+// Fires one of a player's shots out of the pool; NULL if all their shots are out already or the pool is used up
 PROJECTILE* setupProj(PLAYER* player) { 
-	player->myProjectile->x = (player->direction>0)?player->x+characters[player->characterIndex].w:player->x-8;
-	player->myProjectile->y = player->y+4;
-	player->myProjectile->dir = player->direction;
-	player->myProjectile->e = 0;
-	player->myProjectile->exploding = FALSE;
-	player->myProjectile->data = bullet;
-	player->canFire = FALSE;
-	return player->myProjectile;
+	PROJECTILE* projectile = freeProjectile();
+	if (projectile == NULL || player->shots >= SHOTS_PER_PLAYER) {
+		return NULL;
+	}
+	projectile->x = (player->direction>0)?player->x+characters[player->characterIndex].w:player->x-8;
+	projectile->y = player->y+4;
+	projectile->dir = player->direction;
+	projectile->distance = 0;
+	projectile->e = 0;
+	projectile->owner = player - p1;
+	projectile->flying = TRUE;
+	projectile->exploding = FALSE;
+	projectile->data = bullet;
+	if (++player->shots >= SHOTS_PER_PLAYER) {
+		player->canFire = FALSE;
+	}
+	return projectile;
 }
 
-// Projectile functions
-BOOL moveProjectile(PROJECTILE* projectile, DIRECTION direction) {	
-	if ((direction < 0 && !projLook(projectile->x+x_fg-1,projectile->y+y_fg)) || (direction > 0 && !projLook(projectile->x+x_fg+8,projectile->y+y_fg))) {
-		return FALSE;
+// Sets off an explosion on a player (explosive items) - it takes a pool slot for the animation, but not one of their shots
+PROJECTILE* explodeOn(PLAYER* player) {
+	PROJECTILE* projectile = freeProjectile();
+	if (projectile != NULL) {
+		projectile->x = player->x+8;
+		projectile->y = player->y+4;
+		projectile->e = 0;
+		projectile->owner = player - p1;
+		projectile->exploding = TRUE;
 	}
-	return TRUE;
+	return projectile;
+}
+
+// The first pool slot that is neither flying nor exploding
+static PROJECTILE* freeProjectile(void) {
+	PROJECTILE* projectile;
+	for (projectile = projectiles; projectile < projectiles + MAX_PROJECTILES; projectile++) {
+		if (!projectile->flying && !projectile->exploding) {
+			return projectile;
+		}
+	}
+	return NULL;
 }
 
+// Advances the explosion animation; drawing is left to drawExplosion() in MainGame.c so this can run headless
 void explode(PROJECTILE* projectile) {
-	if (12-projectile->e > 8) {
-		GrayClipSprite16_TRANW_R(projectile->x,projectile->y,16,explosion1,explosion1+16,GrayGetPlane(LIGHT_PLANE),GrayGetPlane(DARK_PLANE));
-	} else if (12-projectile->e > 4) {
-		GrayClipSprite32_TRANW_R(projectile->x-8,projectile->y-8,32,explosion2,explosion2+32,GrayGetPlane(LIGHT_PLANE),GrayGetPlane(DARK_PLANE));
-	} else if (12-projectile->e > 0) {
-		GrayClipSprite32_TRANW_R(projectile->x-8,projectile->y-8,32,explosion3,explosion3+32,GrayGetPlane(LIGHT_PLANE),GrayGetPlane(DARK_PLANE));
-	} else {
+	if (projectile->e >= 12) {
 		projectile->exploding = FALSE;
 		projectile->e = 0;
 	}
 	projectile->e++; // projectile explosion counter
 }
 
-// Find terrain method for projectiles - determine whether can keep proceeding or whether hit a block
-static inline BOOL projLook(int tileX, int tileY) {
-	return (!((stageTemp->tileInfo[getTile(tileX,tileY)])&SOLID));
-}
-
 // End of Source File
\ No newline at end of file
@@ -0,0 +1,209 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - Replay.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Arena match recording and playback. The last single-calculator Arena match is kept in the variable tlreplay as
+// the seed it was played with, the settings, p1's keys as runs of ticks and the clock beats of every tick (one set
+// bit per beat, then a clear bit). Given those, sim_step plays the whole match out again exactly as it went, CPU
+// players and items included. A minute of play usually takes a few hundred bytes.
+
+#include "platform.h"
+#include "headers.h"
+
+#define REPLAY_MAGIC    0x544C5250UL // "TLRP"
+#define REPLAY_VERSION  7 // bump whenever the same input plays out differently:
+// 2: per-subsystem random number generators, 3: fixed-point knockback and pooled shots, 4: no combat coin flips,
+// 5: items that are picked up are held, 6: only strikes that can land are traded, 7: items fall under gravity
+#define MAX_KEY_RUNS    768
+#define MAX_BEAT_BYTES  2048 // about six minutes of beats; longer matches keep their first six minutes
+
+#define REPLAY_OFF       0
+#define REPLAY_RECORDING 1
+#define REPLAY_FULL      2 // recording ran out of room, the rest of the match is not logged
+#define REPLAY_PLAYING   3
+
+static unsigned int replayState = REPLAY_OFF;
+static REPLAY_HEADER header;
+static REPLAY_HEADER savedSettings; // the menu settings a playback replaces for its match
+static KEY_RUN* keyRuns = NULL;
+static unsigned char* beatBits = NULL;
+static unsigned short bitPos;
+static unsigned short runIndex, runTicks; // playback position in keyRuns
+
+static BOOL allocateLog(void);
+static void freeLog(void);
+
+// Starts logging the match about to be set up (seedMatch must already have been called for it)
+void startRecording(void) {
+	if (replayState != REPLAY_OFF || !allocateLog()) {
+		return; // not enough memory to spare - this match is just not recorded
+	}
+
+	captureSettings(&header);
+	header.seed = matchSeed;
+	header.numKeyRuns = 0;
+	header.numTicks = 0;
+	bitPos = 0;
+	memset(beatBits, 0, MAX_BEAT_BYTES);
+	replayState = REPLAY_RECORDING;
+}
+
+// Logs one tick's input frame
+void recordInput(const INPUT_FRAME* input) {
+	KEY_RUN* run;
+	unsigned int beats = input->beats;
+
+	if (replayState != REPLAY_RECORDING) {
+		return;
+	}
+	if ((unsigned long)bitPos + input->beats + 1 > MAX_BEAT_BYTES * 8 || header.numTicks == 0xFFFF) {
+		replayState = REPLAY_FULL;
+		return;
+	}
+
+	run = header.numKeyRuns ? keyRuns + header.numKeyRuns - 1 : NULL; // (no run before the first)
+	if (run == NULL || run->keys != input->keys[0] || run->ticks == 0xFFFF) {
+		if (header.numKeyRuns == MAX_KEY_RUNS) {
+			replayState = REPLAY_FULL;
+			return;
+		}
+		run = keyRuns + header.numKeyRuns++;
+		run->keys = input->keys[0];
+		run->ticks = 0;
+	}
+	run->ticks++;
+
+	while (beats--) {
+		beatBits[bitPos >> 3] |= 0x80 >> (bitPos & 7);
+		bitPos++;
+	}
+	bitPos++; // a clear bit ends the tick
+	header.numTicks++;
+}
+
+// Writes the log out as the last replay
+void stopRecording(void) {
+	FILE* out;
+
+	if (replayState != REPLAY_RECORDING && replayState != REPLAY_FULL) {
+		return;
+	}
+
+	header.magic = REPLAY_MAGIC;
+	header.version = REPLAY_VERSION;
+	header.numBeatBytes = (bitPos + 7) >> 3;
+
+	if ((out = fopen(REPLAY_FILENAME, "wb")) != NULL) {
+		fwrite(&header, sizeof(REPLAY_HEADER), 1, out);
+		fwrite(keyRuns, sizeof(KEY_RUN), header.numKeyRuns, out);
+		fwrite(beatBits, 1, header.numBeatBytes, out);
+		fputc(0, out);
+		fputs("tlrp", out);
+		fputc(0, out);
+		fputc(OTH_TAG, out); // custom file type, like the profiles
+		fclose(out);
+	}
+
+	freeLog();
+	replayState = REPLAY_OFF;
+}
+
+// Loads the last replay and puts its settings and seed in place; FALSE if there is none (or it is not readable)
+BOOL startPlayback(void) {
+	FILE* in;
+	BOOL ok;
+
+	if (replayState != REPLAY_OFF || (in = fopen(REPLAY_FILENAME, "rb")) == NULL) {
+		return FALSE;
+	}
+	if (!allocateLog()) {
+		fclose(in);
+		return FALSE;
+	}
+
+	ok = fread(&header, sizeof(REPLAY_HEADER), 1, in) == 1 && header.magic == REPLAY_MAGIC && header.version == REPLAY_VERSION
+		&& header.numKeyRuns <= MAX_KEY_RUNS && header.numBeatBytes <= MAX_BEAT_BYTES
+		&& fread(keyRuns, sizeof(KEY_RUN), header.numKeyRuns, in) == header.numKeyRuns
+		&& fread(beatBits, 1, header.numBeatBytes, in) == header.numBeatBytes;
+	fclose(in);
+	if (!ok || !header.numKeyRuns) {
+		freeLog();
+		return FALSE;
+	}
+
+	captureSettings(&savedSettings);
+	applySettings(&header);
+	runIndex = runTicks = 0;
+	bitPos = 0;
+
+	seedMatch(header.seed);
+	replayState = REPLAY_PLAYING;
+	return TRUE;
+}
+
+// Fills in the next tick's input frame from the replay; FALSE once every logged tick has been played (or every key
+// run, if a damaged replay claims more ticks than its runs hold - a match that goes on past them ends there)
+BOOL replayInput(INPUT_FRAME* input) {
+	if (replayState != REPLAY_PLAYING || !header.numTicks) {
+		return FALSE;
+	}
+
+	while (runIndex < header.numKeyRuns && runTicks == keyRuns[runIndex].ticks) {
+		runIndex++;
+		runTicks = 0;
+	}
+	if (runIndex >= header.numKeyRuns) {
+		return FALSE;
+	}
+
+	memset(input, 0, sizeof(INPUT_FRAME));
+	input->keys[0] = keyRuns[runIndex].keys;
+	runTicks++;
+
+	while (bitPos < (header.numBeatBytes << 3) && (beatBits[bitPos >> 3] & (0x80 >> (bitPos & 7)))) {
+		input->beats++;
+		bitPos++;
+	}
+	bitPos++;
+	header.numTicks--;
+	return TRUE;
+}
+
+BOOL playingBack(void) {
+	return replayState == REPLAY_PLAYING;
+}
+
+// Puts the menu settings back after a playback
+void stopPlayback(void) {
+	if (replayState != REPLAY_PLAYING) {
+		return;
+	}
+	applySettings(&savedSettings);
+	freeLog();
+	replayState = REPLAY_OFF;
+}
+
+static BOOL allocateLog(void) {
+	if ((keyRuns = malloc(MAX_KEY_RUNS * sizeof(KEY_RUN))) == NULL) {
+		return FALSE;
+	}
+	if ((beatBits = malloc(MAX_BEAT_BYTES)) == NULL) {
+		free(keyRuns);
+		keyRuns = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void freeLog(void) {
+	free(keyRuns);
+	free(beatBits);
+	keyRuns = NULL;
+	beatBits = NULL;
+}
+
+// End of Source File
@@ -0,0 +1,1740 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - Sim.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// This file contains the match simulation itself - setting a match up and stepping it a tick at a time (sim_step),
+// with the players' and bosses' fighting, the episode rules and the win checks. It draws nothing and reads no keys
+// (MainGame.c is the front end around it), and takes nothing from the calculator but platform.h, so it builds on a
+// PC as well (see host/Makefile).
+
+#include "platform.h"
+#include "headers.h"
+
+static unsigned int threshold = 0;
+
+static BOOL camera = FALSE;
+static BOOL alreadyHitting = FALSE;
+
+// Counters that outlast a single tick; setupMatch zeroes them so every match (and every replay of it) starts alike
+static unsigned int blastCounter; // blast plays out before a fall is scored
+static unsigned int entryCounter; // time on the entry platform
+static unsigned int cloakCounter;
+static unsigned int metalCounter;
+
+static const unsigned int NO_WINNER_FOUND = 48;
+
+// Animation frames are only resolved for the characters in a match, one cache slot per player
+static FRAME frameCache[MAX_PLAYERS][NUM_FRAMES];
+static unsigned char cachedCharacter[MAX_PLAYERS] = { NUM_CHARS, NUM_CHARS, NUM_CHARS, NUM_CHARS }; // NUM_CHARS = empty slot
+
+// Internal linkage file function prototypes
+
+static void resolveFrames(FRAME* frames, unsigned int k);
+static void clockTick(GAME_STATE* state);
+static BOOL runEpisodeRules(GAME_STATE* state);
+static BOOL episodeAction(GAME_STATE* state, const EPISODE_RULE* rule, PLAYER* p);
+
+static void setupP1(void); // need to combine these functions
+static void setupP2(void);
+static void setupP3(void);
+static void setupP4(void);
+
+static void controlPlayers(const INPUT_FRAME* input);
+static void checkForPlayerCollisions(void);
+static BOOL strikesFirst(PLAYER* a, PLAYER* b);
+static void holdPlayer(PLAYER* grabber, PLAYER* held);
+static LOCATION respawn(void);
+static BOOL playerAlreadyThere(int scrx, int scry); // at screen X and Y coordinates
+
+static unsigned int checkForWinnerTimed(void);
+static unsigned int checkForWinnerStock(void);
+static unsigned int checkForSuddenDeathWin(void);
+
+static int getXSpeed(PLAYER* p);
+static int getDamageToHitPlayer(PLAYER* p);
+
+static inline void setupHands(void);
+static void checkForPlayerHandCollision(void); // Boss Methods
+static inline BOOL playerCollidedWith(HAND* h);
+static BOOL checkForHandFightWin(void);
+static BOOL canDropHand(HAND* h);
+static void masterHandAI(void);
+static void crazyHandAI(void);
+
+static void fireSlam(HAND* h);
+static void tryToGrabPlayer(HAND* h);
+static void palmSlap(HAND* h);
+static void punch(HAND* h);
+static void swat(HAND* h);
+static void teamClap(HAND* h);
+
+static void (*handAttacks[6])(HAND* h) = { // different attacks that can be used by boss characters
+	fireSlam,
+	tryToGrabPlayer,
+	palmSlap,
+	punch,
+	swat,
+	teamClap
+};
+
+
+// One beat of the game clock: counts down timed matches and decides when to drop items
+static void clockTick(GAME_STATE* state) {
+	if (!gameMatchType) { // if a timed match (as opposed to a stock/lives match)
+		if (!timer->millis && !timer->seconds && !timer->minutes) { // time has expired
+			timer->running = FALSE;
+		} else {
+			timer->millis--;
+			if (timer->millis < 0) {
+				timer->millis = 20; // number set based on system hardware
+				timer->seconds--;
+				
+				if (timer->seconds < 0) {
+					timer->seconds = 59;
+					timer->minutes--;
+				}
+			}
+		}
+	}
+
+	// Determine on every cycle of ITEM_PROBABILITY whether to add a new item (for battles, not race to the finish)
+	// (only the choice is made here - sim_step adds it once the tick's beats have run)
+	if (!racing && !((++state->itemCounter) & (ITEM_PROBABILITY - 1)) && !randomFrom(RNG_ITEMS, gameItemProb * 20)) {
+		state->pendingItem = randomFrom(RNG_ITEMS, NUM_ITEMS) + 1;
+	}
+}
+
+// Runs the clock beats that came in since the last tick
+void runClock(GAME_STATE* state, unsigned int beats) {
+	while (beats--) {
+		clockTick(state);
+	}
+}
+
+// Puts the players, bosses, settings and stage in place for a new match (shared with the benchmark); the front end
+// sets up the planes to draw it with (see setupScene)
+void setupMatch(void) {
+	setupP1(); // could include these as an array of pointers to functions and have a loop that operates to make this look cleaner
+	if (numPlayers > 1) {
+		setupP2();
+	}
+	if (numPlayers > 2) {
+		setupP3();
+	}
+	if (numPlayers > 3) {
+		setupP4();
+	}	
+	memset(projectiles, 0, MAX_PROJECTILES * sizeof(PROJECTILE)); // no shots or explosions carried over from the last match
+	
+	if (numHands) {	// if this is now a boss level (for Episodes, Story, etc.), initialize bosses
+		masterHand->x = MASTER_HAND_X;
+		masterHand->y = 24;
+		masterHand->hitPoints = (currentProfile.difficulty == CLASSIC) ? BOSS_HP_CLASSIC : (currentProfile.difficulty == ADMIRAL ? BOSS_HP_ADMIRAL : (currentProfile.difficulty == PREMIERE ? BOSS_HP_PREMIERE : BOSS_HP_ELITE));
+		
+		masterHand->attackMarker = 0;
+		masterHand->handCounter = 0;
+		masterHand->attackIndex = 0;
+		masterHand->frameIndex = IDLE; // all frames are in tl_extra - access using extraptr
+	
+		masterHand->hovering = FALSE;
+		masterHand->holdingPlayer = FALSE;
+		masterHand->dropping = FALSE;
+		masterHand->spastic = FALSE; // if true, player has killed the boss AI!
+		masterHand->dead = FALSE;
+	  	
+	 	crazyHand->x = CRAZY_HAND_X;
+		crazyHand->y = 24;
+		crazyHand->hitPoints = (currentProfile.difficulty == PREMIERE ? BOSS_HP_PREMIERE : BOSS_HP_ELITE);
+		
+		crazyHand->attackMarker = 0;
+		crazyHand->handCounter = 0;
+		crazyHand->attackIndex = 0;
+		crazyHand->frameIndex = IDLE; // all frames are in tl_extra - access using extraptr
+	
+		crazyHand->hovering = FALSE;
+		crazyHand->holdingPlayer = FALSE;
+		crazyHand->dropping = FALSE;
+		crazyHand->spastic = FALSE;
+		crazyHand->dead = FALSE;		
+	}
+	
+	// reset teams here for classic mode
+	if (mode == STORY_MODE) {
+		switch (battleCounter) { // check which story level is being played and assign whether p1 gets allies
+			case 1:
+			p2->team = WHITE_TEAM, p4->team = p3->team = BLACK_TEAM;
+			break;
+			case 4:
+			p4->team = p3->team = p2->team = BLACK_TEAM;
+			break;
+			case 7:
+			p3->team = p2->team = LIGHTGRAY_TEAM;
+			break;
+		}
+	}
+	
+	if (mode != TOURNAMENT_MODE) {
+		gameDifficulty = currentProfile.difficulty;
+		gameMatchType = currentProfile.matchType;
+		gameMatchMinutes = currentProfile.matchMinutes;
+		gameCrowdPressure = currentProfile.crowdPressure;
+		gameMatchLives = currentProfile.matchLives;
+		gameItemProb = currentProfile.itemProb;
+	} else {
+		if (currentProfile.invitationalID > NONE) { // invitational mode - doesn't affect any settings!
+			gameDifficulty = (extraptr->invitationalList[currentProfile.invitationalID]).difficultyLevel;
+			gameMatchType = TIMED;
+			gameMatchMinutes = 2;
+			gameCrowdPressure = OFF;
+			gameItemProb = 5;
+			stageIndex = (extraptr->invitationalList[currentProfile.invitationalID]).stageIndex;
+		} else { // just tournament mode - settings can be changed
+			gameDifficulty = currentProfile.tDifficulty;
+			gameMatchType = currentProfile.tType;
+			gameMatchMinutes = currentProfile.tMatchMinutes;
+			gameCrowdPressure = currentProfile.tCrowdPressure;
+			gameMatchLives = currentProfile.tMatchLives;
+			gameItemProb = currentProfile.tItemProb;
+		}
+	}
+	
+	backIndex = 0; // currently no crowd pressure enabled
+	stageTemp = &stages[stageIndex];
+	buildCollisionGrid();
+	
+	x_fg = ((stageTemp->sw << 4) - 160) / 2; // center the stage horizontally
+	y_fg = 0;
+	x_bg = 4;
+	y_bg = 4;
+	
+	suddenDeath = FALSE;
+	timer->millis = 0;
+	timer->seconds = 0;
+	timer->minutes = gameMatchMinutes;
+	timer->running = !gameMatchType;
+	game.itemCounter = 0;
+	game.pendingItem = 0;
+	
+	blastCounter = entryCounter = cloakCounter = metalCounter = 0;
+	alreadyHitting = FALSE;
+	resetControls();
+}
+
+// Just like setting up a normal battle, set up a particular episode before beginning
+void setupEpisode(unsigned int episodeIndex) {
+	episodeSuccess = FALSE;
+	game.enemiesDefeated = 0;
+	game.episode = episodeIndex;
+	game.rules = extraptr->episodes[episodeIndex].rules;
+	numPlayers = extraptr->episodes[episodeIndex].playerNumber;
+
+	gameDifficulty = extraptr->episodes[episodeIndex].difficultyLevel;
+	gameMatchType = (episodeIndex == 19 ? TIMED : STOCK);
+	gameItemProb = currentProfile.itemProb;
+	
+	setupP1();
+	p1->numLives = extraptr->episodes[episodeIndex].p1numLives;
+	myPlayer = p1;
+	if (numPlayers > 1) {
+		p2->characterIndex = extraptr->episodes[episodeIndex].p2Index;
+		setupP2();
+		p2->numLives = extraptr->episodes[episodeIndex].p2numLives;
+		p2->team = BLACK_TEAM;
+	}
+	if (numPlayers > 2) {
+		p3->characterIndex = extraptr->episodes[episodeIndex].p3Index;
+		setupP3();
+		p3->numLives = extraptr->episodes[episodeIndex].p3numLives;
+		p3->team = BLACK_TEAM;
+	}
+	if (numPlayers > 3)	{
+		p4->characterIndex = extraptr->episodes[episodeIndex].p4Index;
+		setupP4();
+		p4->numLives = extraptr->episodes[episodeIndex].p4numLives;
+		p4->team = BLACK_TEAM;
+	}	
+
+	if (episodeIndex == 3) { // all samuses are permanently metalized
+		fightMetal = TRUE;
+	}
+	if (episodeIndex == 5) {
+		p2->team = WHITE_TEAM; // ally zelda with p1
+	}
+	if (episodeIndex == 12) {
+		fightCloaked = TRUE;
+	}	
+	if (episodeIndex == 14) {
+		p2->team = LIGHTGRAY_TEAM;
+		p3->team = DARKGRAY_TEAM;
+	}	
+	if (episodeIndex == 22) {
+		p2->team = DARKGRAY_TEAM;
+	}	
+	if (episodeIndex == 29) { // special level - master hand and crazy hand
+		numHands = 2;
+		setupHands();
+	}
+	
+	backIndex = randomFrom(RNG_MENUS, 2); // randomly enable crowd pressure in the background for episodes
+	stageTemp = &stages[extraptr->episodes[episodeIndex].levelIndex];
+	buildCollisionGrid();
+	
+	x_fg = ((stageTemp->sw << 4) - 160) / 2; // center the level to start
+	y_fg = 0;
+	x_bg = 4;
+	y_bg = 4;
+	
+	suddenDeath = FALSE;
+	timer->millis = 0;
+	timer->seconds = 0;
+	timer->minutes = 20;
+	timer->running = !gameMatchType; // start the timer if the episode should be timed
+	game.itemCounter = 0;
+	game.pendingItem = 0;
+}
+
+// Reset all hand (boss) statuses
+static inline void setupHands() {
+	masterHand->x = MASTER_HAND_X,
+	masterHand->y = 24,
+	masterHand->hitPoints = BOSS_HP_ELITE,
+	
+	masterHand->attackMarker = 0,
+	masterHand->handCounter = 0,
+	masterHand->attackIndex = 0,
+	masterHand->frameIndex = IDLE,
+
+	masterHand->hovering = FALSE,
+	masterHand->holdingPlayer = FALSE,
+	masterHand->dropping = FALSE,
+	masterHand->spastic = FALSE,
+	masterHand->dead = FALSE,
+  	
+  	crazyHand->x = CRAZY_HAND_X,
+	crazyHand->y = 24,
+	crazyHand->hitPoints = BOSS_HP_ELITE,
+	
+	crazyHand->attackMarker = 0,
+	crazyHand->handCounter = 0,
+	crazyHand->attackIndex = 0,
+	crazyHand->frameIndex = IDLE, // all frames are in tl_extra - access using extraptr
+
+	crazyHand->hovering = FALSE,
+	crazyHand->holdingPlayer = FALSE,
+	crazyHand->dropping = FALSE,
+	crazyHand->spastic = FALSE,
+	crazyHand->dead = FALSE;	
+}
+
+// Advance the match exactly one tick: camera, scrolling, players, bosses, collisions, episode rules and win checks.
+// Nothing in here draws or reads the keyboard; all human input comes in through the input frame.
+SIM_RESULT sim_step(GAME_STATE* state, const INPUT_FRAME* input) {
+	unsigned int a; // checking for sudden death
+	
+	state->result = SIM_RUNNING;
+	
+	if (!scrollL && !scrollR && !scrollD && !scrollU && !stageTemp->movingLevel && !myPlayer->onStage && !myPlayer->dead) { 
+		camera = TRUE; // adjusting the camera
+		if (myPlayer->x < 16 && x_fg > 0) {
+			scrollL = TRUE;
+			myPlayer->x += 2;
+		}
+		if (myPlayer->x+characters[myPlayer->characterIndex].w > 144 && x_fg < stageTemp->sw * 16 - 160) {
+			scrollR = TRUE;
+			myPlayer->x -= 2;
+		}
+		if (myPlayer->y < 16 && y_fg > 0) {
+			scrollU = TRUE;
+			myPlayer->y += 2;
+		}
+		if (myPlayer->y + characters[myPlayer->characterIndex].h > 84 && y_fg < stageTemp->sh * 16 - 100) {
+			scrollD = TRUE;
+			myPlayer->y -= 2;
+		}
+  	}
+  	
+	if (camera) { // same as above - normal: +2 for all, no ?'s asked
+		if (scrollL) {
+			if (myPlayer == p1) {
+  				p2->x += 2;
+			} else {
+  				p1->x += 2;
+			}
+			p3->x += 2;
+			p4->x += 2;
+  		}
+  		if (scrollR) {
+	  		if (myPlayer == p1) {
+	  			p2->x -= 2;
+			} else {
+	  			p1->x -= 2;	
+			}
+  			p3->x -= 2;
+			p4->x -= 2;
+	  	}
+ 		if (scrollU) {
+  			if (myPlayer == p1) {
+	  			p2->y += 2;
+			} else {
+	  			p1->y += 2;
+			}
+	  		p3->y += 2;
+			p4->y += 2;
+  		}
+	  	if (scrollD) {
+	  		if (myPlayer == p1) {
+	  			p2->y -= 2;
+			} else {
+	  			p1->y -= 2;
+			}
+	  		p3->y -= 2;
+			p4->y -= 2;
+	  	}
+	}
+	
+	scrollMaps(state); // move the foreground and background to the new offsets from scrolling
+	
+	runClock(state, input->beats);
+	if (state->pendingItem) {
+		BENCH_PHASE(BENCH_ITEMS);
+		addItem(state->pendingItem - 1);
+		state->pendingItem = 0;
+		BENCH_PHASE(BENCH_OTHER);
+	}
+	
+	// Timed Matches - check for winner
+	if (!gameMatchType) {
+		if (!timer->running) {
+			if ((a = checkForWinnerTimed()) < NO_WINNER_FOUND) {
+				state->winner = (TEAM)a;
+				episodeSuccess = TRUE; // do I need to do special code for episode mode here?
+				return (state->result = SIM_TIME_UP);
+			} else {
+				PLAYER *p = pHead, *bestPlayer = NULL;
+				int best = -30;
+				while (p != NULL) {
+					if (p->numKills - p->numTimesKilled > best) { // player has more points, make that player the comparative now
+						if (bestPlayer != NULL) {
+							bestPlayer->dead = TRUE; // found a new champ, send the other packing
+						}
+						bestPlayer = p;
+						best = p->numKills-p->numTimesKilled;
+					} else if (p->numKills-p->numTimesKilled < best) {
+						p->dead = TRUE;
+					}
+					p = p->next;
+				}
+				
+				p = pHead; // need to rescan, unfortunately, to pick up the real winners and put them back in
+				while (p != NULL) {
+					if (!p->dead) {
+						p->percent = 300;
+						p->numLives = 1;
+						p->onStage = TRUE;
+					}
+					p = p->next;
+				}
+				
+				suddenDeath = TRUE;
+				state->ticks = 0;
+				state->itemCounter = 0;
+				timer->millis = 0;
+				timer->seconds = 0;
+				timer->minutes = 1;
+				timer->running = TRUE;
+				return (state->result = SIM_SUDDEN_DEATH); // start it up again! - sudden death time, baby, yeah!
+			}
+		}
+	} else { // Stock Matches - check for winner 
+		if (!numHands && (a = checkForWinnerStock()) < NO_WINNER_FOUND) {
+			state->winner = (TEAM)a;
+			if (mode == EPISODE_MODE && a == myPlayer->team) {
+				episodeSuccess = TRUE;
+			}
+			return (state->result = SIM_GAME_SET);
+		}
+	}
+	
+	if (suddenDeath && ((a = checkForSuddenDeathWin()) < NO_WINNER_FOUND)) { // NO_WINNER_FOUND is maximum value; if winner found, the check for win function will return a smaller value
+		state->winner = (TEAM)a;
+		return (state->result = SIM_SUDDEN_DEATH_SET);
+	}
+	
+	BENCH_PHASE(BENCH_PLAYERS);
+	flyPlayers(); // everyone knocked into the air, before anyone is controlled
+	controlPlayers(input); // handle all players and AI BEFORE testing for collisions and attacks between them (gives equal opportunity)
+	
+	BENCH_PHASE(BENCH_HANDS);
+	if (numHands > 0 && !masterHand->dead) {
+		masterHandAI();
+	}
+	if (numHands > 1 && !crazyHand->dead) {
+		crazyHandAI();
+	}
+
+	BENCH_PHASE(BENCH_COLLISIONS);
+	sortAndSweep(); // one broad phase for the shots and for the fighters
+	moveProjectiles();
+	if (!numHands) {
+		checkForPlayerCollisions(); // between two players
+	} else {
+		checkForPlayerHandCollision(); // between player and boss
+	}
+	BENCH_PHASE(BENCH_OTHER);
+	
+	if (fightMetal) {
+		p2->metal = TRUE;
+		p3->metal = TRUE;
+		p4->metal = TRUE;
+	}
+	if (fightCloaked) {
+		p2->cloaked = TRUE;
+		p3->cloaked = TRUE;
+		p4->cloaked = TRUE;
+	}		
+	
+	if (mode == EPISODE_MODE) {
+		if (currentProfile.matchType && p1->dead) {
+			return (state->result = SIM_EPISODE_OVER);
+		}
+		if (runEpisodeRules(state)) {
+			return (state->result = SIM_EPISODE_OVER);
+		}
+	}
+	
+	if (numHands) { // boss battles
+		if (p1->dead) {
+			return (state->result = SIM_EPISODE_OVER);
+		}			
+		if (!masterHand->spastic && !crazyHand->spastic && (a = checkForHandFightWin())) {			
+			points[HAND_KILLER] = 20000 + (numHands - 1) * 20000;
+			state->winner = (TEAM)a;
+			episodeSuccess = TRUE;
+			return (state->result = SIM_HANDS_DEFEATED);
+		}
+	}
+	
+	return SIM_RUNNING;
+}
+
+// Runs the active episode's rules (see EPISODE_RULE); TRUE when one of them ends the episode
+static BOOL runEpisodeRules(GAME_STATE* state) {
+	const EPISODE_RULE* rule;
+	unsigned int slot;
+	
+	for (rule = state->rules; rule < state->rules + MAX_EPISODE_RULES && rule->trigger != RULE_END; rule++) {
+		switch (rule->trigger) {
+			case RULE_TICKS_PAST:
+			if (state->ticks <= rule->value) {
+				continue;
+			}
+			break;
+			
+			case RULE_EVERY_TICKS:
+			if (state->ticks & rule->value) {
+				continue;
+			}
+			break;
+			
+			case RULE_OPPONENT_DOWN:
+			for (slot = 1; slot < numPlayers; slot++) {
+				if (PLAYER_SLOT(slot)->dead) {
+					episodeAction(state, rule, PLAYER_SLOT(slot));
+				}
+			}
+			continue;
+			
+			case RULE_DEFEATED:
+			if (state->enemiesDefeated != rule->value) {
+				continue;
+			}
+			break;
+			
+			case RULE_DEFEATED_PAST:
+			if (state->enemiesDefeated <= rule->value) {
+				continue;
+			}
+			break;
+		}
+		if (episodeAction(state, rule, p2)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// One rule's action, on player p where it needs one; TRUE if it ends the episode
+static BOOL episodeAction(GAME_STATE* state, const EPISODE_RULE* rule, PLAYER* p) {
+	LOCATION spot;
+	
+	switch (rule->action) {
+		case DO_WIN_EPISODE:
+		episodeSuccess = TRUE; // and ends it
+		case DO_END_EPISODE:
+		return TRUE;
+		
+		case DO_TOGGLE_CLOAK:
+		fightCloaked = !fightCloaked;
+		break;
+		
+		case DO_RESPAWN:
+		if (rule->arg != SAME_CHARACTER) {
+			p->characterIndex = rule->arg;
+			p->frames = residentFrames(rule->arg);
+		}
+		spot = respawn();
+		p->numLives = 1;
+		p->dead = FALSE;
+		p->x = spot.x + 8 - ((characters[p->characterIndex].w) / 2) - x_fg;
+		p->y = spot.y - (characters[p->characterIndex].h) - ((characters[p->characterIndex].h) & 1) + 16 - y_fg;
+		state->enemiesDefeated++;
+		break;
+		
+		case DO_SWAP_OPPONENT:
+		if (p->characterIndex != rule->arg) {
+			p->characterIndex = rule->arg;
+			p->frames = residentFrames(rule->arg);
+		}
+		break;
+	}
+	return FALSE;
+}
+
+// Match flags and words outside the player block that sim_step changes, for snapshots and quicksaves
+static void* const matchFlags[] = {
+	&scrollL, &scrollR, &scrollU, &scrollD, &camera, &alreadyHitting,
+	&disabled, &suddenDeath, &complete, &fightMetal, &fightCloaked, &episodeSuccess
+};
+static void* const matchWords[] = {
+	&x_fg, &y_fg, &x_bg, &y_bg, &collapse, &scrollType, &playerKeys, &threshold, &backIndex,
+	&blastCounter, &entryCounter, &cloakCounter, &metalCounter,
+	&game.ticks, (void*)&game.itemCounter, (void*)&game.pendingItem, &game.enemiesDefeated, &game.winner
+}; // (not the beat counter, which belongs to the timer interrupt)
+
+#define NUM_MATCH_FLAGS (sizeof(matchFlags) / sizeof(void*))
+#define NUM_MATCH_WORDS (sizeof(matchWords) / sizeof(void*))
+
+// Copies everything sim_step changes into or out of a snapshot (snapshot may be NULL for STATE_SIZE); returns its
+// size. Linked matches keep a few of these to roll back to (see Link.c).
+unsigned int matchState(void* snapshot, STATE_TRANSFER how) {
+	char* at = snapshot;
+	unsigned int i;
+	
+	at = transferState(at, p1, (char*)crazyHand + sizeof(HAND) - (char*)p1, how); // players, timer, projectiles and hands share one block
+	for (i = 0; i < NUM_MATCH_FLAGS; i++) {
+		at = transferState(at, matchFlags[i], sizeof(BOOL), how);
+	}
+	for (i = 0; i < NUM_MATCH_WORDS; i++) {
+		at = transferState(at, matchWords[i], sizeof(int), how);
+	}
+	at = transferState(at, rngStreams, RNG_MENUS * sizeof(unsigned long), how); // the menu stream is not part of the match
+	at = itemState(at, how);
+	at = playerState(at, how);
+	return at - (char*)snapshot;
+}
+
+// A quicksave holds the same as a snapshot, but has to outlast the program (so no pointers) and sits in every
+// profile's folder (so as small as it will go): what setupMatch needs to set the same match up again, then numbers
+// as packWord varints, flags as bits, pointers as slots and indexes, and the random number streams as they are.
+#define QUICKSAVE_VERSION 4 // bump whenever what quicksaveState packs changes
+
+static void* const quicksaveSettings[] = {
+	&stageIndex, &numPlayers, &gameDifficulty, (void*)&gameMatchType, &gameMatchMinutes, (void*)&gameCrowdPressure,
+	&gameMatchLives, &gameItemProb
+};
+
+static const unsigned char playerSignedFields[] = {
+	offsetof(PLAYER, x), offsetof(PLAYER, y), offsetof(PLAYER, xspeed), offsetof(PLAYER, yspeed), offsetof(PLAYER, jumpValue),
+	offsetof(PLAYER, numKills), offsetof(PLAYER, numTimesKilled), offsetof(PLAYER, moveSpeed), offsetof(PLAYER, direction)
+};
+static const unsigned char playerUnsignedFields[] = {
+	offsetof(PLAYER, percent), offsetof(PLAYER, frac), offsetof(PLAYER, numLives), offsetof(PLAYER, power), offsetof(PLAYER, size),
+	offsetof(PLAYER, characterIndex), offsetof(PLAYER, numJumps), offsetof(PLAYER, playerCounter), offsetof(PLAYER, attackMarker),
+	offsetof(PLAYER, shots), offsetof(PLAYER, pointsHolder[0]), offsetof(PLAYER, pointsHolder[1]), offsetof(PLAYER, pointsHolder[2]),
+	offsetof(PLAYER, team), offsetof(PLAYER, type)
+};
+
+#define STATUS_FLAGS_AT   (offsetof(PLAYER, pointsHolder) + sizeof(((PLAYER*)0)->pointsHolder)) // the bitfield, copied whole
+#define STATUS_FLAGS_SIZE (offsetof(PLAYER, direction) - STATUS_FLAGS_AT)
+
+// Packs the match into a quicksave or back out of one (blob may be NULL for STATE_SIZE); returns its size, or 0 for
+// a quicksave from another version. A load sets the stage and fighters up as well, so it is done once before
+// setupMatch and again after it.
+unsigned int quicksaveState(char* blob, STATE_TRANSFER how) {
+	char* at = blob;
+	PLAYER* p;
+	PROJECTILE* j;
+	unsigned int version = QUICKSAVE_VERSION, bits = 0, slot, i, refs[3];
+	
+	at = packWord(at, &version, FALSE, how);
+	if (version != QUICKSAVE_VERSION) {
+		return 0;
+	}
+	for (i = 0; i < sizeof(quicksaveSettings) / sizeof(void*); i++) {
+		at = packWord(at, quicksaveSettings[i], TRUE, how);
+	}
+	
+	for (i = 0; i < NUM_MATCH_FLAGS; i++) {
+		bits |= (*(BOOL*)matchFlags[i] != FALSE) << i;
+	}
+	at = packWord(at, &bits, FALSE, how);
+	for (i = 0; i < NUM_MATCH_FLAGS && how == STATE_LOAD; i++) {
+		*(BOOL*)matchFlags[i] = (bits >> i) & 1;
+	}
+	for (i = 0; i < NUM_MATCH_WORDS; i++) {
+		at = packWord(at, matchWords[i], TRUE, how);
+	}
+	at = packWord(at, (void*)&timer->millis, TRUE, how);
+	at = packWord(at, (void*)&timer->seconds, TRUE, how);
+	at = packWord(at, (void*)&timer->minutes, TRUE, how);
+	at = packWord(at, (void*)&timer->running, FALSE, how);
+	at = transferState(at, rngStreams, RNG_MENUS * sizeof(unsigned long), how);
+	
+	for (slot = 0; slot < numPlayers; slot++) {
+		p = PLAYER_SLOT(slot);
+		for (i = 0; i < sizeof(playerSignedFields); i++) {
+			at = packWord(at, (char*)p + playerSignedFields[i], TRUE, how);
+		}
+		for (i = 0; i < sizeof(playerUnsignedFields); i++) {
+			at = packWord(at, (char*)p + playerUnsignedFields[i], FALSE, how);
+		}
+		at = transferState(at, (char*)p + STATUS_FLAGS_AT, STATUS_FLAGS_SIZE, how);
+		
+		if (how != STATE_LOAD) {
+			refs[0] = p->rightCurrent - p->frames;
+			refs[1] = p->leftCurrent - p->frames;
+			refs[2] = (p->enemy != NULL) ? p->enemy - p1 : MAX_PLAYERS;
+		}
+		for (i = 0; i < 3; i++) {
+			at = packWord(at, &refs[i], FALSE, how);
+		}
+		if (how == STATE_LOAD) {
+			p->frames = residentFrames(p->characterIndex);
+			p->rightCurrent = &p->frames[refs[0]];
+			p->leftCurrent = &p->frames[refs[1]];
+			p->enemy = (refs[2] < numPlayers) ? PLAYER_SLOT(refs[2]) : NULL;
+			p->currentItem = NULL; // (itemQuicksave hands the held items back)
+			p->next = (slot + 1 < numPlayers) ? PLAYER_SLOT(slot + 1) : NULL;
+		}
+	}
+	pHead = p1;
+	
+	for (j = projectiles; j < projectiles + MAX_PROJECTILES; j++) {
+		at = packWord(at, &j->x, TRUE, how);
+		at = packWord(at, &j->y, TRUE, how);
+		at = packWord(at, &j->dir, TRUE, how);
+		at = packWord(at, &j->distance, FALSE, how);
+		at = packWord(at, &j->e, FALSE, how);
+		at = packWord(at, &j->owner, FALSE, how);
+		bits = (j->flying != FALSE) | ((j->exploding != FALSE) << 1);
+		at = packWord(at, &bits, FALSE, how);
+		j->flying = bits & 1, j->exploding = (bits >> 1) & 1;
+		j->data = bullet;
+	}
+	
+	at = itemQuicksave(at, how);
+	at = playerQuicksave(at, how);
+	return at - blob;
+}
+
+static void setupP1(void) {
+	p1->x = 16, p1->y = 16;
+	p1->jumpValue = 0;
+	p1->numKills = 0, p1->numTimesKilled = 0;
+	p1->moveSpeed = WALKSPEED;
+	p1->xspeed = 0;
+	p1->yspeed = 0;
+	p1->frac = 0;
+	p1->numLives = (mode == ARENA_MODE) ? currentProfile.matchLives : ((mode == TOURNAMENT_MODE) ? currentProfile.tMatchLives : (cont ? currentProfile.matchLives : p1ClassicLives));
+	
+	setupPlayerInGame(p1);
+	
+	if (mode != TOURNAMENT_MODE) {
+		p1->type = HUMAN; // human in all other modes guaranteed; tournament mode can be human watching a battle between 2 AI players
+	}
+	
+	p1->currentItem = NULL;	
+	p1->rightCurrent = &p1->frames[STAND_RIGHT];
+	p1->leftCurrent = &p1->frames[STAND_LEFT];
+	
+	p1->enemy = NULL;
+	p1->next = NULL;
+	pHead = p1;
+}
+
+static void setupP2(void) {
+	p2->x = 112, p2->y = 16;
+	p2->jumpValue = 0;
+	p2->numKills = 0, p2->numTimesKilled = 0;
+	p2->moveSpeed = WALKSPEED;
+	p2->xspeed = 0;
+	p2->yspeed = 0;
+	p2->frac = 0;
+	p2->numLives = (mode == ARENA_MODE) ? currentProfile.matchLives : ((mode == TOURNAMENT_MODE) ? currentProfile.tMatchLives : 1);
+		
+	setupPlayerInGame(p2);
+	
+	p2->type = (linked) ? HUMAN : CPU;
+	p2->currentItem = NULL;
+	p2->rightCurrent = &p2->frames[STAND_RIGHT];
+	p2->leftCurrent = &p2->frames[STAND_LEFT];
+	
+	p2->enemy = NULL;
+	p2->next = NULL;
+	p1->next = p2;
+}
+
+static void setupP3(void) {
+	p3->x = 80, p3->y = 16;
+	p3->jumpValue = 0;
+	p3->numKills = 0, p3->numTimesKilled = 0;
+	p3->moveSpeed = WALKSPEED;
+	p3->xspeed = 0;
+	p3->yspeed = 0;
+	p3->frac = 0;
+	p3->numLives = (mode==ARENA_MODE)?currentProfile.matchLives:1;
+	
+	setupPlayerInGame(p3);
+	
+	p3->type = CPU;		
+	p3->currentItem = NULL;
+	p3->rightCurrent = &p3->frames[STAND_RIGHT];
+	p3->leftCurrent = &p3->frames[STAND_LEFT];
+	
+	p3->enemy = NULL;
+	p3->next = NULL;
+	p2->next = p3;
+}
+
+static void setupP4(void) {
+	p4->x = 48, p4->y = 16,
+	p4->jumpValue = 0, // needed?
+	p4->numKills = 0, p4->numTimesKilled = 0,
+	p4->moveSpeed = WALKSPEED,
+	p4->xspeed = 0,
+	p4->yspeed = 0,
+	p4->frac = 0,
+	p4->numLives = (mode==ARENA_MODE)?currentProfile.matchLives:1;
+	
+	setupPlayerInGame(p4); // this separate method saves 438 bytes!
+	
+	p4->type = CPU,
+	p4->currentItem = NULL,
+	p4->rightCurrent = &p4->frames[STAND_RIGHT],
+	p4->leftCurrent = &p4->frames[STAND_LEFT],
+	
+	p4->enemy = NULL,
+	p4->next = NULL,
+	p3->next = p4;
+}
+
+// Every pair of fighters that overlap is settled once a tick, from where everyone stands after moving: grabs first, then
+// strikes. A strike can only land facing whom it hits, and not on someone invincible; when both strikes could land (or
+// both have a grab out), the one who started theirs first wins it (see strikesFirst). Hits are only landed once every
+// pair has been looked at, so no pair's outcome depends on another's.
+static void checkForPlayerCollisions(void) {
+	PLAYER *a, *b;
+	HIT_EVENT hits[MAX_HITS];
+	int left[MAX_PLAYERS]; // each fighter's hitbox - their middle 16 pixels - worked out once
+	BOOL ready[MAX_PLAYERS], attacking[MAX_PLAYERS], aLands, bLands;
+	unsigned int i, k, numHits = 0;
+	
+	for (i = 0; i < numPlayers; i++) { // testing for collisions AFTER players have been handled to ensure fair chances
+		a = PLAYER_SLOT(i);
+		left[i] = a->x + (characters[a->characterIndex].w / 2) - 8;
+		ready[i] = !a->dead && !a->paralyzed && !a->onStage;
+		attacking[i] = a->smashAttacking || a->specialAttacking || a->skyAttacking;
+	}
+	
+	for (i = 0; i < numPlayers; i++) {
+		a = PLAYER_SLOT(i);
+		for (k = i + 1; k < numPlayers; k++) {
+			b = PLAYER_SLOT(k);
+			if (!ready[i] || !ready[k] || a->team == b->team || !mayTouch(a,b) || !playersCollided(a,b)) {
+				continue;
+			}
+			
+			if (a->grabbing || b->grabbing) {
+				if (a->grabbing && (!b->grabbing || strikesFirst(a,b))) {
+					holdPlayer(a,b);
+				} else {
+					holdPlayer(b,a);
+				}
+			} else {
+				aLands = attacking[i] && ((left[i] > left[k]) ? a->direction < 0 : a->direction > 0) && !b->invincible;
+				bLands = attacking[k] && ((left[k] > left[i]) ? b->direction < 0 : b->direction > 0) && !a->invincible;
+				if (aLands && (!bLands || strikesFirst(a,b))) {
+					hits[numHits++] = (HIT_EVENT){a, b};
+				} else if (bLands) {
+					hits[numHits++] = (HIT_EVENT){b, a};
+				}
+			}
+		}
+	}
+	
+	for (i = 0; i < numHits; i++) {
+		b = hits[i].target;
+		if (!b->paralyzed) { // one knockback a tick: the first hit in slot order lands, and any others on them miss
+			b->enemy = hits[i].attacker; // (damage and knockback go by who hit them - and they will want to hit back)
+			b->percent += getDamageToHitPlayer(b), launchPlayer(b, getXSpeed(b));
+		}
+	}
+}
+
+// Whether a's grab or attack beats b's when both have one out: whoever started theirs earlier, then whoever is less
+// hurt, then the lower slot - no coin flip, so a trade comes out the same on a replay or either linked calculator
+static BOOL strikesFirst(PLAYER* a, PLAYER* b) {
+	unsigned int aSince = a->playerCounter - a->attackMarker, bSince = b->playerCounter - b->attackMarker;
+	
+	if (aSince != bSince) {
+		return aSince > bSince;
+	}
+	if (a->percent != b->percent) {
+		return a->percent < b->percent;
+	}
+	return a < b;
+}
+
+// grabber catches held (unless held is invincible or grabber's hands are full), and the two become each other's enemy
+static void holdPlayer(PLAYER* grabber, PLAYER* held) {
+	if (!held->invincible && (grabber->enemy == NULL || grabber->enemy == held || !grabber->enemy->beingHeld)) {
+		held->beingHeld = TRUE, held->grabbing = FALSE;
+		held->enemy = grabber;
+		grabber->enemy = held;
+	}
+}
+
+static void checkForPlayerHandCollision(void) {// only use p1, master hand, and crazy hand
+	BOOL set = FALSE;
+	if (!p1->invincible && !p1->paralyzed && !p1->onStage) {
+		if (playerCollidedWith(masterHand) && !masterHand->dead) {
+			set = TRUE;
+			
+			if (p1->smashAttacking || p1->specialAttacking || p1->skyAttacking) {
+				if (!alreadyHitting) {
+					masterHand->hitPoints -= 9+randomFrom(RNG_COMBAT, 4)+(p1->skyAttacking*8), alreadyHitting = TRUE;
+				}
+			} else {
+				alreadyHitting = FALSE;
+			}
+			
+			if (masterHand->attackIndex > 0 && masterHand->attackIndex != 1 && !masterHand->spastic) {
+				p1->percent += 16+((masterHand->attackIndex>5)*8),	launchPlayer(p1, -(randomFrom(RNG_COMBAT, 3)*2));
+			}
+		}
+		
+		if (numHands > 0 && playerCollidedWith(crazyHand) && !set && !crazyHand->dead) {
+			if (p1->smashAttacking || p1->specialAttacking || p1->skyAttacking) {
+				if (!alreadyHitting) {
+					crazyHand->hitPoints -= 9+randomFrom(RNG_COMBAT, 4)+(p1->skyAttacking*8), alreadyHitting = TRUE;
+				}
+			} else {
+				alreadyHitting = FALSE;
+			}
+			
+			if (crazyHand->attackIndex > 0 && crazyHand->attackIndex != 1 && !crazyHand->spastic) {
+				p1->percent += 16+((crazyHand->attackIndex>5)*8),	launchPlayer(p1, randomFrom(RNG_COMBAT, 3)*2);
+			}
+		}
+	}	
+}
+
+static void masterHandAI(void) {	
+	if (scrollL) {
+		masterHand->x += p1->moveSpeed;
+	}
+	if (scrollR) {
+		masterHand->x -= p1->moveSpeed;
+	}
+	if (scrollD) {
+		masterHand->y -= 2;
+	}
+	if (scrollU) {
+		masterHand->y += 2;
+	}
+	
+	if (masterHand->attackIndex > 0 && !masterHand->spastic) {
+		handAttacks[masterHand->attackIndex - 1](masterHand);
+	} else {// not attacking, so see if I want to
+		BOOL adjusting = FALSE;
+		
+		// adjust master hand back to normal position
+		if (masterHand->x + x_fg < MASTER_HAND_X + 32) {
+			masterHand->x += 4, adjusting = TRUE;
+		}
+		if (masterHand->y + y_fg > 20) {
+			masterHand->y -= 4, adjusting = TRUE;
+		}
+				
+		if ((masterHand->handCounter & 63) == 0 && !adjusting) {
+			masterHand->attackIndex = randomFrom(RNG_AI, (numHands>1)?6:5)+1; // don't allow clapping if only one hand
+		}
+	}
+	
+	if ((masterHand->handCounter & 15) == 0) { // could add a fatigue factor - breathe faster if the p has larger HP (between 32 and 64)
+		masterHand->hovering = !masterHand->hovering;
+	}
+	
+	// update hand frames
+	
+	if (!masterHand->attackIndex) { // if not attacking, hover
+		masterHand->frameIndex = masterHand->hovering;
+	}
+	
+	if (masterHand->holdingPlayer) {
+		BOOL a = playerCollidedWith(masterHand);
+		if (!a) {
+			masterHand->x -= 4;
+		}
+		if (masterHand->handCounter-masterHand->attackMarker > 8) {
+			masterHand->frameIndex = TRY_TO_CATCH;
+		}
+		if (masterHand->frameIndex == TRY_TO_CATCH) {
+			if (a) {
+				masterHand->frameIndex = HOLDING_PLAYER, p1->beingHeld = TRUE;
+			} else {
+				masterHand->frameIndex = MISS, masterHand->attackIndex = 0, masterHand->holdingPlayer = FALSE;
+			}
+		}
+	}
+	
+	if (p1->beingHeld && masterHand->handCounter-masterHand->attackMarker > 25) {
+		p1->beingHeld = FALSE, masterHand->attackIndex = 0, masterHand->holdingPlayer = FALSE, p1->percent+=10;
+	}
+	
+	if (!masterHand->hitPoints && !masterHand->spastic) {
+		masterHand->spastic = TRUE, masterHand->attackMarker = masterHand->handCounter;
+	}
+	
+	if (masterHand->spastic) { // do the convulsing animation for a dying boss
+		if ((masterHand->handCounter & 7) == 0) {
+			masterHand->frameIndex = (!masterHand->hovering)+2;
+		}
+		if (masterHand->handCounter - masterHand->attackMarker > 128) {
+			masterHand->spastic = FALSE, masterHand->dead = TRUE;
+		}
+	}
+	
+	masterHand->handCounter++;
+}
+
+static void crazyHandAI(void) { // bases its clapping on masterhand
+	if (scrollL) {
+		crazyHand->x += p1->moveSpeed;
+	}
+	if (scrollR) {
+		crazyHand->x -= p1->moveSpeed;
+	}
+	if (scrollD) {
+		crazyHand->y -= 2;
+	}
+	if (scrollU) {
+		crazyHand->y += 2;
+	}
+	
+	if (crazyHand->attackIndex > 0 && !crazyHand->spastic) {
+		handAttacks[crazyHand->attackIndex - 1](crazyHand);
+	} else { // not attacking, so see if I (crazy hand) want to (var is unsigned)
+		BOOL adjusting = FALSE;
+		// adjust crazy hand back to normal position
+		if (crazyHand->x + x_fg > CRAZY_HAND_X + 32) {
+			crazyHand->x -= 4, adjusting = TRUE;
+		}
+		if (crazyHand->y + y_fg > 20) {
+			crazyHand->y -= 4, adjusting = TRUE;
+		}
+				
+		if ((crazyHand->handCounter & 63) == 0 && !adjusting) {// use handCounter instead of random with &
+			crazyHand->attackIndex = (masterHand->attackIndex > 5) ? 6 : ((masterHand->attackIndex == 4) ? 4 : randomFrom(RNG_AI, 5) + 1); // don't allow clapping if only one hand
+		}
+	}
+	
+	if ((crazyHand->handCounter & 15) == 0) { // could add a fatigue factor - breathe faster if the p has larger HP
+		crazyHand->hovering = !crazyHand->hovering;
+	}
+	
+	// update frames
+	
+	if (!crazyHand->attackIndex) { // if not attacking, hover
+		crazyHand->frameIndex = crazyHand->hovering;
+	}
+	
+	if (crazyHand->holdingPlayer) {
+		BOOL a = playerCollidedWith(crazyHand);
+		if (!a) {
+			crazyHand->x += 4;
+		}
+		if (crazyHand->handCounter - crazyHand->attackMarker > 8) {
+			crazyHand->frameIndex = TRY_TO_CATCH;
+		}
+		if (crazyHand->frameIndex == TRY_TO_CATCH) {
+			if (a) {
+				crazyHand->frameIndex = HOLDING_PLAYER;
+				p1->beingHeld = TRUE;
+			} else {
+				crazyHand->frameIndex = MISS;
+				crazyHand->attackIndex = 0;
+				crazyHand->holdingPlayer = FALSE;
+			}
+		}
+	}
+	
+	if (p1->beingHeld && crazyHand->handCounter-crazyHand->attackMarker > 25) {
+		p1->beingHeld = FALSE;
+		crazyHand->attackIndex = 0;
+		crazyHand->holdingPlayer = FALSE;
+		p1->percent += 10;
+	}
+	
+	if (!crazyHand->hitPoints && !crazyHand->spastic) {
+		crazyHand->spastic = TRUE;
+		crazyHand->attackMarker = crazyHand->handCounter;
+	}
+	
+	if (crazyHand->spastic) {
+		if ((crazyHand->handCounter & 7) == 0) { // if on an 8px group boundary
+			crazyHand->frameIndex = (!crazyHand->hovering) + 2;
+		}
+		if (crazyHand->handCounter - crazyHand->attackMarker > 128) {
+			crazyHand->spastic = FALSE;
+			crazyHand->dead = TRUE;
+		}
+	}
+	
+	crazyHand->handCounter++; // keep a running timer for crazy hand at which to make decisions at different intervals
+}
+
+// special attack: fire slam for master/crazy hand
+static void fireSlam(HAND* h) {
+	if (!h->dropping) {
+		if (h->y > -32) {
+			h->y -= 4;
+		}
+		if (h == masterHand) {
+			if (h->x > p1->x) {
+				h->x -= 2;
+				h->dropping = FALSE;
+			} else {
+				h->dropping = TRUE;
+			}
+		} else {
+			if (h->x < p1->x) {
+				h->x += 2, h->dropping = FALSE;
+			} else {
+				h->dropping = TRUE;
+			}
+		}		
+	} else {
+		h->frameIndex = FIRE_SLAM;
+		h->dropping = TRUE;
+		
+		if (canDropHand(h)) { // drop and smash them!
+			h->y += 8;
+		} else {
+			h->attackIndex = 0, h->dropping = FALSE;
+		}
+	}
+}
+
+// boss move: grab a human player to temporarily disable their moves and hit them
+static void tryToGrabPlayer(HAND* h) {
+	if (h == masterHand || (h == crazyHand && !masterHand->holdingPlayer)) {
+		if (!h->holdingPlayer) {
+			h->attackMarker = h->handCounter;
+			h->frameIndex = PREP_GRAB;
+		}
+		h->holdingPlayer = TRUE;
+	}
+}
+
+// boss move: slap a player
+static void palmSlap(HAND* h) {
+	h->frameIndex = PALM_SLAP;
+	if (canDropHand(h)) { // drop and smash them!
+		h->y += 4;
+	} else {
+		h->x += (h == masterHand) ? -4 : 4;
+	}
+	
+	if ((h == crazyHand && h->x + x_fg > 160) || (h == masterHand && h->x + x_fg < 32)) {
+		h->attackIndex = 0;
+	}
+}
+
+// simple punch attack (boss move)
+static void punch(HAND* h) {
+	h->frameIndex = PUNCH;
+			
+	if (canDropHand(h)) { // drop and smash them!
+		h->y += 4;
+	} else {
+		h->x += (h == masterHand) ? -4 : 4;
+	}
+	
+	if (h == masterHand) {
+		if (h->x + x_fg < 36 || (crazyHand->attackIndex == 4 && crazyHand->x + 32 > h->x)) {
+			h->attackIndex = 0;
+		}
+	} else {
+		if (h->x + 32 > masterHand->x) {
+			h->attackIndex = 0;
+		}
+	}
+}
+
+// hand attack: simple swat
+static void swat(HAND* h) {
+	if (canDropHand(h)) {// drop and smash them!
+		h->y += 4;
+	} else {
+		h->x += (h == masterHand) ? -4 : 4;
+	}
+	
+	if (((h->x + x_fg) & 31) == 0) {
+		h->frameIndex = SWAT_FRONTSWING;
+	} else if (((h->x + x_fg) & 15) == 0) {
+		h->frameIndex = SWAT_BACKSWING;
+	}
+	
+	if ((h == crazyHand && h->x + x_fg > 160) || (h == masterHand && h->x + x_fg < 32)) {
+		h->attackIndex = 0;
+	}
+}
+
+// coordinate clap attack between the two bosses
+static void teamClap(HAND* h) {
+	h->frameIndex = TEAMWORK_CLAP;
+	if (canDropHand(h)) {// drop and smash them!
+		h->y += 4;
+	} else {
+		h->x += (h == masterHand) ? -4 : 4;
+	}
+	
+	if (h == masterHand) {
+		if (crazyHand->x + 32 > h->x) {
+			h->attackIndex = 0;
+		}
+	} else {
+		if (h->x + 32 > masterHand->x) {
+			h->attackIndex = 0;
+		}
+	}	
+}
+
+// return whether the boss can drop any further from hovering to the stage
+static BOOL canDropHand(HAND* h) {
+	if ((tileFlags(h->x + x_fg + 16,h->y + y_fg + 32)) & GRID_SOLID) { // if a solid tile, cannot go any lower
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static inline BOOL playerCollidedWith(HAND* h) {// same as playersCollided, but modified for hands
+	if (p1->x + characters[p1->characterIndex].w - 1 < h->x || p1->x > h->x + 31 || p1->y > h->y + 31 || p1->y+characters[p1->characterIndex].h - 1 < h->y) {
+		return FALSE;
+  	}
+	return TRUE;
+}
+
+// determine whether the boss battle has ended
+static BOOL checkForHandFightWin(void) {
+	if (numHands < 2 && masterHand->dead) {
+		return TRUE;
+	}
+	if (masterHand->dead && crazyHand->dead) {
+		return TRUE;
+	}
+	return FALSE;
+}
+
+// find a suitable location in the current scrolling area of the tilemap to reintroduce a player w/ remaining lives (works for characters of any size)
+static LOCATION respawn(void) {
+	// gets the first topmost leftmost tile based on the current coordinates
+	int tileStartX = (x_fg + (16 - (x_fg & 15))), tileStartY = (y_fg + (16 - (y_fg & 15)));
+	int loopX = 0, loopY = 0, columnY;
+	
+	do {		
+		do {
+			if (tileFlags(tileStartX + (loopX * 16), tileStartY + (loopY * 16)) == GRID_EMPTY && !playerAlreadyThere(tileStartX + (loopX * 16), tileStartY + (loopY * 16))) {		
+				columnY = tileStartY + ((loopY + 1) * 16); // scan the tile starting below, so add the +1
+				do {
+					unsigned char info = tileFlags(tileStartX + (loopX * 16), columnY); // get the current tile type
+					if (info == GRID_SOLID || info == (GRID_SOLID | GRID_CLOUD)) {
+						return (LOCATION){tileStartX + (loopX * 16), tileStartY + (loopY * 16)};
+					}
+					columnY += 16;				
+				} while (columnY < 96);
+			}			
+			loopX++;
+		} while (loopX < 8);
+		loopX = 0, loopY++;
+	} while (loopY < 5);
+	
+	return (LOCATION){0,0}; // default, so no compiler warning
+}
+
+// prevent respawning players on top of each other with this helper function
+static BOOL playerAlreadyThere(int scrx, int scry) {
+	PLAYER* temp = pHead;
+	while (temp != NULL) { // must be respawning also, else, doesn't matter anyway
+		if (temp->onStage && ((temp->x + x_fg + ((characters[temp->characterIndex].w) / 2) - 8) == scrx && (temp->y + y_fg + ((characters[temp->characterIndex].h) - 16)) == scry)) {
+			return TRUE;
+		}
+		temp = temp->next;
+	}
+	return FALSE;
+}
+
+// the main control loop across all players: handle all player interactions and input
+static void controlPlayers(const INPUT_FRAME* input) {
+	PLAYER* t;
+	unsigned int slot; // slot also picks each player's keys out of the input frame
+	
+	scheduleAI();
+	for (slot = 0; slot < numPlayers; slot++) {
+		t = PLAYER_SLOT(slot);
+		playerKeys = input->keys[slot];
+		if (!t->dead) {
+			if (t != myPlayer) {
+				if (scrollL)	{
+					t->x += myPlayer->moveSpeed;
+				}
+				if (scrollR)	{
+					t->x -= myPlayer->moveSpeed;
+				}
+				if (scrollD)	{
+					t->y -= 2;
+				}
+				if (scrollU)	{
+					t->y += 2;
+				}
+			} // in link play, the master/head calc manages all AI and p1 players; join calc is p2
+			
+			if (!t->onStage) {
+		  		if (checkForDeathEvent(t)) { // if a player has fallen from some "death event," need to account for that - ending the game, scores, etc.
+					if (mode == STORY_MODE) {
+						if (t == p1) {
+							points[SLAYED] += 50;
+						} else if (t->enemy == p1) {
+							points[SLAYER] += 125;
+						}
+					}
+					
+					if (++blastCounter >= 16) { // let the blast play out (see renderMaps) before scoring the fall
+						if (t->enemy != NULL) {
+							t->enemy->numKills++;
+						}
+						
+						if (gameMatchType) { // stock matches: number of remaining lives
+							t->numLives--;
+						} else { // timed matches accounting for scores
+							t->numTimesKilled++;
+						}
+						
+						t->percent = 0;
+						if (t->numLives == 0 || suddenDeath) {// no more lives left
+							t->dead = TRUE;
+						} else {
+						  	t->paralyzed = FALSE; // reset all player statuses
+							t->xspeed = 0;
+							t->yspeed = 0;
+							t->frac = 0;
+							t->rightCurrent = &t->frames[STAND_RIGHT];
+							t->leftCurrent = &t->frames[STAND_LEFT];
+							t->onStage = TRUE;
+							t->cloaked = FALSE;
+							t->metal = FALSE;
+							t->onHillL = FALSE;
+							t->onHillR = FALSE;
+							t->hanging = FALSE;
+							t->jumpValue = 0;
+							t->numJumps = 0;
+							
+							if (stageTemp->movingLevel) { // determine where to place the player to respawn
+								t->x = 72, t->y = 42;
+							} else {
+								t->x = ((respawn()).x) + 8 - ((characters[t->characterIndex].w) / 2) - x_fg;
+								t->y = ((respawn()).y) - (characters[t->characterIndex].h) - ((characters[t->characterIndex].h) & 1) + 16 - y_fg;
+							}
+						}
+					blastCounter = 0;
+					}
+				} else {
+					playerFuncs[t->type](t); // linked calculators both run every player, from the same inputs
+				}
+			} else {
+				t->invincible = TRUE; // currently (and temporarily) invincible
+		  	
+				if ((!t->type && playerKeys) || entryCounter > 30) {
+		  			t->onStage = FALSE;
+					t->invincible = FALSE;
+					t->jumpValue = 0;
+					entryCounter = 0;
+				}
+				entryCounter++;
+		  	}				  		  
+		}
+	}
+	playerKeys = 0;
+}
+
+BOOL checkForDeathEvent(PLAYER* me) { // check for out of bounds - not a DEATH space
+	if (stageTemp->movingLevel) { // if moving level and outside the screen boundary
+		if (me->x < -20 || me->x > 160 || me->y + characters[me->characterIndex].h < -16 || me->y > 116) {
+			return TRUE;
+		}
+		return FALSE;
+	}
+	
+	if (me->x + x_fg < -36 || me->x + x_fg + characters[me->characterIndex].w > (stageTemp->sw * 16) + 36 || me->y + y_fg < -40 || me->y + y_fg > (stageTemp->sh << 4)) {
+		return TRUE;
+	}
+	return FALSE;
+}
+
+// Move the tilemaps for this tick (auto-scrolling levels, following the camera, crowd pressure) and everything
+// that scrolls with them - the state half of rendering, so it also runs when nothing is drawn
+void scrollMaps(GAME_STATE* state) {
+	PLAYER* pTemp;
+	unsigned int slot;
+  
+  	if (stageTemp->movingLevel) {
+ 		switch (scrollType) {
+ 			case SCROLL_DOWN: // scroll downward
+ 			if (y_fg < 156) {
+				scrollD = TRUE;
+			} else {
+				scrollType++;
+				threshold = state->ticks;
+				scrollD = FALSE;
+			}
+ 			break;
+ 			
+ 			case REST_AT_BOTTOM: // stay at the bottom
+ 			if (state->ticks-threshold > MOVING_PAUSE) {
+				scrollType++;
+			}
+ 			break;
+ 			
+ 			case SCROLL_UP: // scroll upward
+ 			if (y_fg > 0) {
+				scrollU = TRUE;
+			} else {
+				scrollType++;
+				threshold = state->ticks;
+				scrollU = FALSE;
+			}
+ 			break;
+ 			
+ 			case REST_AT_TOP: // stay at the top 			
+ 			if (state->ticks - threshold > MOVING_PAUSE) {
+				scrollType = 0;
+			}
+			break;
+ 		}
+  	}
+	
+	if (scrollL) { // adjust the foreground by how fast the P1 is moving
+		x_fg -= myPlayer->moveSpeed;
+	}
+	if (scrollR)	{
+		x_fg += myPlayer->moveSpeed;
+	}
+	if (scrollU)	{
+		y_fg -= 2;
+	}
+	if (scrollD) {
+		y_fg += 2;
+	}
+	
+	if (x_fg < 0) {
+		x_fg = 0;
+	}
+	if (x_fg > (stageTemp->sw << 4) - 160) {
+		x_fg = (stageTemp->sw << 4) - 160;
+	}
+	if (y_fg < 0) {
+		y_fg = 0;
+	}
+	if (x_bg < 0) {
+		x_bg = 0;
+	}
+	if (y_bg < 0) {
+		y_bg = 0;
+	}
+	
+	if (head != NULL) {
+		BENCH_PHASE(BENCH_ITEMS);
+		moveAllItems(); // items scroll with the foreground and keep falling
+		BENCH_PHASE(BENCH_OTHER);
+	}
+
+  	if (gameCrowdPressure) { // keep shaking the background layer to give a notion of crowd pressure
+		if (!(state->ticks & 1)) {
+			x_bg -= 2;
+		} else {
+			x_bg += 2;
+		}
+		
+		if (!(state->ticks & 3)) {
+			y_bg -= 2;
+		} else if (!(state->ticks & 5)) {
+			y_bg += 2;
+		}
+	}
+	
+	for (slot = 0; slot < numPlayers; slot++) { // cloaking and metal wear off over time
+		pTemp = PLAYER_SLOT(slot);
+		if (!pTemp->dead) {
+			if (pTemp->cloaked) {
+				if (++cloakCounter > 80) {
+					pTemp->cloaked = FALSE;
+					cloakCounter = 0; // invisibility counter
+				}
+  			} else if (pTemp->metal) {
+				if (++metalCounter > 300) {
+	  				pTemp->size -= 5;
+					pTemp->metal = FALSE;
+					metalCounter = 0; // temporarily metal with higher "size"/defense stat
+				}
+			}
+		}
+	}
+	
+  	state->ticks++;
+	scrollL = FALSE; // ensure that the game doesn't continuously scroll after keypress done
+	scrollR = FALSE;
+	scrollU = FALSE;
+	scrollD = FALSE;
+	camera = FALSE;
+}
+
+// determine the winner of a timed match
+static unsigned int checkForWinnerTimed(void) {
+	PLAYER *temp = pHead;
+	PLAYER *greatest = NULL;
+	int best = -30, a;
+	
+	while (temp != NULL) {
+		a = temp->numKills - temp->numTimesKilled; // difference in kills vs deaths
+		if (a > best) {
+			greatest = temp;
+			best = a;
+		} else if (a == best) { // we have a sudden death situation
+			return NO_WINNER_FOUND;
+		}
+		temp = temp->next;
+	}
+	return (int)greatest->team;
+}
+
+// check for a winning player/team in stock/lives match
+static unsigned int checkForWinnerStock(void) {
+	PLAYER *temp = pHead;
+	PLAYER *checker;
+	
+	while (temp != NULL) {
+		if (!temp->dead) {
+			break;
+		}
+		temp = temp->next;
+	} // find the first not dead player in the list
+	
+	if (temp->next == NULL) {
+		return (int)temp->team;
+	}
+	
+	checker = temp->next;
+	while (checker != NULL) {
+		if (!checker->dead && temp->team != checker->team) {
+			return NO_WINNER_FOUND;
+		}
+		checker = checker->next;
+	}
+	return (int)temp->team; // did not return early so a team won!	
+}
+
+// check for winning player/team in sudden death situation
+static unsigned int checkForSuddenDeathWin(void) {
+	PLAYER *temp = pHead;
+	PLAYER *winner = NULL;
+	
+	while (temp != NULL) {
+		if (!temp->dead) {
+			if (winner == NULL) {
+				winner = temp;
+			} else {
+				return NO_WINNER_FOUND;
+			}
+		}
+		temp = temp->next;
+	}
+	
+	return (int)winner->team;
+}
+
+// determine current player speed for handling horizontal scrolling/player flying up when hit
+static int getXSpeed(PLAYER* p) {
+	p->xspeed = 0;
+	
+	if (abs(p->x - p->enemy->x) < 8) {
+		p->xspeed = 2; // assuming player is attacked
+	} else if (abs(p->x - p->enemy->x) < 33) {
+		p->xspeed = 4;
+	}
+	
+	if (p->xspeed > 0 && p->x < p->enemy->x) {
+		p->xspeed = -p->xspeed;
+	}
+	
+	return p->xspeed;
+}
+
+// get the incremental damage to a player just hit by an attack; based on attack and hit points
+static int getDamageToHitPlayer(PLAYER* p) {
+	if (p->enemy == NULL) {
+		return 0;
+	}
+	return (p->enemy->power - p->size + randomFrom(RNG_COMBAT, 7) + randomFrom(RNG_COMBAT, 6) + ((p->percent) / 128) * 13);
+}
+
+// set the initial status for each player before going into a game
+void setupPlayerInGame(PLAYER* player) {
+	player->frames = residentFrames(player->characterIndex); // animation frames are only resolved for characters in play
+	
+	player->power = 10,
+	player->size = 2,
+	
+	player->percent = 0,
+	player->numJumps = 0,
+	player->playerCounter = 0, 
+	player->attackMarker = 0,
+	player->shots = 0,
+	
+	player->breathing = FALSE, 
+	player->running = FALSE, 
+	player->taunting = FALSE,
+	player->falling = FALSE,
+	player->climbing = FALSE,
+	player->crouching = FALSE,
+	player->hanging = FALSE,
+	player->smashAttacking = FALSE, 
+	player->specialAttacking = FALSE, 
+	player->skyAttacking = FALSE,
+	player->beingHeld = FALSE, 
+	player->grabbing = FALSE,
+	player->invincible = FALSE,
+	player->dead = FALSE,
+	player->paralyzed = FALSE,
+	player->onStage = TRUE,
+	player->onHillL = FALSE, 
+	player->onHillR = FALSE,
+	player->canFire = TRUE,
+	player->cloaked = FALSE, 
+	player->metal = FALSE, // need to set this for classic mode
+	player->direction = RIGHT;
+}
+
+// Returns a character's frames, resolving them into a cache slot if it is not resident yet. The slot taken is one no
+// player in the match is using (the slots past numPlayers hold whoever was there last match), and since k is normally
+// one of theirs, there always is one.
+FRAME* residentFrames(unsigned int k) {
+	unsigned int slot, c, i;
+	
+	for (slot = 0; slot < MAX_PLAYERS; slot++) {
+		if (cachedCharacter[slot] == k) {
+			return frameCache[slot];
+		}
+	}
+	
+	for (slot = 0; slot < MAX_PLAYERS - 1; slot++) { // last slot if nothing else is free
+		c = cachedCharacter[slot];
+		for (i = 0; i < numPlayers && PLAYER_SLOT(i)->characterIndex != c; i++);
+		if (i == numPlayers) {
+			break;
+		}
+	}
+	
+	cachedCharacter[slot] = k;
+	resolveFrames(frameCache[slot], k);
+	return frameCache[slot];
+}
+
+static void resolveFrames(FRAME* frames, unsigned int k) { // set up the animation progressions of frames for a character
+	unsigned int p;
+	
+	for (p = 0; p < NUM_FRAMES; p++) { // all animation frames for the character
+		frames[p].data = frameData(k, p);
+	}
+	
+	// facing right frames - set up the linked list of animation frames
+	frames[STAND_RIGHT].next = &frames[RUN1_RIGHT];
+	frames[BREATHE_RIGHT].next = &frames[RUN1_RIGHT];
+	frames[RUN1_RIGHT].next = &frames[RUN2_RIGHT];
+	frames[RUN2_RIGHT].next = &frames[STAND_RIGHT];
+	
+	frames[SMASH_RIGHT].next = &frames[STAND_RIGHT];
+	frames[SKY_RIGHT].next = &frames[STAND_RIGHT];
+	frames[SPECIAL_RIGHT].next = &frames[STAND_RIGHT];		
+	frames[JUMPUP_RIGHT].next = &frames[STAND_RIGHT];
+	frames[HURT_RIGHT].next = &frames[STAND_LEFT];
+	
+	frames[CLIMB_RIGHT].next = &frames[STAND_RIGHT];
+	
+	// facing left
+	frames[STAND_LEFT].next = &frames[RUN1_LEFT];
+	frames[BREATHE_LEFT].next = &frames[RUN1_LEFT];
+	frames[RUN1_LEFT].next = &frames[RUN2_LEFT];
+	frames[RUN2_LEFT].next = &frames[STAND_LEFT];
+	
+	frames[SMASH_LEFT].next = &frames[STAND_LEFT];
+	frames[SKY_LEFT].next = &frames[STAND_LEFT];
+	frames[SPECIAL_LEFT].next = &frames[STAND_LEFT];		
+	frames[JUMPUP_LEFT].next = &frames[STAND_LEFT];
+	frames[HURT_LEFT].next = &frames[STAND_RIGHT];
+	
+	frames[CLIMB_LEFT].next = &frames[STAND_LEFT];
+	
+	// crouching and taunting (not facing any specific direction)
+	frames[CROUCH].next = &frames[STAND_RIGHT];
+	frames[TAUNT1].next = &frames[TAUNT2];
+	frames[TAUNT2].next = &frames[STAND_RIGHT];
+}
+
+// The settings and fighters of the match about to be played (also the setup a link host sends)
+void captureSettings(REPLAY_HEADER* h) {
+	h->stageIndex = stageIndex;
+	h->numPlayers = numPlayers;
+	h->characters[0] = p1->characterIndex, h->teams[0] = p1->team;
+	h->characters[1] = p2->characterIndex, h->teams[1] = p2->team;
+	h->characters[2] = p3->characterIndex, h->teams[2] = p3->team;
+	h->characters[3] = p4->characterIndex, h->teams[3] = p4->team;
+	h->difficulty = currentProfile.difficulty;
+	h->matchType = currentProfile.matchType;
+	h->matchMinutes = currentProfile.matchMinutes;
+	h->matchLives = currentProfile.matchLives;
+	h->crowdPressure = currentProfile.crowdPressure;
+	h->itemProb = currentProfile.itemProb;
+}
+
+void applySettings(const REPLAY_HEADER* h) {
+	stageIndex = h->stageIndex;
+	numPlayers = h->numPlayers;
+	numHands = 0;
+	p1->characterIndex = h->characters[0], p1->team = h->teams[0];
+	p2->characterIndex = h->characters[1], p2->team = h->teams[1];
+	p3->characterIndex = h->characters[2], p3->team = h->teams[2];
+	p4->characterIndex = h->characters[3], p4->team = h->teams[3];
+	currentProfile.difficulty = h->difficulty;
+	currentProfile.matchType = h->matchType;
+	currentProfile.matchMinutes = h->matchMinutes;
+	currentProfile.matchLives = h->matchLives;
+	currentProfile.crowdPressure = h->crowdPressure;
+	currentProfile.itemProb = h->itemProb;
+}
+
+// End of Source File
@@ -25,6 +25,7 @@ extern void* virtual; // game virtual screens - tilemap and tournament bracket (
 #define STAGE_NOT_INSTALLED  "tl_stage not installed"
 #define CHARS_NOT_INSTALLED  "tl_charx files not installed"
 #define EXTRA_NOT_INSTALLED  "tl_extra not installed"
+#define DATA_OUT_OF_DATE     "TL data files out of date"
 
 // External data file names and extensions
 #define STAGE_FILENAME       "tl_stage"
@@ -33,6 +34,8 @@ extern void* virtual; // game virtual screens - tilemap and tournament bracket (
 #define CHAR3_FILENAME       "tl_char3"
 #define EXTRA_FILENAME       "tl_extra"
 #define PROFILE_FOLDERNAME   "profiles"
+#define QUICKSAVE_FOLDERNAME "tlquick"
+#define REPLAY_FILENAME      "tlreplay"
 #define PROFILE_EXTENSION    "user"
 
 #define SENTINEL_VALUE   0x91 // splashscreen compression marker value
@@ -61,11 +64,14 @@ extern HAND* masterHand;
 extern HAND* crazyHand; // structures for bosses
 
 extern TIMER* timer;
+extern PROJECTILE* projectiles; // MAX_PROJECTILES of them, right after the timer
 
 #define CON_CLASSIC       20
 #define CON_TITANIUM      15 // optimal contrast levels for device
 #define MAX_PLAYERS        4
-#define MAX_PROJECTILES    4
+#define SHOTS_PER_PLAYER   2
+#define MAX_PROJECTILES   (MAX_PLAYERS * SHOTS_PER_PLAYER) // one pool for everyone's shots and explosions
+#define MAX_HITS          (MAX_PLAYERS * (MAX_PLAYERS - 1) / 2) // at most one per pair of fighters a tick
 
 // 2001 * 4 = 8004 (four total planes to write to: onscreen and background grayscale buffers)
 #define MCARD (LCD_SIZE + LCD_SIZE + sizeof(PLAYER) * MAX_PLAYERS + sizeof(TIMER) + sizeof(PROJECTILE) * MAX_PROJECTILES + 2 * sizeof(HAND) + 8004)
@@ -79,6 +85,7 @@ extern TIMER* timer;
 #define NUM_ITEMS            26
 #define ITEM_PROBABILITY      2 // increase this to decrease chance of items in level
 #define ITEM_OFFSET           5 // used to help add small items
+#define MAX_ITEMS            16 // size of the item pool - once this many are out on the stage, new drops are skipped until one is used
 
 #define ATTACK_ANIM_DELAY     8
 
@@ -103,6 +110,44 @@ extern TIMER* timer;
 
 #define RETURN_TO_MAIN       80
 
+// Tournament bracket tilemap, built from the bracket tree into tournamentBlock just past the plane's virtual screen
+#define BRACKET_MAP_WIDTH   (BRACKET_ROUNDS * 3 + 1)
+#define BRACKET_MAP_HEIGHT  (BRACKET_ENTRANTS * 2 + 3) // with enough below the last entrant to scroll down to it
+#define BRACKET_MAP         (tournamentBlock + GRAY_BIG_VSCREEN_SIZE)
+#define BRACKET_TILE_BACK         25 // tournamentTiles after the 24 characters and a blank one
+#define BRACKET_TILE_TOP          26 // line along the top edge
+#define BRACKET_TILE_BOTTOM       27 // ...the bottom edge
+#define BRACKET_TILE_RIGHT_TOP    28
+#define BRACKET_TILE_RIGHT_BOTTOM 29
+#define BRACKET_TILE_RIGHT        30
+
+// In-game key bits for one player during one tick (see INPUT_FRAME)
+#define INPUT_LEFT        0x001
+#define INPUT_RIGHT       0x002
+#define INPUT_UP          0x004
+#define INPUT_DOWN        0x008
+#define INPUT_JUMP        0x010 // [SHIFT]
+#define INPUT_ATTACK      0x020 // [2ND]
+#define INPUT_SPECIAL     0x040 // [DIAMOND]
+#define INPUT_DODGE       0x080 // [ALPHA]
+#define INPUT_GRAB        0x100 // [F1]
+#define INPUT_ANY         0x200 // set whenever any key is down (drops a player off the entry platform)
+
+// Benchmark builds (BENCHMARK defined) charge each timer sample to the part of the tick that is running
+#define BENCH_OTHER           0
+#define BENCH_PLAYERS         1 // controlPlayers: movement, attacks and AI
+#define BENCH_COLLISIONS      2
+#define BENCH_HANDS           3
+#define BENCH_ITEMS           4
+#define BENCH_NUM_PHASES      5
+
+#ifdef BENCHMARK
+extern volatile unsigned int benchPhase;
+#define BENCH_PHASE(__p) (benchPhase = (__p))
+#else
+#define BENCH_PHASE(__p)
+#endif
+
 // Used to establish the connection only
 #define HOST_ID				 22 // a.k.a. "master" calc
 #define JOIN_ID              24 // a.k.a. "slave" calc
@@ -133,6 +178,7 @@ extern BOOL cont;
 extern BOOL episodeSuccess;
 extern BOOL goAheadAndSave;
 extern BOOL linked;
+extern BOOL headless; // simulate without drawing or the timer interrupt (the clock and items are stepped by sim_step)
 
 // Tilemap coordinates (where to render)
 extern int x_fg;
@@ -146,9 +192,11 @@ extern unsigned int collapse;
 extern unsigned int scrollType; // could move last one into GameEngine as static, but might be used for AI
 extern unsigned int stageIndex;
 extern unsigned int numPlayers;
+#define PLAYER_SLOT(__i) (p1 + (__i)) // players occupy consecutive slots in mainBlock, and pHead always lists p1 up to numPlayers in slot order
 extern unsigned int numHands;
 extern unsigned int battleCounter; // used for classic
 extern unsigned int winningTeam;
+extern unsigned int backIndex; // background the stage is drawn over (1 has the crowd in it)
 extern GAME_MODE mode;
 
 extern unsigned char calc; // which calculator in the link process (master or slave)
@@ -160,8 +208,15 @@ extern MATCHTYPE gameMatchType; // stock/lives or timed
 extern unsigned int gameMatchLives;
 extern unsigned int gameItemProb;
 
+extern unsigned int playerKeys; // INPUT_* bits of the player currently being handled (zero for CPU players)
+
+extern GAME_STATE game; // the match currently being played (tick count, item cadence, episode counters)
+
 extern unsigned long points[8]; // the points array for completing a classic mode level
 
+extern unsigned long rngStreams[NUM_RNG_STREAMS]; // xorshift state of each random number generator
+extern unsigned long matchSeed; // seed the match in play was started from (see seedMatch)
+
 // References to external data files: tl_stage,tl_chars1,tl_chars2,tl_chars3,tl_extra
 extern EXTERNAL* dataptr;
 extern unsigned long* c1;
@@ -184,13 +239,40 @@ extern STAGE rtfstages[2]; // race to the finish stages
 
 extern unsigned char* profileNames[5];
 
+// Packed collision flags - one byte per tile of the stage being played (see buildCollisionGrid)
+#define GRID_EMPTY         0x00
+#define GRID_SOLID         0x01
+#define GRID_CLOUD         0x02
+#define GRID_SLOPELEFT     0x04
+#define GRID_SLOPERIGHT    0x08
+#define GRID_LADDER        0x10
+#define GRID_HOT           0x20
+#define GRID_WATER         0x40
+#define GRID_SPECIAL       0x80 // door, collapsing or partial tile: look up the full tileInfo word for the details
+
+// Collision grid rows are a power of two apart so lookups only shift
+#define GRID_SHIFT            5
+#define GRID_W               32 // widest layout is 20 tiles (race to the finish)
+#define GRID_H               20
+extern unsigned char collisionGrid[GRID_H << GRID_SHIFT];
+
 
 // Utility macros
 
+#define FIX(__n) ((__n) * 256) // whole pixels to 8.8 fixed point (knockback speeds - see Physics.c)
+
 // optimization for array accessing p[i] - used for stage arrays (smaller size instructions than normal faster dereference operator)
 #define DEREF_SMALL(__p,__i) \
  (*(typeof(&*(__p)))((unsigned char*)(__p) + (long)(short)((short)(__i) * sizeof(*(__p)))))
 
+// collision flags of the tile under stage pixel (px, py); negative or past-the-grid coordinates are open air
+static inline unsigned char __attribute__ ((pure)) tileFlags(int px, int py) {
+	if ((unsigned int)px >= (GRID_W << 4) || (unsigned int)py >= (GRID_H << 4)) {
+		return GRID_EMPTY;
+	}
+	return collisionGrid[(((unsigned int)py >> 4) << GRID_SHIFT) + ((unsigned int)px >> 4)];
+}
+
 
 // Function prototypes
 
@@ -200,6 +282,12 @@ void WaitForMillis(unsigned short);
 unsigned char* ActiveContrastAddr(void);
 void setContrast(unsigned int con);
 void unarchiveFile(const char* file);
+void loadCurrentProfile(const char* name);
+const void* readProfileFile(const char* folder, unsigned int* length);
+BOOL writeProfileFile(const char* folder, const void* data, unsigned int length);
+void deleteProfileFile(const char* folder);
+unsigned long* frameData(unsigned int characterIndex, unsigned int frame); // where a sprite frame sits in the tl_charx files
+unsigned long* characterPortrait(unsigned int characterIndex); // taunt sprite for menus - needs no residency
 atexit_t exitGame(void);
 
 // Menus.c:
@@ -208,18 +296,41 @@ void mainMenu(void);
 void VSScreen(void);
 void RLE_Decompress(unsigned char* src, unsigned char* dest, short size);
 void doProfileLoadingOrCreating(void);
+void defaultProfile(void);
 
 // MainGame.c:
 void doGame(void);
+void doReplay(void);
+void doQuickGame(void);
 void doEpisode(unsigned int episodeIndex);
 void setupLoadedGame(void);
 void raceToTheFinish(unsigned int index);
+void damageCells(int x, int y, int w, int h); // anything drawn over the stage during a match must report where
+
+// Sim.c:
+void setupMatch(void);
+void setupEpisode(unsigned int episodeIndex);
+void setupPlayerInGame(PLAYER* player);
+FRAME* residentFrames(unsigned int characterIndex); // resolves a character's animation frames into the match cache
+SIM_RESULT sim_step(GAME_STATE* state, const INPUT_FRAME* input); // advance the match exactly one tick, no drawing or I/O
+void runClock(GAME_STATE* state, unsigned int beats);
+void scrollMaps(GAME_STATE* state);
+BOOL checkForDeathEvent(PLAYER* me);
+unsigned int matchState(void* snapshot, STATE_TRANSFER how); // everything sim_step changes, for rollbacks
+unsigned int quicksaveState(char* blob, STATE_TRANSFER how);
+void captureSettings(REPLAY_HEADER* h);
+void applySettings(const REPLAY_HEADER* h);
 
 // Players.c:
 void handlePlayer(PLAYER* player); // used to handle the actual user based on key inputs and interaction w/ environment
 inline unsigned int getTile(int txx, int tyy) __attribute__ ((pure));
+void buildCollisionGrid(void);
+void resetControls(void);
+void scheduleAI(void); // share out the AI's expensive decisions for the coming tick
 inline BOOL playersCollided(PLAYER* playerA, PLAYER* playerB);
 void executeNewAI(PLAYER* cpu);
+char* playerState(char* at, STATE_TRANSFER how);
+char* playerQuicksave(char* at, STATE_TRANSFER how);
 
 // pointers to functions that handle each player, based on type (human or AI)
 void (*playerFuncs[2])(PLAYER* p) = {
@@ -229,21 +340,22 @@ void (*playerFuncs[2])(PLAYER* p) = {
 
 // Projectile methods
 PROJECTILE* setupProj(PLAYER* player);
-BOOL moveProjectile(PROJECTILE* projectile, DIRECTION direction);
+PROJECTILE* explodeOn(PLAYER* player);
 void explode(PROJECTILE* projectile);
 
 // Items.c:
 // Item handling methods for linked lists
 inline void addItem(unsigned int index);
-void drawAllItems(void *dest);
+void moveAllItems(void);
 void freeItemList(ITEM** head);
 ITEM* myItem(PLAYER* p);
-BOOL existsItemInRegion(PLAYER* p);
 PLAYER *throw(PLAYER* p);
 PLAYER *smashBoost(PLAYER* p);
 PLAYER *metalInit(PLAYER* p);
 PLAYER *cloaking(PLAYER* p);
 PLAYER *makeInvincible(PLAYER* p);
+char* itemState(char* at, STATE_TRANSFER how);
+char* itemQuicksave(char* at, STATE_TRANSFER how);
 
 // functions for different items (what type of functionality they have)
 PLAYER* (*itemFuncs[5])(PLAYER* p) = {
@@ -257,8 +369,47 @@ PLAYER* (*itemFuncs[5])(PLAYER* p) = {
 // Extras.c:
 // horizontally center text
 inline unsigned int HCENTER(const char* const str, int width) __attribute__ ((pure));
-
-// Link.c: TBD
+unsigned int randomFrom(RNG_STREAM stream, unsigned int n); // 0 to n-1
+unsigned long newSeed(void);
+void seedStream(RNG_STREAM stream, unsigned long seed);
+void seedMatch(unsigned long seed);
+char* transferState(char* at, void* var, unsigned int size, STATE_TRANSFER how);
+char* packWord(char* at, void* var, BOOL isSigned, STATE_TRANSFER how);
+
+// Replay.c:
+void startRecording(void);
+void recordInput(const INPUT_FRAME* input);
+void stopRecording(void);
+BOOL startPlayback(void);
+BOOL replayInput(INPUT_FRAME* input);
+BOOL playingBack(void);
+void stopPlayback(void);
+
+// Benchmark.c:
+void runBenchmark(void);
+
+// Batch.c:
+void runBatch(void);
+void batchSetup(void);
+unsigned long batchMatchups(void);
+void batchMatchup(unsigned long line, unsigned int* a, unsigned int* b);
+void batchStages(BATCH_TALLY* tally, unsigned int a, unsigned int b, unsigned int first, unsigned int stages, unsigned int runs);
+void batchMatch(BATCH_TALLY* tally, unsigned int a, unsigned int b, unsigned int stage, unsigned int run);
+void batchLine(char* line, unsigned int a, unsigned int b, const BATCH_TALLY* tally);
+
+// Physics.c:
+void launchPlayer(PLAYER* p, int xspeed); // knocks a player into the air (xspeed in whole pixels a tick)
+void flyPlayers(void);
+BOOL dropItem(ITEM* item);
+void sortAndSweep(void);
+BOOL mayTouch(PLAYER* a, PLAYER* b);
+void moveProjectiles(void);
+
+// Link.c:
+char establishConnection(void);
+BOOL startLink(GAME_STATE* state);
+BOOL linkStep(GAME_STATE* state, const INPUT_FRAME* input);
+void stopLink(void);
 
 // End of Header File
 
@@ -11,7 +11,10 @@
 #ifndef HEADERS_H
 #define HEADERS_H
 
+#include "platform.h"
+#ifndef HOST_BUILD
 #include "extgraph.h"
+#endif
 #include "gamedata.h"
 #include "playerdata.h"
 #include "huddata.h"
@@ -0,0 +1,102 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - batchrun.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Batch.c's AI-vs-AI balance sweep on a PC: the same matchups in the same order (batchMatchup), runs matches each
+// (switching sides every run), one CSV line per matchup in the same columns as tlbatch:
+//     batchrun [runs] [workers]
+// Only a sample of the calculator's sweep, though: the real stages' layouts are in the calculator's data files, so
+// every match is played on the one stage hostsim.c lays out instead of on all of them.
+// The matchups are shared out to workers processes (one per core by default) as they free up: each takes the next
+// one off a queue in memory they all share, so a worker stuck with long matches does not hold the others up. The
+// lines come out in sweep order and every match is seeded from its own place in the sweep, so any number of
+// workers prints the same CSV.
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "hostsim.h"
+
+#undef int // (main and the workers get the PC's int)
+
+#define BATCH_MAX_RUNS 256 // batchMatch seeds from the run's number below the matchup's
+
+typedef struct batchqueue {
+	unsigned long next; // the next matchup nobody has taken yet
+	BATCH_TALLY tallies[1]; // by matchup, as many as the sweep has
+} BATCH_QUEUE;
+
+// Takes matchups off the queue and plays them until there are none left
+static void work(BATCH_QUEUE* queue, unsigned long total, unsigned int runs) {
+	BATCH_TALLY tally;
+	unsigned long i;
+	unsigned short a, b; // (the sweep's int)
+
+	batchSetup();
+	while ((i = __sync_fetch_and_add(&queue->next, 1)) < total) {
+		batchMatchup(i, &a, &b);
+		memset(&tally, 0, sizeof(BATCH_TALLY));
+		batchStages(&tally, a, b, HOST_STAGE, 1, runs);
+		queue->tallies[i] = tally;
+	}
+}
+
+int main(int argc, char** argv) {
+	unsigned long runs = (argc > 1) ? strtoul(argv[1], NULL, 10) : 4, total, i;
+	long workers = (argc > 2) ? atol(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN), w;
+	unsigned short a, b; // (the sweep's int)
+	BATCH_QUEUE* queue;
+	char line[64];
+	int status, failed = 0;
+
+	if (runs < 1 || runs > BATCH_MAX_RUNS) {
+		runs = (runs < 1) ? 1 : BATCH_MAX_RUNS;
+	}
+	if (workers < 1) {
+		workers = 1;
+	}
+
+	total = batchMatchups();
+	queue = mmap(NULL, sizeof(BATCH_QUEUE) + total * sizeof(BATCH_TALLY), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+		-1, 0);
+	if (queue == MAP_FAILED) {
+		return 2;
+	}
+	queue->next = 0;
+
+	hostInit();
+	for (w = 0; w < workers; w++) {
+		pid_t pid = fork();
+
+		if (pid < 0) {
+			return 2;
+		}
+		if (!pid) {
+			work(queue, total, runs);
+			exit(0);
+		}
+	}
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+			failed = 1;
+		}
+	}
+	if (failed) {
+		return 2;
+	}
+
+	printf("char a,char b,difficulty,type,matches,a wins %%,b wins %%,draws,avg ticks,a KOs,b KOs\n");
+	for (i = 0; i < total; i++) {
+		batchMatchup(i, &a, &b);
+		batchLine(line, a, b, &queue->tallies[i]);
+		fputs(line, stdout);
+	}
+	return 0;
+}
+
+// End of Source File
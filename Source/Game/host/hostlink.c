@@ -0,0 +1,68 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - hostlink.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Stands in for the link cable on a PC: blocks go out on one file descriptor and come in on another (a pipe to the
+// other calculator's process), and one block in every hostLinkDrop is lost on the way, as a block that fails to go
+// over the cable would be. Reading also stands in for the clock: the timer interrupt never fires here, so every
+// HOST_READS_PER_BEAT reads that find nothing count a clock beat, which is what Link.c resends and gives up by.
+
+#include <unistd.h>
+#include <fcntl.h>
+#include "hostsim.h"
+
+#define HOST_READS_PER_BEAT 50 // with a millisecond's sleep each, about the calculator's 20 beats a second
+
+static int linkIn = -1, linkOut = -1;
+static unsigned int hostLinkDrop; // 0 = nothing is lost
+static unsigned long dropState; // the cable's own random numbers, so losing blocks leaves the match's alone
+static unsigned int idleReads;
+
+// Puts a cable that loses nothing between in and out; which blocks it loses later is picked from seed
+void hostLinkOpen(int in, int out, unsigned long seed) {
+	linkIn = in;
+	linkOut = out;
+	fcntl(linkIn, F_SETFL, fcntl(linkIn, F_GETFL) | O_NONBLOCK);
+	hostLinkDrop = 0;
+	dropState = seed | 1;
+	idleReads = 0;
+}
+
+// From now on loses one block in drop (0 for none)
+void hostLinkLose(unsigned int drop) {
+	hostLinkDrop = drop;
+}
+
+void OSLinkReset(void) {
+}
+
+// The whole block goes, or (one time in hostLinkDrop) none of it
+short OSWriteLinkBlock(const char* buffer, unsigned short num) {
+	dropState ^= dropState << 13, dropState &= 0xFFFFFFFFUL;
+	dropState ^= dropState >> 17;
+	dropState ^= dropState << 5, dropState &= 0xFFFFFFFFUL;
+	if (hostLinkDrop && !(dropState % hostLinkDrop)) {
+		return 0; // lost without a trace
+	}
+	return (write(linkOut, buffer, num) == num) ? 0 : 1;
+}
+
+unsigned short OSReadLinkBlock(char* buffer, unsigned short num) {
+	ssize_t got = read(linkIn, buffer, num);
+
+	if (got > 0) {
+		return got;
+	}
+	usleep(1000);
+	if (++idleReads == HOST_READS_PER_BEAT) {
+		idleReads = 0;
+		game.beatCounter++;
+	}
+	return 0;
+}
+
+// End of Source File
@@ -0,0 +1,129 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - hostsim.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Stands in for Main.c on a PC: no data files are read, so there are no sprites (frames point nowhere, which the
+// simulation never looks at) and the one stage is laid out here - a floor just under where the fighters come in,
+// two cloud platforms below it and open air under those, so fighters can be knocked off and lose lives.
+
+#include "hostsim.h"
+
+static char hostMatrix[9][14] = {
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+	{0,0,1,1,1,1,1,1,1,1,1,1,0,0},
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+	{0,0,0,2,2,2,0,0,2,2,2,0,0,0},
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+	{0,0,0,0,0,0,0,0,0,0,0,0,0,0}
+};
+static unsigned long hostTileInfo[3] = { 0, SOLID, SOLID | CLOUD };
+
+static char* hostBlock;
+
+// The calculator's sprites are in its tl_charx files; on a PC there are none
+unsigned long* frameData(unsigned int characterIndex, unsigned int frame) {
+	return NULL;
+}
+
+// Lays the match block out as Main.c does (the players, timer, shots and hands have to be one run of memory - see
+// matchState) and puts the stage in place
+void hostInit(void) {
+	unsigned int k;
+	
+	hostBlock = calloc(1, 4 * sizeof(PLAYER) + sizeof(TIMER) + MAX_PROJECTILES * sizeof(PROJECTILE) + 2 * sizeof(HAND));
+	characters = calloc(NUM_CHARS, sizeof(CHARACTER));
+	dataptr = calloc(1, sizeof(EXTERNAL));
+	extraptr = calloc(1, sizeof(EXTRA_EXTERNAL));
+	if (hostBlock == NULL || characters == NULL || dataptr == NULL || extraptr == NULL) {
+		exit(1);
+	}
+	
+	p1 = (PLAYER*)hostBlock;
+	p2 = p1 + 1;
+	p3 = p2 + 1;
+	p4 = p3 + 1;
+	timer = (TIMER*)(p4 + 1);
+	projectiles = (PROJECTILE*)(timer + 1);
+	masterHand = (HAND*)(projectiles + MAX_PROJECTILES);
+	crazyHand = masterHand + 1;
+	
+	for (k = 0; k < NUM_CHARS; k++) {
+		characters[k].w = characterWidths[k];
+		characters[k].h = characterHeights[k];
+		characters[k].specialType = charSpecialAttacks[k];
+	}
+	
+	stages[HOST_STAGE].fgPlane.matrix = hostMatrix;
+	stages[HOST_STAGE].tileInfo = hostTileInfo;
+	
+	seedStream(RNG_MENUS, 1);
+}
+
+// The settings of a one-on-one Arena match between characters a and b, on the host stage
+void hostSettings(unsigned int a, unsigned int b, MATCHTYPE type) {
+	mode = ARENA_MODE;
+	numPlayers = 2;
+	numHands = 0;
+	stageIndex = HOST_STAGE;
+	p1->characterIndex = a, p1->team = WHITE_TEAM;
+	p2->characterIndex = b, p2->team = BLACK_TEAM;
+	
+	currentProfile.difficulty = ELITE;
+	currentProfile.matchType = type;
+	currentProfile.matchMinutes = 2;
+	currentProfile.matchLives = 3;
+	currentProfile.crowdPressure = OFF;
+	currentProfile.itemProb = 3;
+}
+
+// A one-on-one Arena match from seed between CPUs playing characters a and b, on the host stage
+void hostMatch(unsigned long seed, unsigned int a, unsigned int b, MATCHTYPE type) {
+	hostSettings(a, b, type);
+	freeItemList(&head);
+	seedMatch(seed);
+	setupMatch();
+	p1->type = CPU;
+	myPlayer = p1;
+	memset(&game, 0, sizeof(GAME_STATE));
+}
+
+// The keys a human player holds on a tick, made up from seed: a fresh combination every 16 ticks, let go of after 4
+// to 19 of them (side tells the two players apart)
+unsigned int hostKeys(unsigned long seed, unsigned int side, unsigned int tick) {
+	unsigned long h = (seed * 2654435761UL + side * 40503UL + (tick >> 4) * 2246822519UL) & 0xFFFFFFFFUL;
+	unsigned int keys;
+	
+	h = ((h ^ (h >> 15)) * 2246822519UL) & 0xFFFFFFFFUL;
+	h ^= h >> 13;
+	keys = h & (INPUT_LEFT | INPUT_RIGHT | INPUT_UP | INPUT_DOWN | INPUT_JUMP | INPUT_ATTACK | INPUT_SPECIAL | INPUT_GRAB);
+	if ((tick & 15) < 4 + ((h >> 12) & 15) && keys) {
+		return keys | INPUT_ANY;
+	}
+	return 0;
+}
+
+// FNV-1a over the match as a quicksave would hold it (see quicksaveState - a snapshot has pointers in it, which
+// differ from run to run): equal hashes, equal matches
+unsigned long stateHash(void) {
+	static char* snapshot;
+	unsigned long hash = 2166136261UL;
+	unsigned int size = quicksaveState(NULL, STATE_SIZE), i;
+	
+	if ((snapshot = realloc(snapshot, size)) == NULL) {
+		exit(1);
+	}
+	quicksaveState(snapshot, STATE_SAVE);
+	for (i = 0; i < size; i++) {
+		hash = ((hash ^ (unsigned char)snapshot[i]) * 16777619UL) & 0xFFFFFFFFUL;
+	}
+	return hash;
+}
+
+// End of Source File
@@ -0,0 +1,30 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// Header File - hostsim.h
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// What the PC programs in host/ share: the match block and a stage of their own in place of the calculator's data
+// files, a CPU match set up on them, and a hash of everything the match has changed
+
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include "../platform.h"
+#include "../headers.h"
+
+#define HOST_STAGE 11 // Fourside's slot, which hostsim.c lays out: 9 tiles down, 14 across
+
+void hostInit(void);
+void hostSettings(unsigned int a, unsigned int b, MATCHTYPE type);
+void hostMatch(unsigned long seed, unsigned int a, unsigned int b, MATCHTYPE type);
+unsigned int hostKeys(unsigned long seed, unsigned int side, unsigned int tick);
+unsigned long stateHash(void);
+void hostLinkOpen(int in, int out, unsigned long seed);
+void hostLinkLose(unsigned int drop);
+
+// End of Header File
+
+#endif
@@ -0,0 +1,197 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - linkpipe.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Plays a linked match on a PC between two copies of the game - two processes, each with its own Link.c, joined by
+// a pair of pipes that lose one packet in drop once the match is under way (see hostlink.c; the settings sent before
+// it are not resent, so losing them would leave both sides waiting for ESC) - and checks it against the same match
+// played in lockstep, with both players' keys on every tick and no link at all:
+//     linkpipe [drop] [seed] [character a] [character b]
+// Both fighters are human, with keys made up from the seed, in a one minute timed match. Each run prints the tick
+// and result it ended on, every fighter's lives, damage and kills, where every fighter is in stage coordinates, and
+// the hash of its whole match. The host has to end exactly as lockstep did, whatever the drop rate - rolling back
+// has to make a lossy cable play out just as a perfect one - and the joining side has to end the same match.
+//
+// The joining side's screen follows p2, as it does on a calculator, and the engine moves the stage around whoever
+// the screen follows, so its fighters only agree with the host's when a sample comes in and drift a little between
+// samples: it is held to the same end tick, result and winner, not the same fighters or hash. Build with SAME_CAMERA
+// defined to have it follow p1 as the host does, and then it has to end exactly as the host did.
+// Exits 1 if a run ended differently, 2 if a side lost the link.
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "hostsim.h"
+
+#undef int // (main and the pipes get the PC's int)
+
+#define SIDE_TICKS  4000 // a side that has not finished by then has lost track of the match
+#define REPORT_SIZE 256
+#define LOCKSTEP    2    // the report from the run with no link
+
+// Reports the match that just ended as a line: name and result | fighters | positions | hash
+static void reportMatch(const char* name, int ok, char* report) {
+	PLAYER* p;
+	int length;
+
+	length = sprintf(report, "%s ticks %u result %d winner %d |", name, (unsigned)game.ticks, (int)game.result,
+		(int)game.winner);
+	for (p = pHead; p != NULL; p = p->next) {
+		length += sprintf(report + length, " lives %d damage %u kills %d;", (int)p->numLives, (unsigned)p->percent,
+			(int)p->numKills);
+	}
+	length += sprintf(report + length, " | at");
+	for (p = pHead; p != NULL; p = p->next) {
+		length += sprintf(report + length, " %d,%d", (int)(p->x + x_fg), (int)(p->y + y_fg));
+	}
+	sprintf(report + length, " | hash %08lx%s\n", stateHash(), ok ? "" : " (link lost)");
+}
+
+// Sets up a one minute timed match between two humans
+static void startMatch(unsigned int a, unsigned int b) {
+	hostInit();
+	hostSettings(a, b, TIMED);
+	currentProfile.matchMinutes = 1;
+	linked = TRUE;
+	freeItemList(&head);
+	memset(&game, 0, sizeof(GAME_STATE));
+}
+
+// The match with no link, both players' keys going into every tick, reported into report
+static void playLockstep(unsigned long seed, unsigned int a, unsigned int b, char* report) {
+	INPUT_FRAME input;
+	unsigned int t;
+
+	startMatch(a, b);
+	seedMatch(seed);
+	setupMatch();
+	myPlayer = p1;
+
+	memset(&input, 0, sizeof(INPUT_FRAME));
+	input.beats = 1;
+	for (t = 0; t < SIDE_TICKS && game.result == SIM_RUNNING; t++) {
+		input.keys[0] = hostKeys(seed, HOST_CALC, t);
+		input.keys[1] = hostKeys(seed, JOIN_CALC, t);
+		sim_step(&game, &input);
+	}
+	reportMatch("lock", 1, report);
+}
+
+// One calculator's match, reported into report as a line
+static void playSide(unsigned char side, int in, int out, unsigned int drop, unsigned long seed, unsigned int a,
+	unsigned int b, char* report) {
+	INPUT_FRAME input;
+	unsigned int t, slot = (side == HOST_CALC) ? 0 : 1;
+	int ok = 1;
+
+	startMatch(a, b);
+	calc = side;
+	hostLinkOpen(in, out, seed * 2 + side);
+	if (side == HOST_CALC) {
+		seedMatch(seed); // (the joining side gets the seed over the link)
+	}
+
+	if (!startLink(&game)) {
+		exit(2);
+	}
+	setupMatch();
+	hostLinkLose(drop);
+#ifdef SAME_CAMERA
+	myPlayer = p1;
+#else
+	myPlayer = (side == JOIN_CALC) ? p2 : p1;
+#endif
+
+	memset(&input, 0, sizeof(INPUT_FRAME));
+	for (t = 0; t < SIDE_TICKS && game.result == SIM_RUNNING; t++) {
+		input.keys[slot] = hostKeys(seed, side, t);
+		if (!linkStep(&game, &input)) {
+			ok = 0;
+			break;
+		}
+	}
+	stopLink();
+	reportMatch((side == HOST_CALC) ? "host" : "join", ok, report);
+}
+
+// Whether two reports match after their names, up to the fields'th '|' (or all of the way with 0)
+static int sameReport(const char* first, const char* second, int fields) {
+	const char* end;
+	int field;
+
+	first = strchr(first, ' ');
+	second = strchr(second, ' ');
+	for (end = first, field = 0; field < fields && end != NULL; field++) {
+		end = strchr(end + 1, '|');
+	}
+	if (first == NULL || second == NULL || end == NULL) {
+		return 0;
+	}
+	return !strncmp(first, second, fields ? end - first : strlen(first) + 1);
+}
+
+int main(int argc, char** argv) {
+	unsigned int drop = (argc > 1) ? atoi(argv[1]) : 4;
+	unsigned long seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+	unsigned int a = (argc > 3) ? atoi(argv[3]) % NUM_CHARS : 0, b = (argc > 4) ? atoi(argv[4]) % NUM_CHARS : 7;
+	int toJoin[2], toHost[2], reports[2][2], status, failed = 0;
+	char lines[3][REPORT_SIZE];
+	unsigned char side;
+	pid_t pid;
+
+	playLockstep(seed, a, b, lines[LOCKSTEP]);
+	fputs(lines[LOCKSTEP], stdout);
+	fflush(stdout); // (before forking, or both sides print it again)
+
+	if (pipe(toJoin) || pipe(toHost)) {
+		return 2;
+	}
+	for (side = HOST_CALC; side <= JOIN_CALC; side++) {
+		if (pipe(reports[side]) || (pid = fork()) < 0) {
+			return 2;
+		}
+		if (!pid) {
+			playSide(side, (side == HOST_CALC) ? toHost[0] : toJoin[0], (side == HOST_CALC) ? toJoin[1] : toHost[1], drop,
+				seed, a, b, lines[side]);
+			write(reports[side][1], lines[side], strlen(lines[side]) + 1);
+			exit(0);
+		}
+		close(reports[side][1]);
+	}
+
+	for (side = HOST_CALC; side <= JOIN_CALC; side++) {
+		memset(lines[side], 0, REPORT_SIZE);
+		if (read(reports[side][0], lines[side], REPORT_SIZE - 1) <= 0) {
+			strcpy(lines[side], "(no report)\n");
+		}
+		fputs(lines[side], stdout);
+	}
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+			failed = 2;
+		}
+	}
+	if (failed || strstr(lines[HOST_CALC], "(link lost)") || strstr(lines[JOIN_CALC], "(link lost)")) {
+		return 2;
+	}
+
+	if (!sameReport(lines[HOST_CALC], lines[LOCKSTEP], 0)) {
+		fputs("the host ended a different match from lockstep\n", stdout);
+		return 1;
+	}
+#ifdef SAME_CAMERA
+	if (!sameReport(lines[JOIN_CALC], lines[HOST_CALC], 0)) {
+#else
+	if (!sameReport(lines[JOIN_CALC], lines[HOST_CALC], 1)) {
+#endif
+		fputs("the two sides ended different matches\n", stdout);
+		return 1;
+	}
+	return 0;
+}
+
+// End of Source File
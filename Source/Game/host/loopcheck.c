@@ -0,0 +1,169 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - loopcheck.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Plays a match on a PC through Link.c built with LOOPBACK - the delay line that hands every packet back late and
+// loses some of them, so p2 is always guessed at and rolled back over - and checks that it ends up exactly where the
+// same match played in lockstep does:
+//     loopcheck [ticks] [seed] [character a] [character b]
+// p1's keys are made up from the seed and p2 gets the same keys on the same tick, which is what loopback sends it.
+// They are held for the last LOOP_SETTLE ticks, so every guess has been confirmed by the end. Both runs are forked
+// off one process (so the pointers in their snapshots match too) and their matchState snapshots are compared byte
+// for byte. Exits 1 if they differ, 2 if the loopback run gave up on the link.
+//
+// The delay line only moves when a packet is sent, and while Link.c waits it only resends once a clock beat, so a
+// timer signal stands in for the calculator's timer interrupt here.
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "hostsim.h"
+
+#undef int // (main and the pipe get the PC's int)
+
+#define LOOP_SETTLE 32   // well past Link.c's window and the delay line's latency
+#define LOOP_BEAT   2000 // microseconds a clock beat (faster than the calculator's - nothing here waits on the clock)
+
+static unsigned long ticks, seed;
+static unsigned int a, b;
+
+// p1's keys on tick t (and p2's, as loopback hands p1's to it)
+static unsigned int loopKeys(unsigned long t) {
+	return hostKeys(seed, 0, (t + LOOP_SETTLE < ticks) ? t : ticks - LOOP_SETTLE);
+}
+
+// The timer interrupt
+static void beat(int signal) {
+	game.beatCounter++;
+}
+
+// Sets up a timed match between two humans: a linked one on a host that has nobody on the other end
+static void startMatch(void) {
+	hostSettings(a, b, TIMED);
+	linked = TRUE;
+	calc = HOST_CALC;
+	freeItemList(&head);
+	memset(&game, 0, sizeof(GAME_STATE));
+	seedMatch(seed);
+}
+
+// Plays the match through the link code; returns its snapshot, of size bytes
+static char* playLoopback(unsigned int* size) {
+	INPUT_FRAME input;
+	unsigned long t;
+	struct itimerval clock = {{0, LOOP_BEAT}, {0, LOOP_BEAT}};
+	char* snapshot;
+
+	signal(SIGALRM, beat);
+	setitimer(ITIMER_REAL, &clock, NULL);
+	startMatch();
+	if (!startLink(&game)) {
+		exit(2);
+	}
+	setupMatch();
+	myPlayer = p1;
+
+	memset(&input, 0, sizeof(INPUT_FRAME));
+	for (t = 0; t < ticks && game.result == SIM_RUNNING; t++) {
+		input.keys[0] = loopKeys(t);
+		if (!linkStep(&game, &input)) {
+			exit(2);
+		}
+	}
+	*size = matchState(NULL, STATE_SIZE);
+	if ((snapshot = malloc(*size)) == NULL) {
+		exit(2);
+	}
+	matchState(snapshot, STATE_SAVE);
+	printf("loopback ticks %u result %d hash %08lx\n", (unsigned)game.ticks, (int)game.result, stateHash());
+	stopLink();
+	return snapshot;
+}
+
+// Plays the match with both players' keys going into every tick; returns its snapshot, of size bytes
+static char* playLockstep(unsigned int* size) {
+	INPUT_FRAME input;
+	unsigned long t;
+	char* snapshot;
+
+	startMatch();
+	setupMatch();
+	myPlayer = p1;
+
+	memset(&input, 0, sizeof(INPUT_FRAME));
+	input.beats = 1;
+	for (t = 0; t < ticks && game.result == SIM_RUNNING; t++) {
+		input.keys[0] = input.keys[1] = loopKeys(t);
+		sim_step(&game, &input);
+	}
+	*size = matchState(NULL, STATE_SIZE);
+	if ((snapshot = malloc(*size)) == NULL) {
+		exit(2);
+	}
+	matchState(snapshot, STATE_SAVE);
+	printf("lockstep ticks %u result %d hash %08lx\n", (unsigned)game.ticks, (int)game.result, stateHash());
+	return snapshot;
+}
+
+int main(int argc, char** argv) {
+	unsigned int loopSize = 0, lockSize, i;
+	char *loop, *lock;
+	int results[2], status;
+	ssize_t got;
+	pid_t pid;
+
+	ticks = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000;
+	seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+	a = (argc > 3) ? atoi(argv[3]) % NUM_CHARS : 0;
+	b = (argc > 4) ? atoi(argv[4]) % NUM_CHARS : 7;
+	if (ticks < LOOP_SETTLE) {
+		ticks = LOOP_SETTLE;
+	}
+
+	hostInit();
+	if (pipe(results) || (pid = fork()) < 0) {
+		return 2;
+	}
+	if (!pid) {
+		loop = playLoopback(&loopSize);
+		fflush(stdout);
+		if (write(results[1], &loopSize, sizeof(loopSize)) != sizeof(loopSize) || write(results[1], loop, loopSize) != loopSize) {
+			exit(2);
+		}
+		exit(0);
+	}
+	close(results[1]);
+
+	if (read(results[0], &loopSize, sizeof(loopSize)) != sizeof(loopSize) || (loop = malloc(loopSize)) == NULL) {
+		return 2;
+	}
+	for (i = 0; i < loopSize; i += got) {
+		if ((got = read(results[0], loop + i, loopSize - i)) <= 0) {
+			return 2;
+		}
+	}
+	if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+		return 2;
+	}
+
+	lock = playLockstep(&lockSize);
+	if (lockSize != loopSize) {
+		printf("the snapshots are %u and %u bytes\n", loopSize, lockSize);
+		return 1;
+	}
+	for (i = 0; i < lockSize; i++) {
+		if (loop[i] != lock[i]) {
+			printf("the snapshots differ from byte %u of %u\n", i, lockSize);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// End of Source File
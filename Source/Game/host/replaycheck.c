@@ -0,0 +1,97 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - replaycheck.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Records a match on a PC through Replay.c (p1 with keys made up from the seed, against a CPU) and plays it back:
+//     replaycheck [ticks] [seed] [character a] [character b]
+// The whole replay has to play every tick out again and end where the match did. Then the replay is cut down to
+// half of its key runs, still claiming every tick in its header, as a damaged one could: playback has to stop
+// where the runs do, not read on past them. Exits 1 if either goes wrong.
+
+#include <stdio.h>
+#include "hostsim.h"
+
+#undef int // (main gets the PC's int)
+
+// Plays the replay in tlreplay from the start; returns how many ticks it gave
+static unsigned long playBack(void) {
+	INPUT_FRAME input;
+	unsigned long t = 0;
+
+	if (!startPlayback()) {
+		return 0;
+	}
+	freeItemList(&head);
+	memset(&game, 0, sizeof(GAME_STATE));
+	setupMatch();
+	myPlayer = p1;
+	while (replayInput(&input)) {
+		sim_step(&game, &input);
+		t++;
+	}
+	stopPlayback();
+	return t;
+}
+
+int main(int argc, char** argv) {
+	INPUT_FRAME input;
+	REPLAY_HEADER header;
+	KEY_RUN runs[768];
+	unsigned long ticks = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1500, t, kept = 0, played;
+	unsigned long seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1, recorded;
+	unsigned int a = (argc > 3) ? atoi(argv[3]) % NUM_CHARS : 0, b = (argc > 4) ? atoi(argv[4]) % NUM_CHARS : 7, i;
+	FILE* file;
+
+	hostInit();
+	hostSettings(a, b, STOCK);
+	freeItemList(&head);
+	memset(&game, 0, sizeof(GAME_STATE));
+	seedMatch(seed);
+	startRecording();
+	setupMatch();
+	myPlayer = p1;
+
+	memset(&input, 0, sizeof(INPUT_FRAME));
+	for (t = 0; t < ticks && game.result == SIM_RUNNING; t++) {
+		input.keys[0] = hostKeys(seed, 0, t);
+		input.beats = 1 + !(t % 7); // (a beat running ahead now and then, as the timer interrupt does)
+		recordInput(&input);
+		sim_step(&game, &input);
+	}
+	ticks = t;
+	recorded = stateHash();
+	stopRecording();
+
+	played = playBack();
+	printf("recorded %lu ticks hash %08lx, played back %lu ticks hash %08lx\n", ticks, recorded, played, stateHash());
+	if (played != ticks || stateHash() != recorded) {
+		return 1;
+	}
+
+	if ((file = fopen(REPLAY_FILENAME, "rb")) == NULL || fread(&header, sizeof(REPLAY_HEADER), 1, file) != 1
+		|| header.numKeyRuns > sizeof(runs) / sizeof(KEY_RUN) || fread(runs, sizeof(KEY_RUN), header.numKeyRuns, file) != header.numKeyRuns) {
+		return 1;
+	}
+	fclose(file);
+	header.numKeyRuns /= 2; // (and numTicks left as it was)
+	header.numBeatBytes = 0; // (the beats go as well)
+	for (i = 0; i < header.numKeyRuns; i++) {
+		kept += runs[i].ticks;
+	}
+	if ((file = fopen(REPLAY_FILENAME, "wb")) == NULL) {
+		return 1;
+	}
+	fwrite(&header, sizeof(REPLAY_HEADER), 1, file);
+	fwrite(runs, sizeof(KEY_RUN), header.numKeyRuns, file);
+	fclose(file);
+
+	played = playBack();
+	printf("cut to %u key runs of %lu ticks, played back %lu ticks\n", (unsigned)header.numKeyRuns, kept, played);
+	return played != kept;
+}
+
+// End of Source File
@@ -0,0 +1,36 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// C Source File - simrun.c
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// Plays a CPU match out on a PC and prints how it went and a hash of where it ended up:
+//     simrun [ticks] [seed] [character a] [character b]
+// The same arguments always print the same line, on any machine.
+
+#include <stdio.h>
+#include "hostsim.h"
+
+#undef int // (main gets the PC's int)
+
+int main(int argc, char** argv) {
+	INPUT_FRAME input;
+	unsigned long ticks = (argc > 1) ? strtoul(argv[1], NULL, 10) : 2000, i;
+	unsigned long seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+	unsigned int a = (argc > 3) ? atoi(argv[3]) : 0, b = (argc > 4) ? atoi(argv[4]) : 7;
+	
+	memset(&input, 0, sizeof(INPUT_FRAME)); // nobody is pressing keys - both players are CPUs
+	input.beats = 1;
+	
+	hostInit();
+	hostMatch(seed, a % NUM_CHARS, b % NUM_CHARS, STOCK);
+	for (i = 0; i < ticks && sim_step(&game, &input) == SIM_RUNNING; i++);
+	
+	printf("ticks %lu result %d winner %d lives %d-%d damage %u-%u hash %08lx\n", i, (int)game.result, (int)game.winner,
+		(int)p1->numLives, (int)p2->numLives, (unsigned)p1->percent, (unsigned)p2->percent, stateHash());
+	return 0;
+}
+
+// End of Source File
@@ -0,0 +1,68 @@
+// Twilight Legion for TI-89(Titanium), TI-92(+), Voyage 200
+// Header File - platform.h
+// Michael Hergenrader
+// Compiled with TIGCC 0.96 Beta 8
+// Please see README for license/disclaimer information. In short, please feel free to use code you see here,
+// and any credit to me would be greatly appreciated! :-)
+// Copyright 2005-2010 Michael Hergenrader
+
+// What the match simulation (Sim.c and the files it calls into) and Link.c take from the calculator. On the calculator
+// that is just tigcclib; with HOST_BUILD defined it is the handful of TIGCC types and constants below instead, so they
+// build and run on a PC as well (see host/Makefile). BOOL and int stay 16 bits there, so positions,
+// speeds and damage wrap and truncate exactly as they do on the calculator and a match plays out the same on both.
+// Longs may come out wider on the PC; the random number generators mask their state back to 32 bits.
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifndef HOST_BUILD
+
+#include <tigcclib.h>
+
+#else
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define int short // TIGCC's int is 16 bits
+
+typedef short BOOL;
+#define TRUE  1
+#define FALSE 0
+
+typedef void atexit_t;
+typedef void (*INT_HANDLER)(void);
+typedef unsigned short HANDLE;
+#define H_NULL 0
+
+#define LCD_SIZE 3840
+
+typedef struct { // TileMap's plane (only its layout matters off the calculator)
+	void* matrix;
+	unsigned short width;
+	void* sprites;
+	void* big_vscreen;
+	long mat_x, mat_y;
+	short force_update;
+} Plane;
+#define GRAY_BIG_VSCREEN_SIZE 5440
+
+#define OTH_TAG 0xF8 // (what the variables' type tag is on the calculator)
+
+#define _keytest(__key) FALSE // no keyboard: the programs in host/ script their players' keys
+#define RR_ESC 0
+
+short OSWriteLinkBlock(const char* buffer, unsigned short num); // the link cable, which host/hostlink.c stands in for
+unsigned short OSReadLinkBlock(char* buffer, unsigned short num);
+void OSLinkReset(void);
+
+#define min(a,b) ((a) < (b) ? (a) : (b))
+#define max(a,b) ((a) > (b) ? (a) : (b))
+
+#endif
+
+// End of Header File
+
+#endif
@@ -26,12 +26,6 @@ const unsigned int charSpecialAttacks[24] = {
 	0,  1,  0,  0,  2,  0,  2,  0,  0,  0,  2,  1,  2,  2,  0,  0,  1,  2,  2,  1,  0,  2,  0,  2
 };
 
-// The sprite pointer offsets in the external data file (one array used for all three data files),
-// hence the reset to zero twice in this array.
-const int offset[24] = {
-	0, 1794, 3588, 5796, 7728, 9660, 11799, 13524,   0, 2208, 4416, 5934, 7383, 9039, 10419, 12213,   0, 1242, 2760, 4554, 6141, 7659, 9384, 10902
-};
-
 // The franchise/"team" backgrounds that belong to each charcter (see huddata.h)
 const unsigned int hudIndexes[24] = {
 	10, 10, 5, 1, 5, 10, 2, 2, 7, 9, 8, 7, 5, 5, 6, 8, 3, 5, 6, 4, 11, 5, 0, 7
@@ -12,70 +12,20 @@
 #ifndef STRUCTURES_H
 #define STRUCTURES_H
 
+#include "platform.h"
+#ifndef HOST_BUILD
 #include "TileMap.h"
+#endif
 
 #define NUM_CHARS           24
 #define NUM_STAGES          26
 #define NUM_EPISODES        31 // "Episode Mode"
 #define NUM_INVITATIONALS   10 // "Tournament Mode"
+#define BRACKET_ROUNDS       4 // 16 entrants to a tournament (5 and 6 make 32- and 64-entrant brackets)
+#define BRACKET_ENTRANTS    (1 << BRACKET_ROUNDS)
+#define BRACKET_NODES       (BRACKET_ENTRANTS * 2 - 1)
 #define NUM_FRAMES          23 // total animation frames per playable character
 
-typedef enum {
-	ARENA_MODE,
-	STORY_MODE,
-	EPISODE_MODE,
-	TOURNAMENT_MODE,
-	NONE_SELECTED
-} GAME_MODE; // All game modes ("Story" mode = "Classic" mode from Super Smash Bros)
-
-typedef enum {
-	CROWD_PRESSURE_SETT,
-	MATCH_TYPE_SETT,
-	MATCH_MINUTES_SETT,
-	MATCH_LIVES_SETT,
-	AI_DIFFICULTY_SETT,
-	ITEM_PROBABILITY_SETT,
-	STAGE_SELECT_SETT
-} SETTINGS_TYPE; // Different types of settings in the game
-
-typedef enum {
-	HEIGHT = 100,
-	WIDTH = 160
-} SCREENDIMEN; // currently only for TI-89 dimensions
-
-typedef enum {
-	SMALL_MAPH = 7,
-	SMALL_MAPW = 10,
-	MED_MAPH = 8,
-	MED_MAPW = 14,
-	BIG_MAPH = 9,
-	BIG_MAPW = 18
-} MAPDIMEN; // sizes of each level size (small, medium, large)
-
-typedef enum {
-	HUMAN,
-	CPU
-} PLAYERTYPE; // whether character controlled by human or AI
-
-typedef enum {
-	LEFT = -1,
-	RIGHT = 1
-} DIRECTION; // directions for the player/everything else
-
-typedef enum {
-	UP = -1,
-	DOWN = 1
-} VERT_DIRECTION;
-
-typedef enum {
-	WHITE_TEAM = 1,
-	LIGHTGRAY_TEAM,
-	DARKGRAY_TEAM,
-	BLACK_TEAM
-} TEAM;
-
-
-
 typedef enum {
 	ARENA_MODE,
 	STORY_MODE,
@@ -327,6 +277,30 @@ typedef enum {
 	INITIALS
 } PROFILE_ENTRY;
 
+typedef enum {
+	SIM_RUNNING,
+	SIM_SUDDEN_DEATH, // timed match ended in a tie: the leaders go on to sudden death
+	SIM_TIME_UP,
+	SIM_GAME_SET,
+	SIM_SUDDEN_DEATH_SET,
+	SIM_HANDS_DEFEATED,
+	SIM_EPISODE_OVER
+} SIM_RESULT; // what happened during a simulation step (anything but SIM_RUNNING ends the match loop or changes its phase)
+
+typedef enum {
+	RNG_ITEMS, // item drops and where they land
+	RNG_AI, // CPU and boss decisions
+	RNG_COMBAT, // damage, knockback, tie breaks between hits and grabs
+	RNG_MENUS, // menus and match setup - also draws the seed of every new match
+	NUM_RNG_STREAMS
+} RNG_STREAM; // independent random number generators, so one subsystem's draws never shift another's
+
+typedef enum {
+	STATE_SIZE, // only count the bytes
+	STATE_SAVE,
+	STATE_LOAD
+} STATE_TRANSFER; // direction of a match snapshot copy (see matchState)
+
 
 typedef struct item { // item structure
 	int x;
@@ -334,10 +308,13 @@ typedef struct item { // item structure
 	int h;
 	BOOL beingHeld;
 	BOOL beenUsed;
+	unsigned int fall; // falling speed in 256ths of a pixel a tick, down (see dropItem)
+	unsigned int frac; // the fraction of a pixel it has fallen past its y
 	unsigned int replenish;
 	unsigned int index;
 	const void *data;
 	struct item* next; // for use in the linked lists (all items in a level stored in a linked list for quick appends)
+	struct item* nextInBucket; // next item in the same spatial bucket (see Items.c)
 } ITEM;
 
 typedef struct timer {
@@ -358,6 +335,8 @@ typedef struct proj {
 	int dir;
 	unsigned int distance;
 	unsigned int e; // counter for explosions
+	unsigned int owner; // slot of the player who fired it
+	BOOL flying; // a pool slot is free once it is neither flying nor exploding
 	BOOL exploding;
 	const void* data;
 } PROJECTILE;
@@ -366,8 +345,7 @@ typedef struct character { // stores character attributes for all 30 available (
 	int w;
 	int h; // physical attributes
 	unsigned int specialType; // type of special attack
-	FRAME frames[NUM_FRAMES];
-} CHARACTER;
+} CHARACTER; // animation frames live in a per-match cache instead (see residentFrames)
 
 typedef struct linkstruct {
 	int x;
@@ -377,6 +355,7 @@ typedef struct linkstruct {
 	int moveSpeed;
 	int xspeed;
 	int yspeed;
+	unsigned int frac;
 	
 	unsigned int numLives;
 	unsigned int power;
@@ -384,92 +363,101 @@ typedef struct linkstruct {
 	unsigned int characterIndex;
 	unsigned int percent;
 	unsigned int numJumps;
+	unsigned int shots; // goes with canFire below, so a corrected player can fire again once their shots land
 	
-	BOOL breathing; // these basically correspond to every sense of animation - could use a bit array also
-	BOOL running;
-	BOOL taunting;
-	BOOL falling;
-	BOOL climbing;
-	BOOL crouching;
-	BOOL hanging;
-	BOOL smashAttacking;
-	BOOL specialAttacking;
-	BOOL skyAttacking;
-	BOOL beingHeld;
-	BOOL grabbing;
-	BOOL invincible;
-	BOOL dead;
-	BOOL paralyzed;
-	BOOL onStage;
-	BOOL onHillL;
-	BOOL onHillR;
-	BOOL canFire;
-	BOOL cloaked;
-	BOOL metal;
+	unsigned int breathing:1; // status flags, packed into one bitfield word (same names and meanings as in PLAYER)
+	unsigned int running:1;
+	unsigned int taunting:1;
+	unsigned int falling:1;
+	unsigned int climbing:1;
+	unsigned int crouching:1;
+	unsigned int hanging:1;
+	unsigned int smashAttacking:1;
+	unsigned int specialAttacking:1;
+	unsigned int skyAttacking:1;
+	unsigned int beingHeld:1;
+	unsigned int grabbing:1;
+	unsigned int invincible:1;
+	unsigned int dead:1;
+	unsigned int paralyzed:1;
+	unsigned int onStage:1;
+	unsigned int onHillL:1;
+	unsigned int onHillR:1;
+	unsigned int canFire:1;
+	unsigned int cloaked:1;
+	unsigned int metal:1;
 	
 	DIRECTION direction;
 	TEAM team;
 	PLAYERTYPE type;
 	
 	unsigned int enemyIndex;
-} LINK_STRUCT; // in-game structure sent across the link cable; has many similar fields but with fewer pointers to save space in transit
+} LINK_STRUCT; // one player as the link host samples it (see Link.c): most of the PLAYER fields, x and y in stage coordinates
 
 typedef struct player {
-	int x;
+	int x; // position, speed and damage are read by every per-tick pass, so they lead the structure
 	int y;
+	int xspeed; // knockback speeds, in 8.8 fixed point
+	int yspeed;
+	unsigned int percent;
+	unsigned int frac; // what is left over of a pixel while flying: x in the high byte, y in the low (see Physics.c)
+	
 	int jumpValue;
 	int numKills;
 	int numTimesKilled;
 	int moveSpeed;
-	int xspeed;
-	int yspeed;
 	
 	unsigned int numLives;	
 	unsigned int power;
 	unsigned int size;	
 	unsigned int characterIndex;
-	unsigned int percent;
 	unsigned int numJumps;
 	unsigned int playerCounter;
 	unsigned int attackMarker;
+	unsigned int shots; // projectiles of this player's still flying (canFire is cleared at SHOTS_PER_PLAYER)
 	
 	unsigned int pointsHolder[3]; // points for which player to attack (each player receives a system of points from criteria to determine whom to attack)
 	
-	BOOL breathing; // these basically correspond to every sense of animation - could use a bit array
-	BOOL running;
-	BOOL taunting;
-	BOOL falling;
-	BOOL climbing;
-	BOOL crouching;
-	BOOL hanging;
-	BOOL smashAttacking;
-	BOOL specialAttacking;
-	BOOL skyAttacking;
-	BOOL beingHeld;
-	BOOL grabbing;
-	BOOL invincible;
-	BOOL dead;
-	BOOL paralyzed;
-	BOOL onStage;
-	BOOL onHillL;
-	BOOL onHillR;
-	BOOL canFire;
-	BOOL cloaked;
-	BOOL metal;
+	unsigned int breathing:1; // status flags for every sense of animation, packed into one bitfield word
+	unsigned int running:1;
+	unsigned int taunting:1;
+	unsigned int falling:1;
+	unsigned int climbing:1;
+	unsigned int crouching:1;
+	unsigned int hanging:1;
+	unsigned int smashAttacking:1;
+	unsigned int specialAttacking:1;
+	unsigned int skyAttacking:1;
+	unsigned int beingHeld:1;
+	unsigned int grabbing:1;
+	unsigned int invincible:1;
+	unsigned int dead:1;
+	unsigned int paralyzed:1;
+	unsigned int onStage:1;
+	unsigned int onHillL:1;
+	unsigned int onHillR:1;
+	unsigned int canFire:1;
+	unsigned int cloaked:1;
+	unsigned int metal:1;
 	
 	DIRECTION direction;
 	TEAM team;
 	PLAYERTYPE type;
 
 	ITEM* currentItem;
-	PROJECTILE* myProjectile;
 	FRAME* rightCurrent;
 	FRAME* leftCurrent;
+	FRAME* frames; // all NUM_FRAMES frames of this player's character, resident for the match
 
 	struct player* enemy; // scanned enemy is assigned here - even for human players (who players target)
 	struct player* next;  // keeps the linked list of player structures
 } PLAYER; // human and AI ingame player structure
 
+typedef struct {
+	PLAYER* attacker;
+	PLAYER* target;
+} HIT_EVENT; // a strike settled by checkForPlayerCollisions, landed once every pair has been settled
+
 typedef struct hand {
 	int x;
 	int y;
@@ -495,6 +483,36 @@ typedef struct stage {
 	BOOL movingLevel;
 } STAGE;
 
+// Episode rules: checked in order every tick of the episode, each one runs its action when its trigger holds.
+// A RULE_END trigger ends the list.
+#define MAX_EPISODE_RULES   6
+
+#define RULE_END            0
+#define RULE_TICKS_PAST     1 // ticks > value
+#define RULE_EVERY_TICKS    2 // (ticks & value) == 0
+#define RULE_OPPONENT_DOWN  3 // runs the action on every opponent that is out
+#define RULE_DEFEATED       4 // enemies defeated == value
+#define RULE_DEFEATED_PAST  5 // enemies defeated > value
+
+#define DO_END_EPISODE      0
+#define DO_WIN_EPISODE      1
+#define DO_TOGGLE_CLOAK     2
+#define DO_RESPAWN          3 // bring the opponent back (as character arg) and count it defeated
+#define DO_SWAP_OPPONENT    4 // p2 becomes character arg
+
+#define SAME_CHARACTER      0xFF
+
+#define COUNTER_NONE        0 // episode counter shown in the corner
+#define COUNTER_TICKS       1
+#define COUNTER_ENEMIES_LEFT 2 // counts down to the RULE_DEFEATED_PAST rule
+
+typedef struct episoderule {
+	unsigned char trigger;
+	unsigned char action;
+	unsigned char arg; // character for DO_RESPAWN and DO_SWAP_OPPONENT
+	unsigned short value; // depends on the trigger
+} EPISODE_RULE;
+
 typedef struct episode {
 	unsigned int p1numLives;
 	unsigned int p2numLives;
@@ -508,6 +526,9 @@ typedef struct episode {
 	unsigned int p4Index;	
 	unsigned int levelIndex;
 	int difficultyLevel;
+	
+	EPISODE_RULE rules[MAX_EPISODE_RULES]; // objectives beyond winning the fight
+	unsigned int counter;
 } EPISODE; // for "Episode Mode": each episode has a custom definition/objective
 
 typedef struct invitational {
@@ -541,9 +562,61 @@ typedef struct movingcursor {
 	int direction;
 } MOVING_CURSOR;
 
+typedef struct inputframe {
+	unsigned int keys[4]; // one INPUT_* bitmask per player slot (p1-p4); ignored for CPU players
+	unsigned int beats; // clock beats (timer interrupts) since the last tick, run by the step
+} INPUT_FRAME; // everything a human can do during one game tick, sampled before the step instead of polled inside it
+
+typedef struct gamestate {
+	unsigned int ticks; // steps taken this match (announcements, moving levels and episode timers run off this)
+	volatile unsigned int itemCounter; // item drop cadence, advanced with the clock
+	volatile unsigned int pendingItem; // item index + 1 picked by the clock, dropped in by the next step (0 = none)
+	volatile unsigned int beatCounter; // counted by the timer interrupt; readInput hands the new beats to the step
+	unsigned int enemiesDefeated; // for the endless/gauntlet episodes
+	unsigned int episode;
+	const EPISODE_RULE* rules; // the episode's rule table (episode mode only)
+	SIM_RESULT result;
+	TEAM winner; // valid once a step reports a finished match
+} GAME_STATE; // per-match state advanced by sim_step()
+
+typedef struct keyrun {
+	unsigned short keys; // p1's INPUT_* bits
+	unsigned short ticks; // for this many ticks in a row
+} KEY_RUN;
+
+typedef struct replayheader {
+	unsigned long magic;
+	unsigned short version;
+	unsigned short numKeyRuns;
+	unsigned short numBeatBytes;
+	unsigned short numTicks;
+	unsigned long seed; // the generator is seeded with this just before the match is set up
+	
+	unsigned char stageIndex; // everything setupMatch() reads for an Arena match
+	unsigned char numPlayers;
+	unsigned char characters[4];
+	unsigned char teams[4];
+	unsigned char difficulty;
+	unsigned char matchType;
+	unsigned char matchMinutes;
+	unsigned char matchLives;
+	unsigned char crowdPressure;
+	unsigned char itemProb;
+} REPLAY_HEADER; // tlreplay: this header, then numKeyRuns KEY_RUNs, then numBeatBytes of clock beats
+
+typedef struct batchtally {
+	unsigned int matches;
+	unsigned int wins[2]; // by character a and b, whichever side they played on
+	unsigned int draws;
+	unsigned long ticks;
+	unsigned int kills[2];
+} BATCH_TALLY; // one matchup's results in a balance sweep (see Batch.c)
+
 
 // Saved file data
 
+// A profile is saved a section at a time (see saveCurrentProfile), so the fields of each section must stay together
+// and in this order: record, settings, tournament, story, unlocks
 typedef struct profile {
 	unsigned char name[9];
 	unsigned char initials[4];
@@ -556,9 +629,7 @@ typedef struct profile {
 	unsigned int numSuddenDeathWins;
 	unsigned int numSuddenDeathLosses;
 	
-	// Settings for both Tournament and General (interweaved)	
-	INVITATIONAL_ID invitationalID;	
-	
+	// Settings for both Tournament and General (interweaved)
 	// can set these as chars? (still unsigned or signed)
 	int difficulty;
 	int tDifficulty;
@@ -576,27 +647,15 @@ typedef struct profile {
 	unsigned int tMatchLives;
 	unsigned int itemProb;
 	unsigned int tItemProb;
+	
+	// Tournament in progress
+	INVITATIONAL_ID invitationalID;
 	unsigned int roundNum;
 	unsigned int savedStage;
-	
 	BOOL iHaveTournament; // current tournament exists
-	BOOL iHaveBattle;
-		
-	char tourBracketLayout[35][13]; // all the current players in the tournament
-	int characterIndexes[16]; // saves what players are still alive in the tournament
-	
-	// Quicksave Battle Stuff	- Arena mode only, non-linked
-	char savedMinutes;
-	char savedSeconds;
-	char savedMilliseconds;
-	int savedXBG;
-	int savedXFG;
-	int savedYBG;
-	int savedYFG;	
-	unsigned char savedBackground;
-	unsigned char savedNumPlayers;
-	unsigned int savedStageIndex;
-	PLAYER savedPlayers[4];
+	BOOL tQuickCPU; // this tournament's CPU-only matches are played out headless instead of watched
+	signed char tourBracket[BRACKET_NODES]; // as a tree: node 0 is the champion, node n's fighters are nodes 2n+1 and 2n+2 and the
+	                                        // entrants are the last BRACKET_ENTRANTS (a character index, or NONE until decided)
 	
 	// Story Mode arrays - rename them to story mode
 	int classicCharacterDifficultiesDone[NUM_CHARS]; // highest difficulty a player has completed - print out as a string - make this a char value
@@ -613,6 +672,36 @@ typedef struct profile {
 
 // External data file structures
 
+// Every data file is an asset pack: a header, then a table of contents, then the chunks it lists. Chunks are found
+// by ID, never by position, and each one carries a checksum, so a file left over from another version of the game
+// is refused at startup instead of being read as the wrong structure. Offsets are from the start of the header.
+
+#define PACK_MAGIC    0x544C504BUL // "TLPK"
+#define PACK_VERSION  3 // bump whenever a chunk's structure changes (2: no bracket layout in EXTRA_EXTERNAL, 3: episodes
+                        // hold their EPISODE_RULE tables)
+
+#define CHUNK_ID(__a,__b,__c,__d) (((unsigned long)(__a) << 24) | ((unsigned long)(__b) << 16) | ((__c) << 8) | (__d))
+#define CHUNK_STAGES         CHUNK_ID('S','T','G','E') // tl_stage: EXTERNAL
+#define CHUNK_SPRITES        CHUNK_ID('S','P','R','T') // tl_charx: character frame sprites
+#define CHUNK_FRAME_OFFSETS  CHUNK_ID('F','O','F','S') // tl_charx: where each character's frames start in SPRT
+#define CHUNK_EXTRA          CHUNK_ID('E','X','T','R') // tl_extra: EXTRA_EXTERNAL
+
+#define CHARS_PER_FILE  8 // characters stored in each tl_charx file
+
+typedef struct packchunk {
+	unsigned long id;
+	unsigned short offset;
+	unsigned short length;
+	unsigned short checksum;
+} PACK_CHUNK;
+
+typedef struct packheader {
+	unsigned long magic;
+	unsigned short version;
+	unsigned short numChunks;
+	PACK_CHUNK toc[];
+} PACK_HEADER;
+
 typedef struct stageexternal { // tl_stage.data
 	char antairavillage[8][18];
 	char battlefield[8][12];
@@ -695,7 +784,6 @@ typedef struct ext { // tl_extra.data
 	unsigned short banner[96];
 	
 	short tournamentTiles[31][32];	
-	char bracketLayout[35][13];
 	
 	EPISODE episodes[31];
 	INVITATIONAL invitationalList[10];